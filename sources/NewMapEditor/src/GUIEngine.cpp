@@ -7,6 +7,7 @@
 #include "Flag.hpp"
 #include "Capture.hpp"
 
+#include <atomic>
 #include "Map.hpp"
 #include "Event.hpp"
 
@@ -16,7 +17,7 @@
 // Globals
 extern t_config *_conf;
 extern std::string g_ip;
-extern int G_id;
+extern std::atomic<int> G_id;
 extern bool G_isMapLoaded;
 
 GUIEngine::GUIEngine()
@@ -407,7 +408,7 @@ eGameState GUIEngine::update(const sf::Time &deltaTime, bool firtPass)
 
 	CEGUI::Listbox *box = static_cast<CEGUI::Listbox *>(myRoot->getChildRecursive("MapItems"));
 
-	std::list<std::pair<eventType, s_event>> *objectToCreate = Event::getEventByType(ev_OBJECT_CREATION);
+	t_eventList *objectToCreate = Event::getEventByType(ev_OBJECT_CREATION);
 	const sf::Vector2i &mouse(HudRessources::getInstance()->getMousePosition());
 	float aimX = 0; float aimY = 0;
 	screenToWorld(mouse.x, mouse.y, aimX, aimY);
@@ -464,7 +465,7 @@ eGameState GUIEngine::update(const sf::Time &deltaTime, bool firtPass)
 	//		);
 	//}
 
-	std::list<std::pair<eventType, s_event>> *objectCreated = Event::getEventByType(ev_OBJECT_CREATED);
+	t_eventList *objectCreated = Event::getEventByType(ev_OBJECT_CREATED);
 
 	if (objectCreated)
 	{
@@ -472,7 +473,7 @@ eGameState GUIEngine::update(const sf::Time &deltaTime, bool firtPass)
 		_objectCreated = NULL;
 	}
 
-	std::list<std::pair<eventType, s_event>> *list = Event::getEventByType(ev_OBJECT_DESELECTED);
+	t_eventList *list = Event::getEventByType(ev_OBJECT_DESELECTED);
 
 	if (list)
 	{
@@ -499,7 +500,7 @@ eGameState GUIEngine::update(const sf::Time &deltaTime, bool firtPass)
 			S_Map->findObjectWithID(box->getFirstSelectedItem()->getID())->setSelected(false);
 		}
 
-		std::list<std::pair<eventType, s_event>>::iterator it = list->begin();
+		t_eventList::iterator it = list->begin();
 
 		AObject *obj = it->second.trigger.get();
 		obj->setSelected(true);
@@ -68,7 +68,7 @@ void	Sender::sendMapChange(void)
 		return;
 
 	_packet.clear();
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_CHANGE_MAP)->begin();
 	const char *raw = (const char *)(it->second.data);
 	std::string	filename = raw;
@@ -87,7 +87,7 @@ void	Sender::sendModeChange(void)
 		return; 
 
 	_packet.clear();
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_SWITCH_MAP_MODE)->begin();
 	sf::Int16	raw = (sf::Int16)(it->second.data);
 	_packet << PACKET_REQUEST_CHANGE_MODE << raw;
@@ -102,7 +102,7 @@ void	Sender::sendHordeActivation(void)
 	if (Event::getEventByType(ev_HORDE_ACTIVATE) != NULL)
 	{
 		_packet.clear();
-		std::list<std::pair<eventType, s_event> >::const_iterator it =
+		t_eventList::const_iterator it =
 			Event::getEventByType(ev_HORDE_ACTIVATE)->begin();
 		sf::Uint32 id = (sf::Uint32)(it->second.data);
 		_packet << PACKET_REQUEST_HORDE_ACTIVATE;
@@ -115,7 +115,7 @@ void	Sender::sendHordeActivation(void)
 	if (Event::getEventByType(ev_HORDE_DESACTIVATE) != NULL)
 	{
 		_packet.clear();
-		std::list<std::pair<eventType, s_event> >::const_iterator it =
+		t_eventList::const_iterator it =
 			Event::getEventByType(ev_HORDE_DESACTIVATE)->begin();
 		sf::Uint32 id = (sf::Uint32)(it->second.data);
 		_packet << PACKET_REQUEST_HORDE_DESACTIVATE;
@@ -132,7 +132,7 @@ void	Sender::sendPlayerKick(void)
 		return;
 
 	_packet.clear();
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_PLAYER_KICK)->begin();
 	sf::Uint32 id = (sf::Uint32)(it->second.data);
 	_packet << PACKET_REQUEST_PLAYER_KICK << id;
@@ -154,7 +154,7 @@ void	Sender::sendInput(void)
 	_packet << PACKET_INPUT << timestamp;
 
 	// Get player input
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_PLAYER_ACTION)->begin();
 	_playerActions = (s_actions*)(it->second.data);
 	_packet << _playerActions;
@@ -259,7 +259,7 @@ void	Sender::sendEvents()
 	_packet << PACKET_WEAPON_SELECTION;
 
 	// Get player input
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_PLAYER_ACTION)->begin();
 	Player *player = dynamic_cast<Player *>((*it).second.trigger);
 	t_weapon	*primary = player->getWeapons(true, false);
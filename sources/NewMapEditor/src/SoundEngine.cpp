@@ -98,7 +98,7 @@ void	SoundEngine::start(void)
 
 eGameState	SoundEngine::update(const sf::Time &)
 {
-	std::list<std::pair<eventType, s_event> >::const_iterator it;
+	t_eventList::const_iterator it;
 
 	//CEGUI::Listbox *box = static_cast<CEGUI::Listbox *>(myRoot->getChildRecursive("KeysListbox"));
 	if (G_isMapEditor == false)
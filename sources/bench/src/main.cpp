@@ -0,0 +1,258 @@
+//
+// main.cpp for Void Clash
+//
+
+#include	<cstdlib>
+#include	<cmath>
+#include	<iostream>
+#include	<iomanip>
+#include	<algorithm>
+#include	<stdexcept>
+#include	<vector>
+#include	"main.hpp"
+#include	"Log.hpp"
+#include	"Map.hpp"
+#include	"Event.hpp"
+#include	"GameEngine.hpp"
+#include	"PhysicEngine.hpp"
+#include	"ConfigParser.hpp"
+#include	"Snapshot.hpp"
+#include	"ClientInterest.hpp"
+
+///////////////////////////////////////////////
+/////   Headless server tick benchmark
+/////	Runs the server simulation without sockets, as fast as possible
+/////	Usage (from Installer/Linux): ./bench_server [players] [bots] [ticks] [map]
+
+#define	BENCH_PLAYERS		16
+#define	BENCH_BOTS			16
+#define	BENCH_TICKS			2000
+#define	BENCH_ACK_DELAY		4		// in ticks - snapshot acked by the fake clients (delta base)
+
+extern t_config	*G_conf;
+extern bool		G_isServer;
+extern bool		G_isOffline;
+
+enum	eBenchPhase
+{
+	PHASE_INPUT,
+	PHASE_MAP,
+	PHASE_PHYSIC,
+	PHASE_GAME,
+	PHASE_SNAPSHOT,
+	PHASE_CLEANUP,
+	PHASE_COUNT
+};
+
+static const char	*phaseNames[PHASE_COUNT] =
+{
+	"input", "map update", "physics", "game", "snapshot build", "add / delete"
+};
+
+///////////////////////////////////////////////
+/////   Scripted player: moves in circle, aims at the map center, shoots
+
+static void	scriptActions(s_actions &actions, unsigned int index, unsigned int tick)
+{
+	float	angle = tick * 0.02f + index;
+
+	actions.moveX = static_cast<sf::Int16>(std::cos(angle) * 100);
+	actions.moveY = static_cast<sf::Int16>(std::sin(angle) * 100);
+	actions.aimX = std::cos(angle * 3.f);
+	actions.aimY = std::sin(angle * 3.f);
+	actions.primary = ((tick / 32 + index) % 2) == 0;
+	actions.secondary = ((tick + index * 7) % 200) < 4;
+}
+
+///////////////////////////////////////////////
+/////   Stats
+
+static sf::Int64	percentile(std::vector<sf::Int64> values, float p)
+{
+	if (values.empty())
+		return 0;
+	std::sort(values.begin(), values.end());
+	return values[static_cast<unsigned int>(p * (values.size() - 1))];
+}
+
+static sf::Int64	average(const std::vector<sf::Int64> &values)
+{
+	sf::Int64	total = 0;
+
+	for (unsigned int i = 0; i < values.size(); ++i)
+		total += values[i];
+	return values.empty() ? 0 : total / static_cast<sf::Int64>(values.size());
+}
+
+static void	printStats(const char *name, const std::vector<sf::Int64> &values)
+{
+	std::cout << std::left << std::setw(16) << name << std::right
+		<< std::setw(10) << average(values)
+		<< std::setw(10) << percentile(values, 0.5f)
+		<< std::setw(10) << percentile(values, 0.99f)
+		<< std::setw(10) << percentile(values, 1.f) << std::endl;
+}
+
+///////////////////////////////////////////////
+/////   Main
+
+static int	bench(unsigned int nbPlayers, unsigned int nbBots, unsigned int nbTicks, const char *map)
+{
+	S_Log->start(DEBUG_LEVEL, true);
+	Event::getMainEventList();
+
+	GameEngine		gameEngine;
+	PhysicEngine	physicEngine;
+	gameEngine.start();
+	physicEngine.start();
+	if (map)
+		S_Map->changeMap(map);
+	S_Map->addNewObjects();
+	S_Map->deleteObjects();
+	Event::clearEvents();
+
+	int	tickrate = G_conf->server->tickrate > 0 ? G_conf->server->tickrate : SERVER_TICKRATE;
+	S_Map->setFixedTimestep(sf::microseconds(1000000 / tickrate));
+
+	// Fake clients, same setup as a ClientHandle joining then picking a team
+	std::vector<std::shared_ptr<Player> >	players;
+	std::vector<s_actions>					actions(nbPlayers);
+	for (unsigned int i = 0; i < nbPlayers; ++i)
+	{
+		std::shared_ptr<Player>	player = std::make_shared<Player>(1500, 750, 0, 0, true);
+		S_Map->addPlayer(player, 0);
+		player->setTeam(i % 2 + 1);
+		player->startRespawnSequence();
+		players.push_back(player);
+	}
+	S_Map->getMode()->activeHorde();
+	for (unsigned int i = 0; i < nbBots; ++i)
+		S_Map->getMode()->spawnBot();
+	S_Map->addNewObjects();
+	Event::clearEvents();
+	unsigned int	nbObjects = S_Map->getElems()->size();
+	nbBots = S_Map->getBots()->size();
+
+	std::vector<sf::Int64>	phases[PHASE_COUNT];
+	std::vector<sf::Int64>	ticks;
+	for (unsigned int i = 0; i < PHASE_COUNT; ++i)
+		phases[i].reserve(nbTicks);
+	ticks.reserve(nbTicks);
+
+	SnapshotHistory	history;
+	std::vector<ClientInterest>	interests(players.size());
+	BitWriter		writer;
+	sf::Packet		packet;
+	s_playerState	state;
+	size_t			bytes = 0;
+	sf::Clock		clock;
+
+	for (unsigned int tick = 1; tick <= nbTicks; ++tick)
+	{
+		sf::Int64	start = clock.getElapsedTime().asMicroseconds();
+		sf::Int64	last = start;
+		sf::Int64	now;
+
+#define	END_PHASE(phase)	now = clock.getElapsedTime().asMicroseconds(); phases[phase].push_back(now - last); last = now;
+
+		for (unsigned int i = 0; i < players.size(); ++i)
+		{
+			scriptActions(actions[i], i, tick);
+			ADD_EVENT(ev_PLAYER_ACTION, s_event(players[i], &actions[i]));
+		}
+		END_PHASE(PHASE_INPUT);
+
+		S_Map->update();
+		END_PHASE(PHASE_MAP);
+
+		physicEngine.update(S_Map->getDeltaTime());
+		END_PHASE(PHASE_PHYSIC);
+
+		gameEngine.update(S_Map->getDeltaTime());
+		END_PHASE(PHASE_GAME);
+
+		// Same work as Sender::sendSnapshot, without the socket
+		Snapshot	&snapshot = history.push(tick);
+		for (EntityStore<Player>::const_iterator it = S_Map->getPlayers()->begin(); it != S_Map->getPlayers()->end(); ++it)
+		{
+			capturePlayerState(state, *(*it));
+			snapshot.addPlayer(state);
+		}
+		const Snapshot	*base = tick > BENCH_ACK_DELAY ? history.find(tick - BENCH_ACK_DELAY) : NULL;
+		for (unsigned int client = 0; client < players.size(); ++client)
+		{
+			ClientInterest	&interest = interests[client];
+			sf::Uint32		previousId = 0;
+			interest.update(*players[client]);
+			interest.beginSnapshot(tick);
+			writer.clear();
+			writer.writeBits(tick, 32);
+			writer.writeVarUint(base ? BENCH_ACK_DELAY : 0);
+			writer.writeVarUint(tick); // Last input applied
+			for (std::vector<s_playerState>::const_iterator it = snapshot.getPlayers().begin(); it != snapshot.getPlayers().end(); ++it)
+			{
+				if (!interest.mustSendPlayer(*it, players[client]->getId()))
+					continue;
+				writer.writeBits(WIRE_PLAYER, WIRE_TAG_BITS);
+				writer.writeVarInt(static_cast<sf::Int32>(it->id - previousId));
+				writePlayerDelta(writer, *it, base && interest.wasSent(base->getSequence(), it->id) ? base->findPlayer(it->id) : NULL);
+				previousId = it->id;
+			}
+			writer.writeBits(WIRE_END, WIRE_TAG_BITS);
+			packet.clear();
+			packet << static_cast<sf::Uint32>(0) << static_cast<float>(tick); // Packet type / timestamp
+			packet << static_cast<sf::Uint16>(0) << static_cast<sf::Uint32>(0); // Reliable ack
+			writer.appendTo(packet);
+			bytes += packet.getDataSize();
+		}
+		END_PHASE(PHASE_SNAPSHOT);
+
+		S_Map->addNewObjects();
+		S_Map->deleteObjects();
+		Event::clearEvents();
+		END_PHASE(PHASE_CLEANUP);
+
+#undef	END_PHASE
+
+		ticks.push_back(last - start);
+	}
+
+	std::cout << std::endl << "Map " << (map ? map : G_conf->game->map.c_str())
+		<< " - " << nbTicks << " ticks - " << players.size() << " players - " << nbBots << " bots" << std::endl;
+	std::cout << "Objects " << nbObjects << " at start, " << S_Map->getElems()->size() << " at end" << std::endl;
+	std::cout << "Tick budget " << 1000000 / tickrate << " us - snapshot "
+		<< (players.empty() ? 0 : bytes / nbTicks / players.size()) << " bytes / client / tick" << std::endl << std::endl;
+	std::cout << std::left << std::setw(16) << "in micro sec" << std::right
+		<< std::setw(10) << "avg" << std::setw(10) << "p50"
+		<< std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+	for (unsigned int i = 0; i < PHASE_COUNT; ++i)
+		printStats(phaseNames[i], phases[i]);
+	printStats("tick", ticks);
+
+	physicEngine.stop();
+	gameEngine.stop();
+	S_Log->stop();
+	return EXIT_SUCCESS;
+}
+
+int		main(int ac, char **av)
+{
+	G_isServer = true;
+	G_isOffline = false;
+
+	unsigned int	nbPlayers = ac > 1 ? atoi(av[1]) : BENCH_PLAYERS;
+	unsigned int	nbBots = ac > 2 ? atoi(av[2]) : BENCH_BOTS;
+	unsigned int	nbTicks = ac > 3 ? atoi(av[3]) : BENCH_TICKS;
+	const char		*map = ac > 4 ? av[4] : NULL;
+
+	try
+	{
+		return bench(nbPlayers, nbBots, nbTicks, map);
+	}
+	catch (const std::runtime_error &error)
+	{
+		std::cerr << "Runtime Error encountered ! What : " << error.what() << std::endl;
+		S_Log->stop(false);
+	}
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,62 @@
+//
+// Interpolation.hpp for Void Clash
+//
+
+#ifndef		INTERPOLATION_HPP_
+# define	INTERPOLATION_HPP_
+
+#include	<deque>
+#include	<map>
+#include	<SFML/System.hpp>
+
+#define	INTERPOLATION_SAMPLES			32		// server states kept per remote player
+#define	INTERPOLATION_MAX_EXTRAPOLATION	0.25f	// in sec, moved with his last direction this long after his last state
+#define	INTERPOLATION_SNAP_DISTANCE		300.f	// states further than this are not blended (respawn...)
+#define	INTERPOLATION_CLOCK_ADAPT		0.01f	// how fast the server clock estimate follows late packets
+
+///////////////////////////////////////////////
+/////   Remote players interpolation (jitter buffer)
+/////	Each update gives the server time it was captured at. The
+/////	states of the remote players are kept with it, and they are
+/////	shown as they were interpolation_delay ms ago on the server,
+/////	between the two states around this time.
+/////	If no state arrived yet for this time (lost updates), the
+/////	last one is extrapolated for INTERPOLATION_MAX_EXTRAPOLATION.
+/////	The local player is not here (see Prediction)
+
+class	Interpolation
+{
+public:
+	Interpolation();
+	~Interpolation();
+
+	// Server time (in sec) of the update being read, before its players
+	void	addSnapshot(float serverTime, sf::Time now);
+	void	addState(sf::Uint32 id, float x, float y, float dirX, float dirY, float aimX, float aimY);
+	bool	isTracked(sf::Uint32 id) const;
+
+	// Moves the remote players, once per frame after the physic
+	void	update(sf::Time now);
+	void	clear();
+
+private:
+	struct	s_sample
+	{
+		float	time;
+		float	x;
+		float	y;
+		float	dirX;
+		float	dirY;
+		float	aimX;
+		float	aimY;
+	};
+
+	float	getRenderTime(sf::Time now) const;
+
+	bool	_synchronized;		// At least one update received
+	float	_clockOffset;		// local time - server time, in sec
+	float	_snapshotTime;		// Server time of the update being read
+	std::map<sf::Uint32, std::deque<s_sample> >	_tracks;
+};
+
+#endif
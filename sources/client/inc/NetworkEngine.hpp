@@ -15,6 +15,9 @@
 #include	"AEngine.hpp"
 #include	"Player.hpp"
 #include	"Receiver.hpp"
+#include	"ReliableChannel.hpp"
+#include	"Prediction.hpp"
+#include	"Interpolation.hpp"
 
 class Sender;
 
@@ -33,11 +36,14 @@ enum	ePacketType
 	PACKET_CONFIG,				// Server -> client - t_conf
 
 	//................. Low level sync
-	PACKET_INPUT,				// Client -> server - t_actions
-	PACKET_UPDATE,				// Server -> client - loop on all game object and serialize them (light - every tickrate)
-	PACKET_SYNCHRO,				// Server -> client - loop on all game object and serialize them (medium - every sec)
-	PACKET_EVENT_ADD,			// Server -> client - Subpacket of update / welcome and sync
-	PACKET_EVENT_DELETE,		// Server -> client - Subpacket of update / welcome and sync
+	PACKET_INPUT,				// Client -> server - timestamp / last snapshot received / reliable ack / input sequence / t_actions
+	PACKET_UPDATE,				// Server -> client - timestamp / reliable ack / bit stream: snapshot sequence / base offset / last input applied / world records (light - every tickrate)
+	PACKET_SYNCHRO,				// Server -> client - players, then the world data in PACKET_WORLD_DATA (medium - every sec)
+	PACKET_EVENT_ADD,			// Unused - world records are bit packed, see eWireTag
+	PACKET_EVENT_DELETE,		// Unused - world records are bit packed, see eWireTag
+	PACKET_WORLD_DATA,			// Server -> client - bit stream: world records (walls / flags...), split in datagrams < WORLD_DATA_CHUNK_SIZE
+	PACKET_FRAGMENT,			// Both ways - message id / index / count / chunk size / part of a packet bigger than the MTU (see Fragment.hpp)
+	PACKET_RELIABLE,			// Both ways - datagram sequence / messages of the reliable channels (see ReliableChannel.hpp)
 
 	//................. General
 	PACKET_DISPLAY_STRING,			// Server -> client - int (type of display) / std::string
@@ -87,6 +93,9 @@ public:
   //sf::Uint32	getLocalIp();
   Receiver	*getReceiver();
   Sender	*getSender();
+  ReliableChannel	&getChannel();
+  Prediction	&getPrediction();
+  Interpolation	&getInterpolation();
   std::string	&getServerIp();
   unsigned short getServerPort();
 
@@ -105,6 +114,9 @@ private:
 
   Receiver		*_receiver;
   Sender		*_sender;
+  ReliableChannel	_channel; // Events which must not be lost, both ways
+  Prediction	_prediction; // Inputs of the local player not acked yet
+  Interpolation	_interpolation; // States of the remote players, shown with a delay
 };
 
 #endif
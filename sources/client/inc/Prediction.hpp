@@ -0,0 +1,56 @@
+//
+// Prediction.hpp for Void Clash
+//
+
+#ifndef		PREDICTION_HPP_
+# define	PREDICTION_HPP_
+
+#include	<deque>
+#include	<memory>
+#include	<SFML/System.hpp>
+#include	"Actions.hpp"
+
+class	Player;
+
+#define	PREDICTION_HISTORY_SIZE		512		// inputs not acked yet, the oldest are forgotten above
+#define	PREDICTION_SMOOTHING_TIME	0.1f	// in sec, a correction is reduced by e in this time
+#define	PREDICTION_SNAP_DISTANCE	300.f	// errors bigger than this are not smoothed (respawn...)
+
+///////////////////////////////////////////////
+/////   Local player prediction
+/////	The local player moves at once with his inputs. Each input sent
+/////	is kept with the frame time it was applied for, until the server
+/////	acks it in a snapshot (last input it applied).
+/////	The player is then moved back to the server state and the inputs
+/////	not acked yet are applied again with the shared movement / physic
+/////	code. The difference with what was shown is reduced over
+/////	PREDICTION_SMOOTHING_TIME instead of being applied at once
+
+class	Prediction
+{
+public:
+	Prediction();
+	~Prediction();
+
+	// Called for each input sent, returns its sequence
+	sf::Uint32	addInput(const s_actions &actions, const sf::Time &deltaTime);
+
+	// Server state of the local player, from a snapshot acking this input
+	void	reconcile(const std::shared_ptr<Player> &player, float x, float y,
+					float dirX, float dirY, sf::Uint32 ackedInput, sf::Time now);
+
+private:
+	struct	s_input
+	{
+		sf::Uint32	sequence;
+		s_actions	actions;
+		sf::Time	deltaTime;
+	};
+
+	sf::Uint32	_nextSequence;
+	sf::Uint32	_lastAcked;
+	sf::Time	_lastReconcile;
+	std::deque<s_input>	_inputs;
+};
+
+#endif
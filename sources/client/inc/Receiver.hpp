@@ -11,6 +11,9 @@
 #ifndef		RECEIVER_HPP_
 # define	RECEIVER_HPP_
 
+#include	"Snapshot.hpp"
+#include	"Fragment.hpp"
+
 class	NetworkEngine;
 
 class	Receiver
@@ -21,23 +24,27 @@ public:
 
   bool	update();
 
+  sf::Uint32	getLastSnapshot() const; // Sent back to server as delta base
+
 private:
   // FUNCS
   bool	extractPacketFromType(sf::Uint32 packetType);
+  bool	extractReliableMessages();
 
-  bool	extractWorldData();
-  bool	extractObject(sf::Uint32 type, sf::Uint32 id);
-  void	updatePlayer(sf::Uint32 id);
-  void	registerNewPlayer(sf::Uint32 id, sf::Uint16 team);
+  bool	extractWorldData(BitReader &reader);
+  bool	extractObject(BitReader &reader, sf::Uint32 type, sf::Uint32 id);
+  bool	updatePlayer(BitReader &reader, sf::Uint32 id);
+  void	registerNewPlayer(sf::Uint32 id, const s_playerState &state);
 
   template<typename T>
-  void	extractObject(sf::Uint32 id);
+  bool	extractObject(BitReader &reader, sf::Uint32 id);
   template<typename T>
-  std::shared_ptr<T>	extractWeapons(sf::Uint32 id, bool &created);
+  std::shared_ptr<T>	extractWeapons(BitReader &reader, sf::Uint32 id, bool &created);
 
   void	handleUpdate();
   void	handleWelcome();
   void	handleSynchro();
+  void	handleWorldData();
   void	handleConfig();
   void	handlePing();
   void	handleVersionCheck();
@@ -68,6 +75,16 @@ private:
   float		_lastUpdate;
   float		_averageLatency;
 
+  // Packets bigger than the MTU, until all their fragments are received
+  FragmentAssembler	_assembler;
+
+  // Snapshots received, used to rebuild players from server deltas
+  SnapshotHistory	_snapshots;
+  Snapshot		*_currentSnapshot;
+  const Snapshot	*_baseSnapshot;
+  sf::Uint32		_lastSnapshot;
+  sf::Uint32		_ackedInput; // Last input of the local player applied by the server (see Prediction)
+
   // Used to check no connectivity with serv
   sf::Time	_lastConnectivity;
   unsigned int	_msSinceLastConnectivity;
@@ -11,6 +11,7 @@
 #ifndef		SENDER_HPP_
 # define	SENDER_HPP_
 
+#include	<deque>
 #include	<SFML/Network.hpp>
 #include	"NetworkEngine.hpp"
 
@@ -39,10 +40,17 @@ private:
   void	sendHordeActivation(void);
   void	sendSwitchTeam();
   void	sendChangeNick();
+  bool	sendReliable(eChannel channel);
+  void	flushChannel();
 
   // VARS
   s_actions	*_playerActions; // Only use for packet transmission, only Sender use it
+  s_actions	_command; // Actions of the frames since the last command
+  sf::Time	_commandTime; // Not sent yet, one command per server tick
+  sf::Uint32	_lastCommand; // Sequence of _commands.back()
+  std::deque<s_actions>	_commands; // Last INPUT_REDUNDANCY commands, sent again each time
   sf::Packet	_packet;
+  sf::Packet	_datagram; // Reliable messages
   NetworkEngine	*_networkEngine;
 
   // Reliable UDP
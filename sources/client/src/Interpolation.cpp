@@ -0,0 +1,143 @@
+//
+// Interpolation.cpp for Void Clash
+//
+
+#include	<algorithm>
+#include	"Interpolation.hpp"
+#include	"ConfigParser.hpp"
+#include	"Player.hpp"
+#include	"Map.hpp"
+
+extern t_config *G_conf;
+
+Interpolation::Interpolation()
+{
+	clear();
+}
+
+Interpolation::~Interpolation()
+{
+}
+
+void	Interpolation::clear()
+{
+	_synchronized = false;
+	_clockOffset = 0;
+	_snapshotTime = 0;
+	_tracks.clear();
+}
+
+///////////////////////////////////////////////
+/////   States received
+
+void	Interpolation::addSnapshot(float serverTime, sf::Time now)
+{
+	// Updates are read in order, the server clock restarted (new map)
+	if (_synchronized && serverTime < _snapshotTime)
+		clear();
+
+	// The least delayed update gives the offset at once, later ones
+	// move it slowly (clock drift), jitter is left to the render delay
+	float	offset = now.asSeconds() - serverTime;
+	if (!_synchronized || offset < _clockOffset)
+		_clockOffset = offset;
+	else
+		_clockOffset += (offset - _clockOffset) * INTERPOLATION_CLOCK_ADAPT;
+	_synchronized = true;
+	_snapshotTime = serverTime;
+}
+
+void	Interpolation::addState(sf::Uint32 id, float x, float y, float dirX, float dirY, float aimX, float aimY)
+{
+	std::deque<s_sample>	&samples = _tracks[id];
+	s_sample	sample;
+
+	sample.time = _snapshotTime;
+	sample.x = x;
+	sample.y = y;
+	sample.dirX = dirX;
+	sample.dirY = dirY;
+	sample.aimX = aimX;
+	sample.aimY = aimY;
+	if (!samples.empty() && samples.back().time >= sample.time)
+		samples.back() = sample;
+	else
+		samples.push_back(sample);
+	if (samples.size() > INTERPOLATION_SAMPLES)
+		samples.pop_front();
+}
+
+bool	Interpolation::isTracked(sf::Uint32 id) const
+{
+	return _tracks.find(id) != _tracks.end();
+}
+
+///////////////////////////////////////////////
+/////   Remote players shown in the past
+
+float	Interpolation::getRenderTime(sf::Time now) const
+{
+	return now.asSeconds() - _clockOffset - G_conf->server->interpolation_delay / 1000.f;
+}
+
+void	Interpolation::update(sf::Time now)
+{
+	if (!_synchronized || G_conf == NULL)
+		return;
+
+	float	renderTime = getRenderTime(now);
+
+	for (std::map<sf::Uint32, std::deque<s_sample> >::iterator it = _tracks.begin(); it != _tracks.end();)
+	{
+		Player	*player = dynamic_cast<Player *>(S_Map->findObjectWithID(it->first).get());
+		std::deque<s_sample>	&samples = it->second;
+
+		// Left, or the local player after a reconnection
+		if (!player || player->isControled())
+		{
+			_tracks.erase(it++);
+			continue;
+		}
+		++it;
+
+		// Only the last state before the render time is still needed
+		while (samples.size() > 1 && samples[1].time <= renderTime)
+			samples.pop_front();
+		if (samples.empty())
+			continue;
+
+		s_sample	state = samples.front();
+		if (samples.size() == 1 && renderTime > state.time)
+		{
+			// Next state is late or lost, same unit as PhysicEngine
+			float	elapsed = std::min(renderTime - state.time, INTERPOLATION_MAX_EXTRAPOLATION);
+			float	delta = elapsed / 0.02f / G_conf->game->speed;
+
+			state.x += state.dirX * delta;
+			state.y += state.dirY * delta;
+		}
+		else if (samples.size() > 1 && renderTime > state.time)
+		{
+			const s_sample	&next = samples[1];
+			float	dx = next.x - state.x;
+			float	dy = next.y - state.y;
+
+			if (dx * dx + dy * dy <= INTERPOLATION_SNAP_DISTANCE * INTERPOLATION_SNAP_DISTANCE)
+			{
+				float	ratio = (renderTime - state.time) / (next.time - state.time);
+
+				state.x += dx * ratio;
+				state.y += dy * ratio;
+				state.dirX += (next.dirX - state.dirX) * ratio;
+				state.dirY += (next.dirY - state.dirY) * ratio;
+				state.aimX += (next.aimX - state.aimX) * ratio;
+				state.aimY += (next.aimY - state.aimY) * ratio;
+			}
+		}
+
+		player->setPosition(state.x, state.y);
+		player->setDirX(state.dirX);
+		player->setDirY(state.dirY);
+		player->setAim(state.aimX, state.aimY);
+	}
+}
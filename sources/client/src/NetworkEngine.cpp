@@ -24,7 +24,8 @@
 /////	Ctor/Dtor
 //////////////////////////////////////////////////////////////////////
 
-NetworkEngine::NetworkEngine()
+NetworkEngine::NetworkEngine() :
+_channel(PACKET_RELIABLE)
 {
 	_receiver = new Receiver(this);
 	_sender = new Sender(this);
@@ -117,6 +118,27 @@ Sender		*NetworkEngine::getSender(void)
 
 //------------------------------------------------------------------//
 
+ReliableChannel	&NetworkEngine::getChannel(void)
+{
+	return (_channel);
+}
+
+//------------------------------------------------------------------//
+
+Prediction	&NetworkEngine::getPrediction(void)
+{
+	return (_prediction);
+}
+
+//------------------------------------------------------------------//
+
+Interpolation	&NetworkEngine::getInterpolation(void)
+{
+	return (_interpolation);
+}
+
+//------------------------------------------------------------------//
+
 std::string	&NetworkEngine::getServerIp(void)
 {
 	return (_serverIp);
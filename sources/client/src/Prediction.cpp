@@ -0,0 +1,72 @@
+//
+// Prediction.cpp for Void Clash
+//
+
+#include	<cmath>
+#include	"Prediction.hpp"
+#include	"Player.hpp"
+#include	"PhysicEngine.hpp"
+
+Prediction::Prediction()
+{
+	_nextSequence = 1; // 0 = no input acked
+	_lastAcked = 0;
+	_lastReconcile = sf::Time::Zero;
+}
+
+Prediction::~Prediction()
+{
+}
+
+sf::Uint32	Prediction::addInput(const s_actions &actions, const sf::Time &deltaTime)
+{
+	s_input	input;
+
+	input.sequence = _nextSequence++;
+	input.actions = actions;
+	input.deltaTime = deltaTime;
+	_inputs.push_back(input);
+	if (_inputs.size() > PREDICTION_HISTORY_SIZE)
+		_inputs.pop_front();
+	return input.sequence;
+}
+
+void	Prediction::reconcile(const std::shared_ptr<Player> &player, float x, float y,
+							float dirX, float dirY, sf::Uint32 ackedInput, sf::Time now)
+{
+	// Snapshot received out of order
+	if (ackedInput < _lastAcked)
+		return;
+	_lastAcked = ackedInput;
+	while (!_inputs.empty() && _inputs.front().sequence <= ackedInput)
+		_inputs.pop_front();
+
+	float	shownX = player->getX();
+	float	shownY = player->getY();
+
+	// Server state, then the inputs it has not applied yet
+	// Same order as a frame: physic step, then the input changes the direction
+	player->setPosition(x, y);
+	player->setDirX(dirX);
+	player->setDirY(dirY);
+	if (player->getLife() > 0 && player->getTeam() != 0)
+	{
+		for (std::deque<s_input>::const_iterator it = _inputs.begin(); it != _inputs.end(); ++it)
+		{
+			simulateUpdatePhysObject(player, it->deltaTime);
+			player->predictMove(it->actions, it->deltaTime);
+		}
+	}
+
+	// What was shown goes smoothly to the new prediction
+	float	errorX = shownX - player->getX();
+	float	errorY = shownY - player->getY();
+	float	elapsed = (now - _lastReconcile).asSeconds();
+
+	_lastReconcile = now;
+	if (errorX * errorX + errorY * errorY > PREDICTION_SNAP_DISTANCE * PREDICTION_SNAP_DISTANCE)
+		return;
+
+	float	keep = std::exp(-elapsed / PREDICTION_SMOOTHING_TIME);
+	player->setPosition(player->getX() + errorX * keep, player->getY() + errorY * keep);
+}
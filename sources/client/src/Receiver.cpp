@@ -31,45 +31,89 @@ extern t_config *G_conf;
 
 
 Receiver::Receiver(NetworkEngine *networkEngine) :
-_networkEngine(networkEngine)
+_assembler(PACKET_FRAGMENT), _networkEngine(networkEngine)
 {
 	_lastUpdate = 0.0f;
 	_averageLatency = 0.0f;
 	_lastConnectivity = S_Map->getClock().getElapsedTime();
 	_welcomeReceived = false;
-
+	_currentSnapshot = NULL;
+	_baseSnapshot = NULL;
+	_lastSnapshot = 0;
+	_ackedInput = 0;
 }
 
 Receiver::~Receiver()
 {}
 
+sf::Uint32	Receiver::getLastSnapshot() const
+{
+	return _lastSnapshot;
+}
+
 ///////////////////////////////////////////////
 /////   Received messages from server
 /////	And extract packet type
 
 bool	Receiver::update()
 {
-	// ip and port not used
+	// ip and port only used for the fragments
 	sf::IpAddress		ip;
 	unsigned short	port;
 	sf::Uint32		packetType;
 
+	// Left after a welcome last frame
+	if (extractReliableMessages() == false)
+		return true;
+
 	_packet.clear();
 	packetType = PACKET_NONE;
 	while (_networkEngine->getSocket().receive(_packet, ip, port) == sf::Socket::Done)
 	{
 		_lastConnectivity = S_Map->getClock().getElapsedTime();
+		// Big packets (config / welcome...) are handled once complete
+		if (_assembler.isFragment(_packet) &&
+			!_assembler.add(_packet, ip, port, S_Map->getGlobalClock().getElapsedTime()))
+			continue;
 		if (_packet >> packetType)
 		{
-			if (extractPacketFromType(packetType) == false)
+			if (packetType == PACKET_RELIABLE)
+			{
+				if (!_networkEngine->getChannel().receive(_packet))
+					_networkEngine->printLog(1, "Reliable packet integrity failed. Clearing packet...");
+				else if (extractReliableMessages() == false)
+					return true;
+			}
+			else if (extractPacketFromType(packetType) == false)
 				return true;
 		}
 		else
 			_networkEngine->printLog(1, "Unable to extract packet");
 	}
+
+	// Remote players, after the physic moved them this frame
+	_networkEngine->getInterpolation().update(S_Map->getGlobalClock().getElapsedTime());
 	return createServerConnectivityEvent();
 }
 
+///////////////////////////////////////////////
+/////   Messages of the reliable channel
+/////	Handled like the other packets, in the order the server sent them
+
+bool	Receiver::extractReliableMessages()
+{
+	sf::Uint32	packetType;
+
+	while (_networkEngine->getChannel().popMessage(_packet))
+	{
+		if (!(_packet >> packetType) || packetType == PACKET_RELIABLE)
+			_networkEngine->printLog(1, "Unable to extract reliable message");
+		else if (extractPacketFromType(packetType) == false)
+			return false;
+	}
+	return true;
+}
+
 bool	Receiver::createServerConnectivityEvent()
 {
 	_msSinceLastConnectivity = S_Map->getClock().getElapsedTime().asMilliseconds() - _lastConnectivity.asMilliseconds();
@@ -102,6 +146,8 @@ bool	Receiver::extractPacketFromType(sf::Uint32 packetType)
 		handleVersionCheck();
 	else if (packetType == PACKET_SYNCHRO)
 		handleSynchro();
+	else if (packetType == PACKET_WORLD_DATA)
+		handleWorldData();
 	else if (packetType == PACKET_WEAPON_SELECTION)
 		handleWeaponSelection();
 	else if (packetType == PACKET_CONFIG)
@@ -37,112 +37,158 @@ extern t_config *G_conf;
 /////   Overload of operator >>
 /////	to fill our classes with received data from serv
 
-sf::Packet& operator >>(sf::Packet& packet, Player &m)
+void	applyPlayerState(Player &m, const s_playerState &state)
 {
-	return packet >> m._energy >> m._life >> m._kills >> m._deaths >> m._latency >> m._score >> m._invul;
+	m._energy = unquantizeEnergy(state.energy);
+	m._life = state.life;
+	m._kills = state.kills;
+	m._deaths = state.deaths;
+	m._latency = state.latency * 1000.f;
+	m._score = state.score;
+	m._invul = state.invul;
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Bullet &m)
+// X / Y / DIR (speed + angle)
+static BitReader& readMovement(BitReader& reader, std::pair<float, float> &pos, std::pair<float, float> &dir)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second;
+	pos.first = reader.readQuantized(WIRE_POSITION);
+	pos.second = reader.readQuantized(WIRE_POSITION);
+	reader.readDirection(dir.first, dir.second);
+	return reader;
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Bomb &m)
+// WIDTH / HEIGHT
+static BitReader& readArea(BitReader& reader, sf::Int32 &width, sf::Int32 &height)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second >> m._launched;
+	width = static_cast<sf::Int32>(reader.readQuantized(WIRE_SIZE));
+	height = static_cast<sf::Int32>(reader.readQuantized(WIRE_SIZE));
+	return reader;
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Rocket &m)
+BitReader& operator >>(BitReader& reader, Bullet &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second >> m._impact.first >> m._impact.second;
+	return readMovement(reader, m._pos, m._dir);
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Turret &m)
+BitReader& operator >>(BitReader& reader, Bomb &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second;
+	m._launched = readMovement(reader, m._pos, m._dir).readBool();
+	return reader;
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Bot &m)
+BitReader& operator >>(BitReader& reader, Rocket &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second;
+	readMovement(reader, m._pos, m._dir);
+	m._impact.first = reader.readQuantized(WIRE_POSITION);
+	m._impact.second = reader.readQuantized(WIRE_POSITION);
+	return reader;
 }
 
-sf::Packet& operator >>(sf::Packet& packet, GravityField &m)
+BitReader& operator >>(BitReader& reader, Turret &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second;
+	return readMovement(reader, m._pos, m._dir);
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Explosion &m)
+BitReader& operator >>(BitReader& reader, Bot &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second;
+	return readMovement(reader, m._pos, m._dir);
 }
 
-sf::Packet& operator >>(sf::Packet& packet, SpeedField &m)
+BitReader& operator >>(BitReader& reader, GravityField &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second >> m._width >> m._height;
+	return readMovement(reader, m._pos, m._dir);
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Capture &m)
+BitReader& operator >>(BitReader& reader, Explosion &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second >> m._width >> m._height >> m._controlBar;
+	return readMovement(reader, m._pos, m._dir);
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Respawn &m)
+BitReader& operator >>(BitReader& reader, SpeedField &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second >> m._width >> m._height >> m._team;
+	return readArea(readMovement(reader, m._pos, m._dir), m._width, m._height);
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Flag &m)
+BitReader& operator >>(BitReader& reader, Capture &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._dir.first >> m._dir.second >> m._team >> m._initPos.first >> m._initPos.second;
+	m._controlBar = readArea(readMovement(reader, m._pos, m._dir), m._width, m._height).readFloat();
+	return reader;
 }
 
-sf::Packet& operator >>(sf::Packet& packet, Wall &m)
+BitReader& operator >>(BitReader& reader, Respawn &m)
 {
-	return packet >> m._pos.first >> m._pos.second >> m._end.first >> m._end.second >> m._angle >> m._dir.first >> m._dir.second >> m._len;
+	m._team = static_cast<sf::Uint16>(readArea(readMovement(reader, m._pos, m._dir), m._width, m._height).readBits(WIRE_TEAM_BITS));
+	return reader;
+}
+
+BitReader& operator >>(BitReader& reader, Flag &m)
+{
+	m._team = static_cast<sf::Uint16>(readMovement(reader, m._pos, m._dir).readBits(WIRE_TEAM_BITS));
+	m._initPos.first = reader.readQuantized(WIRE_POSITION);
+	m._initPos.second = reader.readQuantized(WIRE_POSITION);
+	return reader;
+}
+
+BitReader& operator >>(BitReader& reader, Wall &m)
+{
+	m._pos.first = reader.readQuantized(WIRE_POSITION);
+	m._pos.second = reader.readQuantized(WIRE_POSITION);
+	m._end.first = reader.readQuantized(WIRE_POSITION);
+	m._end.second = reader.readQuantized(WIRE_POSITION);
+	m._angle = reader.readFloat();
+	m._dir.first = reader.readFloat();
+	m._dir.second = reader.readFloat();
+	m._len = reader.readVarUint();
+	return reader;
 }
 
 ///////////////////////////////////////////////
 /////   Extract all data
+/////	Records until WIRE_END, see eWireTag
 
-bool	Receiver::extractWorldData()
+bool	Receiver::extractWorldData(BitReader &reader)
 {
-	sf::Uint32		packetType;
-	_packet >> packetType;
+	sf::Uint32	tag;
 	sf::Uint32	id;
-	_packet >> id;
-	if (packetType == PACKET_EVENT_DELETE)
-	{
-		handleDeleteEvent(id);
-		return true;
-	}
-	else if (packetType == PACKET_EVENT_ADD)
-	{
-		sf::Uint32		objType;
-		_packet >> objType;
+	sf::Uint32	playerId = 0;
 
-		if (!(extractObject(objType, id)))
+	while ((tag = reader.readBits(WIRE_TAG_BITS)) != WIRE_END)
+	{
+		if (tag == WIRE_PLAYER)
 		{
-			_networkEngine->printLog(1, "Unknown type of object. Clearing packet...");
-			_packet.clear();
-			return false;
+			playerId += reader.readVarInt();
+			if (!updatePlayer(reader, playerId))
+				return false;
+			continue;
+		}
+		id = reader.readVarUint();
+		if (tag == WIRE_DELETE)
+			handleDeleteEvent(id);
+		else if (tag == WIRE_ADD)
+		{
+			if (!(extractObject(reader, reader.readBits(WIRE_TYPE_BITS), id)))
+			{
+				_networkEngine->printLog(1, "Unable to extract object. Clearing packet...");
+				_packet.clear();
+				return false;
+			}
 		}
 	}
-	else
+	if (!reader.isValid())
 	{
-		_networkEngine->printLog(1, "Unknown type of extract world data.");
+		_networkEngine->printLog(1, "Truncated world data. Clearing packet...");
 		_packet.clear();
 		return false;
 	}
 	return true;
 }
 
-bool	Receiver::extractObject(sf::Uint32 type, sf::Uint32 id)
+bool	Receiver::extractObject(BitReader &reader, sf::Uint32 type, sf::Uint32 id)
 {
 	bool created;
 	if (type == BULLET)
 	{
-		std::shared_ptr<Bullet> bullet = extractWeapons<Bullet>(id, created);
+		std::shared_ptr<Bullet> bullet = extractWeapons<Bullet>(reader, id, created);
 		if (bullet && created)
 		{
 			ADD_EVENT(ev_BULLET_LAUNCHED, s_event(bullet->getOwner()));
@@ -150,7 +196,7 @@ bool	Receiver::extractObject(sf::Uint32 type, sf::Uint32 id)
 	}
 	else if (type == BOMB)
 	{
-		std::shared_ptr<Bomb>	bomb = extractWeapons<Bomb>(id, created);
+		std::shared_ptr<Bomb>	bomb = extractWeapons<Bomb>(reader, id, created);
 		if (bomb && created)
 		{
 			ADD_EVENT(ev_BOMB_PRIMED, s_event(bomb->getOwner()));
@@ -159,43 +205,41 @@ bool	Receiver::extractObject(sf::Uint32 type, sf::Uint32 id)
 	}
 	else if (type == ROCKET)
 	{
-		std::shared_ptr<Rocket> rocket = extractWeapons<Rocket>(id, created);
+		std::shared_ptr<Rocket> rocket = extractWeapons<Rocket>(reader, id, created);
 		if (rocket && created)
 			ADD_EVENT(ev_ROCKET_LAUNCHED, s_event(rocket->getOwner()));
 	}
 	else if (type == TURRET)
 	{
-		std::shared_ptr<Turret> turret = extractWeapons<Turret>(id, created);
+		std::shared_ptr<Turret> turret = extractWeapons<Turret>(reader, id, created);
 		if (turret && created)
 			ADD_EVENT(ev_TURRET_LAUNCHED, s_event(turret->getOwner()));
 	}
 	else if (type == GRAVITY_FIELD)
 	{
-		std::shared_ptr<GravityField> gravity = extractWeapons<GravityField>(id, created);
+		std::shared_ptr<GravityField> gravity = extractWeapons<GravityField>(reader, id, created);
 		if (gravity && created)
 			ADD_EVENT(ev_GRAVITY_LAUNCHED, s_event(gravity->getOwner()));
 	}
 	else if (type == BOT)
-		extractObject<Bot>(id);
+		return extractObject<Bot>(reader, id);
 	else if (type == SPEED_FIELD)
-		extractObject<SpeedField>(id);
+		return extractObject<SpeedField>(reader, id);
 	else if (type == CAPTURE)
-		extractObject<Capture>(id);
+		return extractObject<Capture>(reader, id);
 	else if (type == RESPAWN)
-		extractObject<Respawn>(id);
+		return extractObject<Respawn>(reader, id);
 	else if (type == FLAG)
 	{
-		extractObject<Flag>(id);
-		int ownerId;
-		_packet >> ownerId;
+		if (!extractObject<Flag>(reader, id))
+			return false;
+		sf::Uint32 ownerId = reader.readVarUint();
 		Flag *f = dynamic_cast<Flag *> (S_Map->findObjectWithID(id).get());
 		if (f)
 			f->setOwner(std::dynamic_pointer_cast<Player>(S_Map->findObjectWithID(ownerId)));
 	}
 	else if (type == WALL)
-		extractObject<Wall>(id);
-	else if (type == PLAYER)
-		updatePlayer(id);
+		return extractObject<Wall>(reader, id);
 	else
 		return (false);
 	return (true);
@@ -206,7 +250,7 @@ bool	Receiver::extractObject(sf::Uint32 type, sf::Uint32 id)
 // if no - create it and push it to list
 
 template<typename T>
-void	Receiver::extractObject(sf::Uint32 id)
+bool	Receiver::extractObject(BitReader &reader, sf::Uint32 id)
 {
 	std::shared_ptr<AObject>obj = S_Map->findObjectWithID(id);
 	std::shared_ptr<T> templatedObj;
@@ -220,21 +264,19 @@ void	Receiver::extractObject(sf::Uint32 id)
 	if (!templatedObj)
 	{
 		_networkEngine->printLogWithId(1, "Unable to dynamic cast extracted object ", id);
-		_packet.clear();
-		return;
+		return false;
 	}
-	_packet >> *templatedObj;
+	reader >> *templatedObj;
 	templatedObj->setId(id);
-	return;
+	return true;
 }
 
 // If it's controled player object - do not create it via network -> return
 template<typename T>
-std::shared_ptr<T>	Receiver::extractWeapons(sf::Uint32 id, bool &created)
+std::shared_ptr<T>	Receiver::extractWeapons(BitReader &reader, sf::Uint32 id, bool &created)
 {
 	created = false;
-	sf::Uint32	ownerId;
-	_packet >> ownerId;
+	sf::Uint32	ownerId = reader.readVarUint();
 	// TO VERIFY - Own dynamic obj are no longer created locally
 	// if (S_Map->getCurrentPlayer() && ownerId == S_Map->getCurrentPlayer()->getId())
 	//   {
@@ -242,6 +284,20 @@ std::shared_ptr<T>	Receiver::extractWeapons(sf::Uint32 id, bool &created)
 	//     return NULL;
 	//   }
 
+	// Always read the object, the next records come after it
+	std::shared_ptr<AObject>obj = S_Map->findObjectWithID(id);
+	std::shared_ptr<T>templatedObj = std::dynamic_pointer_cast<T>(obj);
+	bool	exists = (templatedObj != NULL);
+	if (!exists)
+		templatedObj = std::make_shared<T>();
+	reader >> *templatedObj;
+	sf::Int32	weaponIndex = reader.readVarInt();
+
+	if (obj && !exists)
+	{
+		_networkEngine->printLogWithId(1, "Unable to dynamic cast object ", id);
+		return NULL;
+	}
 	std::shared_ptr<AObject>objOwner = S_Map->findObjectWithID(ownerId);
 	std::shared_ptr<Player>owner = std::dynamic_pointer_cast<Player>(objOwner);
 	if (!owner)
@@ -249,38 +305,19 @@ std::shared_ptr<T>	Receiver::extractWeapons(sf::Uint32 id, bool &created)
 		_networkEngine->printLogWithId(1, "No owner for dynamic object found for item ", id);
 		return NULL;
 	}
-
-	std::shared_ptr<AObject>obj = S_Map->findObjectWithID(id);
-	std::shared_ptr<T>templatedObj;
-	if (obj)
+	if (!exists)
 	{
-		std::shared_ptr<T> templatedObj = std::dynamic_pointer_cast<T>(obj);
-		if (!templatedObj)
+		if (!reader.isValid() || weaponIndex < 0 || weaponIndex >= static_cast<sf::Int32>(G_conf->weapons->size()))
 		{
-			_networkEngine->printLogWithId(1, "Unable to dynamic cast object ", id);
-			_packet.clear();
+			_networkEngine->printLogWithId(1, "Unknown weapon for dynamic object ", id);
 			return NULL;
 		}
-		_packet >> *templatedObj;
-		templatedObj->setOwner(owner);
-		templatedObj->setId(id);
-
-		sf::Int32  weaponIndex;
-		_packet >> weaponIndex; // Just to purge
-	}
-	else
-	{
 		created = true;
-		templatedObj = std::make_shared<T>();
 		templatedObj->pushInMap();
-		_packet >> *(templatedObj.get());
-		templatedObj->setOwner(owner);
-		templatedObj->setId(id);
-
-		sf::Int32  weaponIndex;
-		_packet >> weaponIndex;
 		templatedObj->init(G_conf->weapons->at(weaponIndex));
 	}
+	templatedObj->setOwner(owner);
+	templatedObj->setId(id);
 
 	// simulateUpdatePhysObject(templatedObj);
 	// TODO - Call physic engine simulate function
@@ -292,24 +329,42 @@ std::shared_ptr<T>	Receiver::extractWeapons(sf::Uint32 id, bool &created)
 
 Player *ghost = NULL;
 
-void	Receiver::updatePlayer(sf::Uint32 id)
+bool	Receiver::updatePlayer(BitReader &reader, sf::Uint32 id)
 {
-	sf::Uint16	team;
-	_packet >> team;
-	float	posX;
-	_packet >> posX;
-	float	posY;
-	_packet >> posY;
+	// Start from the state in the delta base, if the player was in it
+	s_playerState	state;
+	const s_playerState	*base = NULL;
+	if (_baseSnapshot)
+		base = _baseSnapshot->findPlayer(id);
+	if (base)
+		state = *base;
+	state.id = id;
+
+	if (!readPlayerDelta(reader, state))
+	{
+		_networkEngine->printLogWithId(1, "Unable to extract state of player ", id);
+		if (_currentSnapshot)
+			_currentSnapshot->invalidate();
+		_currentSnapshot = NULL;
+		_packet.clear();
+		return false;
+	}
+	if (_currentSnapshot)
+		_currentSnapshot->addPlayer(state);
+
+	std::string nick;
+	if (_packetType == PACKET_SYNCHRO)
+		reader.readString(nick);
+
+	sf::Uint16	team = state.team;
+	float	posX = unquantizePosition(state.x);
+	float	posY = unquantizePosition(state.y);
 	float	dirX;
-	_packet >> dirX;
 	float	dirY;
-	_packet >> dirY;
-	float	aimX;
-	_packet >> aimX;
-	float	aimY;
-	_packet >> aimY;
-	int weaponIndex;
-	_packet >> weaponIndex;
+	unquantizeDirection(state.dirAngle, state.dirSpeed, dirX, dirY);
+	float	aimX = unquantizeAim(state.aimX, state.x);
+	float	aimY = unquantizeAim(state.aimY, state.y);
+	int weaponIndex = state.shieldIndex;
 
 	//  Check if player found
 	AObject	*obj = S_Map->findObjectWithID(id).get();
@@ -318,84 +373,89 @@ void	Receiver::updatePlayer(sf::Uint32 id)
 	{
 		player->setActive(true);
 		player->setTeam(team);
-		if (!player->isControled())
+		// Remote players are moved by the interpolation, a synchro
+		// only places those it has no state of yet
+		bool	interpolated = !player->isControled() &&
+			(_packetType == PACKET_UPDATE || _networkEngine->getInterpolation().isTracked(id));
+		if (interpolated && _packetType == PACKET_UPDATE)
+			_networkEngine->getInterpolation().addState(id, posX, posY, dirX, dirY, aimX, aimY);
+		if (!player->isControled() && !interpolated)
 		{
 			player->setDirX(dirX);
 			player->setDirY(dirY);
 			player->setAim(aimX, aimY);
 		}
-		// first var is the latency hard coded 10ms atm
-		// S_Map->getCurrentPlayer()->getLatency() / 2.0f = last ping
-
-		// 4 ATM NEED 2 WITH NEW PHY ENGINE
-		float	latency = 0.0f;
-		//if (S_Map->getCurrentPlayer())
-		//	latency = S_Map->getCurrentPlayer()->getLatency() / 4.0f / 20000.0f / G_conf->game->speed;
-
-		float range = sqrt(std::pow(posX +
-			dirX * latency
-			- player->getX(), 2) +
-			std::pow(posY +
-			dirY * latency
-			- player->getY(), 2));
-		float speed = G_conf->player->max_speed + sqrt(std::pow(player->getDirX(), 2) +
-			std::pow(player->getDirY(), 2));
-		// Ghost
-		//if (G_isServer == false && G_isOffline == false)
-		//	{
-		//	  if (ghost == NULL)
-		//	    {
-		//	      ghost = new Player(0,0,0,0,false);
-		//	      S_Map->addPlayer(ghost, 2);
-		//	    }
-		//	  ghost->setPosition(posX //+ latency * dirX
-		//			     , posY //+ latency * dirY
-		//			     );
-		//	}
-
-		if (range > speed / 3.0f)
+		// The local player is predicted once the server applies his inputs
+		bool	predicted = player->isControled() && _ackedInput != 0;
+		if (!predicted && !interpolated)
 		{
-			//_networkEngine->printLog(1, "Reset position with server");
-			player->setPosition((posX), (posY));
+			// first var is the latency hard coded 10ms atm
+			// S_Map->getCurrentPlayer()->getLatency() / 2.0f = last ping
+
+			// 4 ATM NEED 2 WITH NEW PHY ENGINE
+			float	latency = 0.0f;
+			//if (S_Map->getCurrentPlayer())
+			//	latency = S_Map->getCurrentPlayer()->getLatency() / 4.0f / 20000.0f / G_conf->game->speed;
+
+			float range = sqrt(std::pow(posX +
+				dirX * latency
+				- player->getX(), 2) +
+				std::pow(posY +
+				dirY * latency
+				- player->getY(), 2));
+			float speed = G_conf->player->max_speed + sqrt(std::pow(player->getDirX(), 2) +
+				std::pow(player->getDirY(), 2));
+			// Ghost
+			//if (G_isServer == false && G_isOffline == false)
+			//	{
+			//	  if (ghost == NULL)
+			//	    {
+			//	      ghost = new Player(0,0,0,0,false);
+			//	      S_Map->addPlayer(ghost, 2);
+			//	    }
+			//	  ghost->setPosition(posX //+ latency * dirX
+			//			     , posY //+ latency * dirY
+			//			     );
+			//	}
+
+			if (range > speed / 3.0f)
+			{
+				//_networkEngine->printLog(1, "Reset position with server");
+				player->setPosition((posX), (posY));
+			}
+			// smooth
+			float smoothPower = G_conf->server->snapshot_rate / 32.f;
+			player->setPosition((smoothPower * player->getX() + posX) / (smoothPower + 1),
+				(smoothPower * player->getY() + posY) / (smoothPower + 1));
+			//player->setPosition((smoothPower * player->getX() + posX + player->getDirX() * latency) / smoothPower + 1,
+			//	(smoothPower * player->getY() + posY + player->getDirY() * latency) / smoothPower + 1);
+			// bruteforce
+			// player->setPosition(posX, posY);
 		}
-		// smooth
-		float smoothPower = G_conf->server->tickrate / 32.f;
-		player->setPosition((smoothPower * player->getX() + posX) / (smoothPower + 1),
-			(smoothPower * player->getY() + posY) / (smoothPower + 1));
-		//player->setPosition((smoothPower * player->getX() + posX + player->getDirX() * latency) / smoothPower + 1,
-		//	(smoothPower * player->getY() + posY + player->getDirY() * latency) / smoothPower + 1);
-		// bruteforce
-		// player->setPosition(posX, posY);
 		if (weaponIndex == -1)
 			player->setShield(NULL);
 		else
 			player->setShield(G_conf->weapons->at(weaponIndex));
-		_packet >> *player;
+		applyPlayerState(*player, state);
+
+		// The server state of an update is only his starting point (see Prediction)
+		if (predicted && _packetType == PACKET_UPDATE)
+			_networkEngine->getPrediction().reconcile(std::dynamic_pointer_cast<Player>(S_Map->findObjectWithID(id)),
+				posX, posY, dirX, dirY, _ackedInput, S_Map->getGlobalClock().getElapsedTime());
 
 		if (_packetType == PACKET_SYNCHRO)
-		{
-			std::string nick;
-			_packet >> nick;
 			player->setNick(nick);
-		}
 	}
 	else
-		registerNewPlayer(id, team);
+		registerNewPlayer(id, state);
+	return true;
 }
 
-void	Receiver::registerNewPlayer(sf::Uint32 id, sf::Uint16 team)
+void	Receiver::registerNewPlayer(sf::Uint32 id, const s_playerState &state)
 {
 	// Verify that there is not already an event start fort this player (2+ packets receive in same frame)
 	if (Event::eventAlreadyAddedForId(ev_START, id))
-	{
-		// used only to unload packet
-		//Player p(0, 0, 0, 0, true);
-		//_packet >> p;
-		//delete player;
-
-		_packet.clear();
 		return;
-	}
 
 	std::shared_ptr<Player>	player;
 	// Check if new player is myself
@@ -410,7 +470,7 @@ void	Receiver::registerNewPlayer(sf::Uint32 id, sf::Uint16 team)
 		player = std::make_shared<Player>(0, 0, 0, 0, false);
 	}
 
-	_packet >> *player;
+	applyPlayerState(*player, state);
 	player->setId(id);
-	S_Map->addPlayer(player, team);
+	S_Map->addPlayer(player, state.team);
 }
@@ -25,8 +25,10 @@
 #include	"HudRessources.hpp"
 #include	"Log.hpp"
 #include	"Map.hpp"
+#include	"ConfigSerializer.hpp"
 
 extern t_config *G_conf;
+extern sf::Uint32 G_confHash;
 
 ///////////////////////////////////////////////
 /////   Handle generic packet
@@ -39,7 +41,7 @@ void	Receiver::handleUpdate()
 		return;
 	}
 
-	// Drop old packet update to work only on most recent ones
+	// Server time of the update, in microseconds
 	float timestamp;
 	if (_packet >> timestamp)
 	{
@@ -60,17 +62,6 @@ void	Receiver::handleUpdate()
 			//   }
 			previousTimestamp = localTimestamp;
 		}
-
-		//if (_lastUpdate == 0.0f)
-		//	_lastUpdate = timestamp;
-
-		//if (timestamp < _lastUpdate)
-		//{
-		//	_networkEngine->printLog(2, "Older update packet received. Dropping it...");
-		//	_lastUpdate = timestamp;
-		//	_packet.clear();
-		//	return;
-		//}
 		_lastUpdate = timestamp;
 	}
 	else
@@ -82,27 +73,66 @@ void	Receiver::handleUpdate()
 	_lastUpdate = timestamp;
 	//_networkEngine->printLog(3, "Update packet received");
 
-	auto it = S_Map->getPlayers()->begin();
-	auto end = S_Map->getPlayers()->end();
-	while (it != end)
+	// Reliable messages the server received
+	if (!_networkEngine->getChannel().readAck(_packet, S_Map->getGlobalClock().getElapsedTime()))
 	{
-		(*it)->setActive(false);
-		++it;
+		_networkEngine->printLog(1, "Unable to extract reliable ack of update packet");
+		return;
 	}
 
-	while (!(_packet.endOfPacket()))
+	// Players are sent as a delta against a snapshot we acked
+	BitReader	reader;
+	sf::Uint32	sequence = 0;
+	sf::Uint32	baseSequence = 0;
+	sf::Uint32	ackedInput = 0;
+	if (reader.load(_packet))
 	{
-		if (!extractWorldData())
-			return;
+		sequence = reader.readBits(32);
+		baseSequence = reader.readVarUint();
+		if (baseSequence != 0)
+			baseSequence = sequence - baseSequence;
+		ackedInput = reader.readVarUint();
+	}
+	if (!reader.isValid())
+	{
+		_networkEngine->printLog(1, "Unable to extract snapshot sequence of update packet");
+		return;
 	}
 
-	it = S_Map->getPlayers()->begin();
-	while (it != end)
+	// Drop old packet update to work only on most recent ones
+	if (sequence <= _lastSnapshot)
 	{
-		if (!(*it)->isActive())
-			ADD_EVENT(ev_DELETE, s_event(*it));
-		++it;
+		_networkEngine->printLog(3, "Older update packet received. Dropping it...");
+		_packet.clear();
+		return;
+	}
+	_ackedInput = ackedInput;
+	_baseSnapshot = _snapshots.find(baseSequence);
+	if (baseSequence != 0 && (!_baseSnapshot || sequence - baseSequence >= SNAPSHOT_HISTORY_SIZE))
+	{
+		_networkEngine->printLog(2, "Update packet based on an unknown snapshot. Dropping it...");
+		_baseSnapshot = NULL;
+		_packet.clear();
+		return;
 	}
+	_currentSnapshot = &_snapshots.push(sequence);
+	_networkEngine->getInterpolation().addSnapshot(timestamp / 1000000.f, S_Map->getGlobalClock().getElapsedTime());
+
+	// Far players are not in every update, they are only removed
+	// when missing from a synchro (see handleSynchro)
+	if (!extractWorldData(reader))
+	{
+		// Partially decoded, must not be used as a base
+		if (_currentSnapshot)
+			_currentSnapshot->invalidate();
+		_currentSnapshot = NULL;
+		_baseSnapshot = NULL;
+		return;
+	}
+	if (_currentSnapshot && sequence > _lastSnapshot)
+		_lastSnapshot = sequence;
+	_currentSnapshot = NULL;
+	_baseSnapshot = NULL;
 }
 
 void	Receiver::handleWelcome()
@@ -119,6 +149,13 @@ void	Receiver::handleWelcome()
 
 	_networkEngine->printLog(2, "Welcome packet received", VIOLET);
 	S_Map->clearMap();
+	_networkEngine->getInterpolation().clear();
+
+	// New server or restarted one, its snapshot sequence starts again
+	_snapshots.clear();
+	_currentSnapshot = NULL;
+	_baseSnapshot = NULL;
+	_lastSnapshot = 0;
 
 	// time update extraction
 	sf::Int32	ms;
@@ -142,8 +179,9 @@ void	Receiver::handleWelcome()
 	S_Map->incScore(scoreOne, scoreTwo);
 
 	// Extract world data
-	while (!(_packet.endOfPacket()))
-		extractWorldData();
+	BitReader	reader;
+	if (reader.load(_packet))
+		extractWorldData(reader);
 
 	// Set time
 	if (S_Map->getCurrentPlayer())
@@ -188,8 +226,41 @@ void	Receiver::handleSynchro()
 	  sf::Time time = sf::milliseconds(ms);
 	  S_Map->setJoinServerTime(time);
 
-	while (!(_packet.endOfPacket()))
-		extractWorldData();
+	// Every player is in the synchro, the missing ones have left
+	auto it = S_Map->getPlayers()->begin();
+	auto end = S_Map->getPlayers()->end();
+	while (it != end)
+	{
+		(*it)->setActive(false);
+		++it;
+	}
+
+	BitReader	reader;
+	if (!reader.load(_packet) || !extractWorldData(reader))
+		return;
+
+	it = S_Map->getPlayers()->begin();
+	end = S_Map->getPlayers()->end();
+	while (it != end)
+	{
+		if (!(*it)->isActive())
+			ADD_EVENT(ev_DELETE, s_event(*it));
+		++it;
+	}
+}
+
+// World data of the synchro (walls / flags...), split in several packets
+void	Receiver::handleWorldData()
+{
+	if (G_conf == NULL)
+	{
+		_packet.clear();
+		return;
+	}
+
+	BitReader	reader;
+	if (reader.load(_packet))
+		extractWorldData(reader);
 }
 
 void	Receiver::handleVersionCheck()
@@ -446,24 +517,39 @@ void	Receiver::handleConfig()
 	//	++it;
 	//}
 
-	// Set new cfg
-	std::string	result;
-	if (!(_packet >> result))
+	// Set new cfg, not sent if we already have it (same hash)
+	sf::Uint32	hash;
+	bool		included;
+	if (!(_packet >> hash >> included))
 	{
 		_networkEngine->printLog(1, "Unable to extract CONFIG packet");
 		return;
 	}
-	ConfigParser	*parse = new ConfigParser;
+	if (included)
+	{
+		t_config	*conf = ConfigSerializer::read(_packet);
 
-	parse->loadString(result);
-	G_conf = (t_config *)parse->parse();
-	_networkEngine->printLog(2, "Event CONFIG packet received. Modifying config file...");
+		if (conf == NULL)
+		{
+			_networkEngine->printLog(1, "Unable to extract CONFIG packet");
+			return;
+		}
+		G_conf = conf;
+		G_confHash = hash;
+		_networkEngine->printLog(2, "Event CONFIG packet received. Modifying config file...");
+	}
+	else if (hash != G_confHash)
+	{
+		_networkEngine->printLog(1, "Config not sent by the server but not cached");
+		return;
+	}
+	else
+		_networkEngine->printLog(2, "Event CONFIG packet received. Cached config used");
 
 	S_Map->setZoom(G_conf->game->zoom);
 
 	ADD_EVENT_SIMPLE(ev_CONFIG_RECEIVED);
 	_networkEngine->getSender()->sendConfirmation(PACKET_CONFIG);
-	delete parse;
 }
 
 void	Receiver::handlePing()
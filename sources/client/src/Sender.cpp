@@ -11,6 +11,7 @@
 #include <cstring>
 #include "Sender.hpp"
 #include "NetworkEngine.hpp"
+#include "Receiver.hpp"
 #include "Manager.hpp"
 #include "Log.hpp"
 #include "Bullet.hpp"
@@ -22,6 +23,11 @@
 #include "Map.hpp"
 #include "HudRessources.hpp"
 #include "AssetPath.h"
+#include "Defines.h"
+#include "ConfigParser.hpp"
+
+extern t_config *G_conf;
+extern sf::Uint32 G_confHash;
 
 ///////////////////////////////////////////////
 /////   Overload of operator <<
@@ -37,6 +43,9 @@ Sender::Sender(NetworkEngine *networkEngine) :
 _networkEngine(networkEngine)
 {
 	_playerActions = NULL;
+	std::memset(&_command, 0, sizeof(_command));
+	_commandTime = sf::Time::Zero;
+	_lastCommand = 0;
 	_packetSequence = PACKET_NONE;
 }
 
@@ -52,6 +61,7 @@ bool	Sender::update()
 {
 	_packet.clear();
 	checkReliableUDP();
+	flushChannel();
 
 	std::shared_ptr<Player>	curPlayer = S_Map->getCurrentPlayer();
 	if (!curPlayer) // Used to first contact serv
@@ -100,7 +110,7 @@ void	Sender::sendMapChange(void)
 		return;
 
 	_packet.clear();
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_REQUEST_CHANGE_MAP)->begin();
 	const char *raw = (const char *)(it->second.data);
 	std::string	filename = raw;
@@ -108,7 +118,7 @@ void	Sender::sendMapChange(void)
 	_packet << PACKET_REQUEST_CHANGE_MAP << filename;
 
 	// Send packet to server
-	if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+	if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 		VC_WARNING_CRITICAL("Error when sending packet map change to " + _networkEngine->getServerIp() + ":" + std::to_string(_networkEngine->getServerPort()));
 }
 
@@ -119,13 +129,13 @@ void	Sender::sendModeChange(void)
 		return;
 
 	_packet.clear();
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_SWITCH_MAP_MODE)->begin();
 	sf::Int16	raw = (sf::Int16)(it->second.data);
 	_packet << PACKET_REQUEST_CHANGE_MODE << raw;
 
 	// Send packet to server
-	if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+	if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 		VC_WARNING_CRITICAL("Error when sending packet mode change to " + _networkEngine->getServerIp() + ":" + std::to_string(_networkEngine->getServerPort()));
 }
 
@@ -134,26 +144,26 @@ void	Sender::sendHordeActivation(void)
 	if (Event::getEventByType(ev_HORDE_ACTIVATE) != NULL)
 	{
 		_packet.clear();
-		std::list<std::pair<eventType, s_event> >::const_iterator it =
+		t_eventList::const_iterator it =
 			Event::getEventByType(ev_HORDE_ACTIVATE)->begin();
 		sf::Uint32 id = (sf::Uint32)(it->second.data);
 		_packet << PACKET_REQUEST_HORDE_ACTIVATE;
 
 		// Send packet to server
-		if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+		if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 			VC_WARNING_CRITICAL("Error when sending horde activate to " + _networkEngine->getServerIp() + ":" + std::to_string(_networkEngine->getServerPort()));
 	}
 
 	if (Event::getEventByType(ev_HORDE_DESACTIVATE) != NULL)
 	{
 		_packet.clear();
-		std::list<std::pair<eventType, s_event> >::const_iterator it =
+		t_eventList::const_iterator it =
 			Event::getEventByType(ev_HORDE_DESACTIVATE)->begin();
 		sf::Uint32 id = (sf::Uint32)(it->second.data);
 		_packet << PACKET_REQUEST_HORDE_DESACTIVATE;
 
 		// Send packet to server
-		if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+		if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 			VC_WARNING_CRITICAL("Error when sending horde desactivate to " + _networkEngine->getServerIp() + ":" + std::to_string(_networkEngine->getServerPort()));
 	}
 }
@@ -164,13 +174,13 @@ void	Sender::sendPlayerKick(void)
 		return;
 
 	_packet.clear();
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_PLAYER_KICK)->begin();
 	sf::Uint32 id = (sf::Uint32)(it->second.data);
 	_packet << PACKET_REQUEST_PLAYER_KICK << id;
 
 	// Send packet to server
-	if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+	if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 		VC_WARNING_CRITICAL("Error when sending player kick to " + _networkEngine->getServerIp() + ":" + std::to_string(_networkEngine->getServerPort()));
 }
 
@@ -180,16 +190,54 @@ void	Sender::sendInput(void)
 	if (Event::getEventByType(ev_PLAYER_ACTION) == NULL)
 		return;
 
+	// Get player input
+	t_eventList::const_iterator it =
+		Event::getEventByType(ev_PLAYER_ACTION)->begin();
+	_playerActions = (s_actions*)(it->second.data);
+
+	// Last move / aim, presses shorter than a command are not lost
+	bool	primary = _command.primary || _playerActions->primary;
+	bool	secondary = _command.secondary || _playerActions->secondary;
+	_command = *_playerActions;
+	_command.primary = primary;
+	_command.secondary = secondary;
+
+	// The server applies one command per tick, they are made at the same rate
+	// Before its config, inputs without command make the server know us
+	unsigned int	made = 0;
+	if (G_conf != NULL && G_conf->server->tickrate > 0)
+	{
+		sf::Time	tickTime = sf::microseconds(1000000 / G_conf->server->tickrate);
+
+		_commandTime += S_Map->getDeltaTime();
+		while (_commandTime >= tickTime && made < INPUT_REDUNDANCY)
+		{
+			// Kept to be applied again after the server position (see Prediction)
+			_lastCommand = _networkEngine->getPrediction().addInput(_command, tickTime);
+			_commands.push_back(_command);
+			if (_commands.size() > INPUT_REDUNDANCY)
+				_commands.pop_front();
+			_command = *_playerActions;
+			_commandTime -= tickTime;
+			++made;
+		}
+		// Long frame, the time left is not caught up
+		if (_commandTime >= tickTime)
+			_commandTime = sf::Time::Zero;
+		if (made == 0)
+			return;
+	}
+
 	_packet.clear();
 	float timestamp;
 	timestamp = S_Map->getClock().getElapsedTime().asMilliseconds();
-	_packet << PACKET_INPUT << timestamp;
+	_packet << PACKET_INPUT << timestamp << _networkEngine->getReceiver()->getLastSnapshot();
+	_networkEngine->getChannel().writeAck(_packet);
 
-	// Get player input
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
-		Event::getEventByType(ev_PLAYER_ACTION)->begin();
-	_playerActions = (s_actions*)(it->second.data);
-	_packet << _playerActions;
+	// Oldest first, the server finds their sequence from the last one
+	_packet << static_cast<sf::Uint8>(_commands.size()) << _lastCommand;
+	for (std::deque<s_actions>::iterator command = _commands.begin(); command != _commands.end(); ++command)
+		_packet << &*command;
 
 	// Send packet
 	if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
@@ -206,7 +254,7 @@ void	Sender::sendMessage()
 		if (str != NULL && str->size() > 0)
 		{
 			_packet << PACKET_EVENT_CHAT << *str;
-			if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+			if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 				_networkEngine->printLog(1, "Unable to send chat message");
 			delete str;
 		}
@@ -233,6 +281,9 @@ void	Sender::sendConfirmation(ePacketType receivedPacket)
 
 	_packet.clear();
 	_packet << PACKET_CONFIRMATION << receivedPacket;
+	// The server does not send its config again if it is the same
+	if (receivedPacket == PACKET_EVENT_IDENT)
+		_packet << G_confHash;
 	_networkEngine->printLogWithId(2, "Sending confirmation packet to server for packet type ", receivedPacket);
 	if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
 		_networkEngine->printLog(1, "Unable to send confirmation");
@@ -260,7 +311,7 @@ void	Sender::sendSwitchTeam()
 	_packet.clear();
 	sf::Uint16 team = (sf::Uint16)events->begin()->second.data;
 	_packet << PACKET_EVENT_JOIN_TEAM << team;
-	if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+	if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 		_networkEngine->printLog(1, "Unable to send team swap");
 }
 
@@ -273,7 +324,7 @@ void	Sender::sendChangeNick()
 	_packet.clear();
 	std::string *str = (std::string *)events->begin()->second.data;
 	_packet << PACKET_NICKNAME_CHANGE << *str;
-	if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+	if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 		_networkEngine->printLog(1, "Unable to send team swap");
 	delete str;
 }
@@ -290,6 +341,25 @@ void	Sender::sendQuit()
 		_networkEngine->printLog(1, "Unable to send quit packet");
 }
 
+///////////////////////////////////////////////
+/////   Events which must not be lost
+/////	Sent at once, then resent each frame until acked (see ReliableChannel)
+
+bool	Sender::sendReliable(eChannel channel)
+{
+	if (!_networkEngine->getChannel().send(_packet, channel))
+		return false;
+	flushChannel();
+	return true;
+}
+
+void	Sender::flushChannel()
+{
+	if (_networkEngine->getChannel().flush(_datagram, S_Map->getGlobalClock().getElapsedTime()) &&
+		_networkEngine->getSocket().send(_datagram, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+		_networkEngine->printLog(1, "Unable to send reliable packet");
+}
+
 void	Sender::finishReliableUdpSequence()
 {
 	_packetSequence = PACKET_NONE;
@@ -335,6 +405,6 @@ void	Sender::sendEvents()
 		index = secondaryAlt->getWeaponIndex();
 	_packet << index;
 
-	if (_networkEngine->getSocket().send(_packet, _networkEngine->getServerIp(), _networkEngine->getServerPort()) != sf::Socket::Done)
+	if (!sendReliable(CHANNEL_RELIABLE_ORDERED))
 		_networkEngine->printLog(1, "Unable to send weapon selection");
 }
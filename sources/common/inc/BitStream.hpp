@@ -0,0 +1,118 @@
+//
+// BitStream.hpp for Void Clash
+//
+
+#ifndef		BITSTREAM_HPP_
+# define	BITSTREAM_HPP_
+
+#include	<string>
+#include	<vector>
+#include	<SFML/Network.hpp>
+
+///////////////////////////////////////////////
+/////   Wire schemas of the world data
+/////	Shared by the server writers (SenderInsertion.cpp)
+/////	and the client readers (ReceiverExtraction.cpp)
+
+#define	WIRE_POS_PRECISION		8.f		// 1/8 unit
+#define	WIRE_POS_BITS			21		// signed, map bounds are +/- 131072 units
+#define	WIRE_SPEED_PRECISION	16.f	// 1/16 unit
+#define	WIRE_SPEED_BITS			17		// max speed 8192
+#define	WIRE_ANGLE_BITS			14		// 0.02 degree
+#define	WIRE_TYPE_BITS			4		// eObjectType (NONE to CAPTURE)
+#define	WIRE_TEAM_BITS			2
+#define	WIRE_TAG_BITS			2		// eWireTag
+#define	WIRE_VAR_LEN_BITS		6		// bit length (0 to 32) before a var uint
+
+// Records of the world data
+enum	eWireTag
+{
+	WIRE_END = 0,	// No more record
+	WIRE_ADD,		// id / type / object
+	WIRE_DELETE,	// id
+	WIRE_PLAYER		// id (delta with the previous player record) / player state delta
+};
+
+// Float field quantized to an integer of nbBits
+struct	s_quantizer
+{
+	float			precision;	// steps per unit
+	unsigned int	nbBits;
+	bool			isSigned;
+};
+
+extern const s_quantizer	WIRE_POSITION;
+extern const s_quantizer	WIRE_SIZE;		// width / height of areas
+extern const s_quantizer	WIRE_SPEED;
+
+sf::Uint32	quantizeAngle(float x, float y, unsigned int nbBits);
+float		unquantizeAngle(sf::Uint32 angle, unsigned int nbBits); // in radian
+
+///////////////////////////////////////////////
+/////   Write values on the minimal number of bits
+/////	appendTo() puts the stream at the end of a packet
+
+class	BitWriter
+{
+public:
+	BitWriter();
+	~BitWriter();
+
+	void	clear();
+
+	void	writeBits(sf::Uint32 value, unsigned int nbBits); // nbBits <= 32
+	void	writeBool(bool value);
+	void	writeSigned(sf::Int32 value, unsigned int nbBits); // Clamped to the range
+	void	writeVarUint(sf::Uint32 value); // Bit length + value, small values are cheap
+	void	writeVarInt(sf::Int32 value);
+	void	writeFloat(float value); // Not quantized, 32 bits
+	void	writeQuantized(float value, const s_quantizer &quantizer);
+	void	writeDirection(float x, float y); // Speed then angle (if moving)
+	void	writeString(const std::string &value);
+
+	void	append(const BitWriter &other);
+
+	// Byte size (Uint16) + bytes, MUST BE the last thing of the packet
+	void	appendTo(sf::Packet &packet) const;
+
+	unsigned int	getBitSize() const;
+
+private:
+	std::vector<sf::Uint8>	_data;		// Full bytes
+	sf::Uint64				_scratch;	// Bits not making a full byte yet
+	unsigned int			_scratchBits;
+};
+
+///////////////////////////////////////////////
+/////   Read a stream written by BitWriter
+/////	Reading past the end returns 0 and marks the reader invalid
+
+class	BitReader
+{
+public:
+	BitReader();
+	~BitReader();
+
+	// Find the stream at the end of the packet, which must outlive the reader
+	bool	load(sf::Packet &packet);
+
+	sf::Uint32	readBits(unsigned int nbBits);
+	bool		readBool();
+	sf::Int32	readSigned(unsigned int nbBits);
+	sf::Uint32	readVarUint();
+	sf::Int32	readVarInt();
+	float		readFloat();
+	float		readQuantized(const s_quantizer &quantizer);
+	void		readDirection(float &x, float &y);
+	void		readString(std::string &value);
+
+	bool	isValid() const;
+
+private:
+	const sf::Uint8	*_data;
+	unsigned int	_bitSize;
+	unsigned int	_bitPos;
+	bool			_valid;
+};
+
+#endif
@@ -0,0 +1,33 @@
+//
+// ConfigSerializer.hpp for Void Clash
+//
+
+#ifndef		CONFIGSERIALIZER_HPP_
+# define	CONFIGSERIALIZER_HPP_
+
+#include	<SFML/Network.hpp>
+#include	"ConfigParser.hpp"
+
+#define	CONFIG_FORMAT_VERSION	1	// Increase when a field is added / removed
+
+///////////////////////////////////////////////
+/////   Binary config (PACKET_CONFIG)
+/////	Format version (Uint8), then player / horde / server / game
+/////	fields in the order of their struct, then the weapons:
+/////	nb (Uint16) / fields of each, sub weapon by name / ratings.
+/////	The server password, match count and metrics port are not sent.
+/////	The server serializes its config once, the hash of the bytes
+/////	lets a client which already has it skip the transfer
+
+class	ConfigSerializer
+{
+public:
+	static void		write(sf::Packet &packet, const t_config &conf);
+	// NULL if truncated or from another format version
+	static t_config	*read(sf::Packet &packet);
+
+	// FNV-1a, 0 is never returned (no config)
+	static sf::Uint32	hash(const void *data, std::size_t size);
+};
+
+#endif
@@ -14,7 +14,7 @@
 ///////////////////////////////
 // Revision version
 // If server and client revision version do not match, client will be warned
-#define	VOID_CLASH_VERSION	31
+#define	VOID_CLASH_VERSION	39
 
 // Auto kick client timeout
 #define	INACTIVITY_TIMEOUT	20.f
@@ -23,6 +23,9 @@
 #define	BIND_PORT_START		13737
 #define	BIND_PORT_END		13750 // MUST BE HIGHER THAN START AND NOT TOO FAR
 
+// Inputs, one command per server tick
+#define	INPUT_REDUNDANCY	4 // Last commands in each PACKET_INPUT, a lost one comes with the next
+
 // DEBUG_LEVEL
 // INFO >= 3
 // WARNING >= 2
@@ -30,6 +33,13 @@
 #define DEBUG_LEVEL 1
 #define ENABLE_OPENGL_CHECK true
 
+// Per thread storage (thread_local is missing from VS2013), POD only
+#if defined (_WIN32)
+#define VC_THREAD_LOCAL	__declspec(thread)
+#else
+#define VC_THREAD_LOCAL	__thread
+#endif
+
 ///////////////////////////////
 // Shared structs
 
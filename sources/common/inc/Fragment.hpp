@@ -0,0 +1,79 @@
+//
+// Fragment.hpp for Void Clash
+//
+
+#ifndef		FRAGMENT_HPP_
+# define	FRAGMENT_HPP_
+
+#include	<bitset>
+#include	<vector>
+#include	<SFML/Network.hpp>
+
+#define	FRAGMENT_DEFAULT_MTU	1200	// in bytes of UDP payload, safe on most links
+#define	FRAGMENT_MIN_MTU		576
+#define	FRAGMENT_HEADER_SIZE	10		// type / message id / index / count / chunk size
+#define	FRAGMENT_MAX_COUNT		255		// fragments of one message
+#define	FRAGMENT_MAX_SIZE		262144	// in bytes, bigger messages are rejected
+#define	FRAGMENT_MAX_PENDING	16		// messages being reassembled at the same time
+#define	FRAGMENT_TIMEOUT		2.f		// in sec, an incomplete message is dropped after it
+
+///////////////////////////////////////////////
+/////   Split a packet too big for one datagram
+/////	Each fragment: type (Uint32) / message id (Uint16) / index (Uint8)
+/////	/ count (Uint8) / chunk size (Uint16) / bytes of the message
+/////	Every fragment but the last one carries chunk size bytes
+
+class	FragmentSplitter
+{
+public:
+	FragmentSplitter(sf::Uint32 fragmentType);
+	~FragmentSplitter();
+
+	// Number of fragments written, 0 if the packet is too big
+	// Fragments are reused between calls
+	unsigned int	split(const sf::Packet &packet, unsigned int mtu);
+	sf::Packet		&getFragment(unsigned int index);
+
+private:
+	sf::Uint32				_fragmentType;
+	sf::Uint16				_nextId;
+	std::vector<sf::Packet>	_fragments;
+};
+
+///////////////////////////////////////////////
+/////   Rebuild the messages from their fragments
+/////	Fragments can come in any order, duplicates are ignored
+
+class	FragmentAssembler
+{
+public:
+	FragmentAssembler(sf::Uint32 fragmentType);
+	~FragmentAssembler();
+
+	// Check the type, without extracting it
+	bool	isFragment(const sf::Packet &packet) const;
+	// True if it completes a message, the packet then holds the message
+	bool	add(sf::Packet &packet, const sf::IpAddress &ip, unsigned short port, sf::Time now);
+
+private:
+	struct	s_message
+	{
+		bool					used;
+		sf::Uint64				sender;		// ip / port
+		sf::Uint16				id;
+		sf::Uint8				count;
+		sf::Uint16				chunkSize;
+		unsigned int			size;		// Known once the last fragment is received
+		unsigned int			received;
+		std::bitset<FRAGMENT_MAX_COUNT>	fragments;
+		sf::Time				start;
+		std::vector<char>		data;
+	};
+
+	s_message	*findMessage(sf::Uint64 sender, sf::Uint16 id, sf::Time now);
+
+	sf::Uint32	_fragmentType;
+	s_message	_messages[FRAGMENT_MAX_PENDING];
+};
+
+#endif
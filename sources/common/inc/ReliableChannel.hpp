@@ -0,0 +1,109 @@
+//
+// ReliableChannel.hpp for Void Clash
+//
+
+#ifndef		RELIABLECHANNEL_HPP_
+# define	RELIABLECHANNEL_HPP_
+
+#include	<deque>
+#include	<map>
+#include	<vector>
+#include	<SFML/Network.hpp>
+
+#define	RELIABLE_MAX_PENDING		256		// messages waiting for an ack, new ones are refused above (the server drops the client)
+#define	RELIABLE_MAX_DATAGRAM_SIZE	1000	// in bytes, one datagram can exceed it with one big message
+#define	RELIABLE_MAX_MESSAGES		255		// in one datagram
+#define	RELIABLE_RECEIVE_WINDOW		1024	// message ids tracked to drop duplicates / buffered ahead
+#define	RELIABLE_SENT_HISTORY		256		// datagrams remembered until acked
+#define	RELIABLE_ACK_BITS			32		// datagrams acked before the last one received
+#define	RELIABLE_INITIAL_RTT		0.1f	// in sec, until the first ack
+#define	RELIABLE_MIN_RTO			0.05f	// in sec, bounds of the retransmission timeout
+#define	RELIABLE_MAX_RTO			1.f
+
+enum	eChannel
+{
+	CHANNEL_UNRELIABLE = 0,			// Sent as is, the latest state replaces it (input / update...)
+	CHANNEL_RELIABLE_UNORDERED,		// Handled as soon as received
+	CHANNEL_RELIABLE_ORDERED		// Handled in the order it was sent (kills, chat...)
+};
+
+///////////////////////////////////////////////
+/////   Reliable messages with one peer
+/////	Messages are whole packets (with their own type), batched
+/////	once per tick in a datagram:
+/////	type (Uint32) / datagram sequence (Uint16) / nb messages (Uint8)
+/////	then for each: channel (Uint8) / message id (Uint16) / size (Uint16) / bytes
+/////
+/////	The peer acks the datagrams it got in its unreliable stream
+/////	(PACKET_UPDATE / PACKET_INPUT): last sequence (Uint16) / bitfield of
+/////	the RELIABLE_ACK_BITS previous ones (Uint32). A message not acked
+/////	after the retransmission timeout (from the measured RTT) goes in the
+/////	next datagram again. Unreliable packets do not go through here
+
+class	ReliableChannel
+{
+public:
+	ReliableChannel(sf::Uint32 reliableType);
+	~ReliableChannel();
+
+	// Queue a message, false if too many are waiting for an ack
+	bool	send(const sf::Packet &message, eChannel channel);
+	// Datagram with the new messages and those to resend, false if none
+	bool	flush(sf::Packet &datagram, sf::Time now);
+
+	// Datagram received, type already extracted
+	// Its messages are then given by popMessage in the right order
+	bool	receive(sf::Packet &datagram);
+	bool	popMessage(sf::Packet &message);
+
+	// Piggybacked on the unreliable stream
+	void	writeAck(sf::Packet &packet) const;
+	bool	readAck(sf::Packet &packet, sf::Time now);
+
+	static bool	isNewer(sf::Uint16 sequence, sf::Uint16 than);
+
+private:
+	struct	s_pendingMessage
+	{
+		sf::Uint32			key;		// Unique, ids of both channels overlap
+		sf::Uint8			channel;
+		sf::Uint16			id;
+		bool				sent;
+		sf::Time			lastSent;
+		std::vector<char>	data;
+	};
+
+	struct	s_sentDatagram
+	{
+		bool					used;
+		sf::Uint16				sequence;
+		sf::Time				time;
+		std::vector<sf::Uint32>	keys;
+	};
+
+	void	ackDatagram(sf::Uint16 sequence, sf::Time now);
+	void	deliver(sf::Uint8 channel, sf::Uint16 id, const char *data, sf::Uint16 size);
+	float	getTimeout() const;
+
+	sf::Uint32	_reliableType;
+
+	// Sending side
+	sf::Uint16	_nextIds[CHANNEL_RELIABLE_ORDERED + 1];
+	sf::Uint16	_sequence;
+	sf::Uint32	_nextKey;
+	std::deque<s_pendingMessage>	_pending;
+	s_sentDatagram	_sent[RELIABLE_SENT_HISTORY];
+	float		_rtt;
+	float		_rttVariance;
+
+	// Receiving side
+	bool		_received;			// At least one datagram received
+	sf::Uint16	_remoteSequence;	// Last datagram received
+	sf::Uint32	_remoteBits;
+	sf::Uint16	_nextOrdered;		// Next ordered id to handle
+	std::map<sf::Uint16, sf::Packet>	_ahead;	// Ordered messages waiting for a previous one
+	sf::Int32	_unorderedIds[RELIABLE_RECEIVE_WINDOW];	// Unordered ids already handled, -1 = none
+	std::deque<sf::Packet>	_delivered;
+};
+
+#endif
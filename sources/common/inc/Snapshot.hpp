@@ -0,0 +1,123 @@
+//
+// Snapshot.hpp for Void Clash
+//
+
+#ifndef		SNAPSHOT_HPP_
+# define	SNAPSHOT_HPP_
+
+#include	<vector>
+#include	<SFML/Network.hpp>
+#include	"BitStream.hpp"
+
+#define	SNAPSHOT_HISTORY_SIZE	64	// in snapshots (0.5 sec at 128 ticks / sec)
+#define	SNAPSHOT_POS_PRECISION	WIRE_POS_PRECISION
+#define	SNAPSHOT_POS_DELTA_BITS	12	// position moved by less than 256 units since the base
+#define	SNAPSHOT_DIR_PRECISION	4.f	// direction speed stored in 1/4 unit
+#define	SNAPSHOT_DIR_BITS		14	// max speed 4096
+#define	SNAPSHOT_AIM_PRECISION	2.f	// aim stored in 1/2 unit, relative to the position
+#define	SNAPSHOT_AIM_BITS		16
+#define	SNAPSHOT_ENERGY_PRECISION	4.f
+#define	SNAPSHOT_ENERGY_BITS	15	// max energy 8192
+#define	SNAPSHOT_MASK_BITS		10
+
+///////////////////////////////////////////////
+/////   Fields of a player state
+/////	Used as a bitmask in delta packets
+
+enum	eSnapshotField
+{
+	SNAP_TEAM		= 1 << 0,
+	SNAP_POSITION	= 1 << 1,
+	SNAP_DIRECTION	= 1 << 2,
+	SNAP_AIM		= 1 << 3,
+	SNAP_SHIELD		= 1 << 4,
+	SNAP_ENERGY		= 1 << 5,
+	SNAP_LIFE		= 1 << 6,
+	SNAP_SCORE		= 1 << 7,	// kills / deaths / score
+	SNAP_LATENCY	= 1 << 8,
+	SNAP_INVUL		= 1 << 9,
+	SNAP_ALL		= (1 << 10) - 1
+};
+
+///////////////////////////////////////////////
+/////   Quantized state of one player
+/////	Same on client and server, so both side
+/////	can rebuild a state from a delta
+
+struct	s_playerState
+{
+	s_playerState();
+
+	sf::Uint32	id;
+	sf::Uint16	team;
+	sf::Int32	x;
+	sf::Int32	y;
+	sf::Uint16	dirAngle;	// WIRE_ANGLE_BITS
+	sf::Uint16	dirSpeed;
+	sf::Int16	aimX;		// Relative to x / y
+	sf::Int16	aimY;
+	sf::Int32	shieldIndex;
+	sf::Uint16	energy;
+	sf::Int16	life;
+	sf::Int16	kills;
+	sf::Int16	deaths;
+	sf::Int16	score;
+	sf::Uint16	latency;	// in ms
+	bool		invul;
+};
+
+sf::Int32	quantizePosition(float value);
+float		unquantizePosition(sf::Int32 value);
+void		quantizeDirection(float x, float y, sf::Uint16 &angle, sf::Uint16 &speed);
+void		unquantizeDirection(sf::Uint16 angle, sf::Uint16 speed, float &x, float &y);
+sf::Int16	quantizeAim(float value, sf::Int32 position);
+float		unquantizeAim(sf::Int16 value, sf::Int32 position);
+sf::Uint16	quantizeEnergy(float value);
+float		unquantizeEnergy(sf::Uint16 value);
+
+// Write mask + changed fields, base NULL = every field
+// Position is a small delta against the base when it can
+void	writePlayerDelta(BitWriter &writer, const s_playerState &state, const s_playerState *base);
+// Apply mask + changed fields on state (which must contain the base)
+bool	readPlayerDelta(BitReader &reader, s_playerState &state);
+
+///////////////////////////////////////////////
+/////   World state at one server tick
+
+class	Snapshot
+{
+public:
+	Snapshot();
+	~Snapshot();
+
+	void	reset(sf::Uint32 sequence);
+	void	invalidate();
+	void	addPlayer(const s_playerState &state);
+
+	sf::Uint32	getSequence() const;
+	const std::vector<s_playerState>	&getPlayers() const;
+	const s_playerState	*findPlayer(sf::Uint32 id) const;
+
+private:
+	sf::Uint32	_sequence;	// 0 = empty slot
+	std::vector<s_playerState>	_players;	// Sorted by id
+};
+
+///////////////////////////////////////////////
+/////   Ring of the last SNAPSHOT_HISTORY_SIZE snapshots
+
+class	SnapshotHistory
+{
+public:
+	SnapshotHistory();
+	~SnapshotHistory();
+
+	Snapshot	&push(sf::Uint32 sequence); // Recycle the oldest snapshot
+	const Snapshot	*find(sf::Uint32 sequence) const; // NULL if unknown or too old
+	void		clear(); // Sequences start again (new server)
+
+private:
+	Snapshot	_ring[SNAPSHOT_HISTORY_SIZE];
+};
+
+#endif
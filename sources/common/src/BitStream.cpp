@@ -0,0 +1,305 @@
+//
+// BitStream.cpp for Void Clash
+//
+
+#include	<cmath>
+#include	<cstring>
+#include	"BitStream.hpp"
+
+#define	BIT_PI	3.14159265358979f
+
+///////////////////////////////////////////////
+/////   Wire schemas
+
+const s_quantizer	WIRE_POSITION = { WIRE_POS_PRECISION, WIRE_POS_BITS, true };
+const s_quantizer	WIRE_SIZE = { WIRE_POS_PRECISION, WIRE_POS_BITS - 1, false };
+const s_quantizer	WIRE_SPEED = { WIRE_SPEED_PRECISION, WIRE_SPEED_BITS, false };
+
+static sf::Uint32	lowMask(unsigned int nbBits)
+{
+	return nbBits >= 32 ? 0xFFFFFFFF : (static_cast<sf::Uint32>(1) << nbBits) - 1;
+}
+
+static sf::Int32	quantize(float value, const s_quantizer &quantizer)
+{
+	double	q = std::floor(value * quantizer.precision + 0.5f);
+	double	min = quantizer.isSigned ? -std::ldexp(1.0, quantizer.nbBits - 1) : 0.0;
+	double	max = (quantizer.isSigned ? std::ldexp(1.0, quantizer.nbBits - 1) : std::ldexp(1.0, quantizer.nbBits)) - 1.0;
+
+	if (q < min)
+		q = min;
+	else if (q > max)
+		q = max;
+	return static_cast<sf::Int32>(static_cast<sf::Int64>(q));
+}
+
+sf::Uint32	quantizeAngle(float x, float y, unsigned int nbBits)
+{
+	float	angle = std::atan2(y, x);
+
+	if (angle < 0)
+		angle += 2 * BIT_PI;
+	return static_cast<sf::Uint32>(std::floor(angle / (2 * BIT_PI) * (1 << nbBits) + 0.5f)) & lowMask(nbBits);
+}
+
+float	unquantizeAngle(sf::Uint32 angle, unsigned int nbBits)
+{
+	return static_cast<float>(angle) * 2 * BIT_PI / (1 << nbBits);
+}
+
+///////////////////////////////////////////////
+/////   Writer
+
+BitWriter::BitWriter()
+{
+	_scratch = 0;
+	_scratchBits = 0;
+}
+
+BitWriter::~BitWriter()
+{
+}
+
+void	BitWriter::clear()
+{
+	_data.clear();
+	_scratch = 0;
+	_scratchBits = 0;
+}
+
+void	BitWriter::writeBits(sf::Uint32 value, unsigned int nbBits)
+{
+	_scratch |= static_cast<sf::Uint64>(value & lowMask(nbBits)) << _scratchBits;
+	_scratchBits += nbBits;
+	while (_scratchBits >= 8)
+	{
+		_data.push_back(static_cast<sf::Uint8>(_scratch & 0xFF));
+		_scratch >>= 8;
+		_scratchBits -= 8;
+	}
+}
+
+void	BitWriter::writeBool(bool value)
+{
+	writeBits(value ? 1 : 0, 1);
+}
+
+void	BitWriter::writeSigned(sf::Int32 value, unsigned int nbBits)
+{
+	sf::Int64	min = -(static_cast<sf::Int64>(1) << (nbBits - 1));
+	sf::Int64	max = (static_cast<sf::Int64>(1) << (nbBits - 1)) - 1;
+
+	if (value < min)
+		value = static_cast<sf::Int32>(min);
+	else if (value > max)
+		value = static_cast<sf::Int32>(max);
+	writeBits(static_cast<sf::Uint32>(value), nbBits);
+}
+
+void	BitWriter::writeVarUint(sf::Uint32 value)
+{
+	unsigned int	nbBits = 0;
+
+	while (nbBits < 32 && (value >> nbBits) != 0)
+		++nbBits;
+	writeBits(nbBits, WIRE_VAR_LEN_BITS);
+	writeBits(value, nbBits);
+}
+
+void	BitWriter::writeVarInt(sf::Int32 value)
+{
+	// Zigzag, small negative values stay small
+	writeVarUint((static_cast<sf::Uint32>(value) << 1) ^ static_cast<sf::Uint32>(value >> 31));
+}
+
+void	BitWriter::writeFloat(float value)
+{
+	sf::Uint32	bits;
+
+	std::memcpy(&bits, &value, sizeof(bits));
+	writeBits(bits, 32);
+}
+
+void	BitWriter::writeQuantized(float value, const s_quantizer &quantizer)
+{
+	if (quantizer.isSigned)
+		writeSigned(quantize(value, quantizer), quantizer.nbBits);
+	else
+		writeBits(static_cast<sf::Uint32>(quantize(value, quantizer)), quantizer.nbBits);
+}
+
+void	BitWriter::writeDirection(float x, float y)
+{
+	sf::Int32	speed = quantize(std::sqrt(x * x + y * y), WIRE_SPEED);
+
+	writeBits(static_cast<sf::Uint32>(speed), WIRE_SPEED.nbBits);
+	if (speed != 0)
+		writeBits(quantizeAngle(x, y, WIRE_ANGLE_BITS), WIRE_ANGLE_BITS);
+}
+
+void	BitWriter::writeString(const std::string &value)
+{
+	writeVarUint(value.size());
+	for (unsigned int i = 0; i < value.size(); ++i)
+		writeBits(static_cast<sf::Uint8>(value[i]), 8);
+}
+
+void	BitWriter::append(const BitWriter &other)
+{
+	for (unsigned int i = 0; i < other._data.size(); ++i)
+		writeBits(other._data[i], 8);
+	writeBits(static_cast<sf::Uint32>(other._scratch), other._scratchBits);
+}
+
+void	BitWriter::appendTo(sf::Packet &packet) const
+{
+	sf::Uint8	last = static_cast<sf::Uint8>(_scratch & 0xFF);
+
+	packet << static_cast<sf::Uint16>(_data.size() + (_scratchBits ? 1 : 0));
+	if (!_data.empty())
+		packet.append(&_data[0], _data.size());
+	if (_scratchBits)
+		packet.append(&last, 1);
+}
+
+unsigned int	BitWriter::getBitSize() const
+{
+	return _data.size() * 8 + _scratchBits;
+}
+
+///////////////////////////////////////////////
+/////   Reader
+
+BitReader::BitReader()
+{
+	_data = NULL;
+	_bitSize = 0;
+	_bitPos = 0;
+	_valid = false;
+}
+
+BitReader::~BitReader()
+{
+}
+
+bool	BitReader::load(sf::Packet &packet)
+{
+	sf::Uint16	size;
+
+	_data = NULL;
+	_bitSize = 0;
+	_bitPos = 0;
+	_valid = false;
+	if (!(packet >> size) || size > packet.getDataSize())
+		return false;
+	_data = static_cast<const sf::Uint8 *>(packet.getData()) + packet.getDataSize() - size;
+	_bitSize = size * 8;
+	_valid = true;
+	return true;
+}
+
+sf::Uint32	BitReader::readBits(unsigned int nbBits)
+{
+	sf::Uint32		value = 0;
+	unsigned int	read = 0;
+
+	if (_bitPos + nbBits > _bitSize)
+	{
+		_valid = false;
+		_bitPos = _bitSize;
+		return 0;
+	}
+	while (read < nbBits)
+	{
+		unsigned int	offset = _bitPos & 7;
+		unsigned int	count = 8 - offset;
+
+		if (count > nbBits - read)
+			count = nbBits - read;
+		value |= static_cast<sf::Uint32>((_data[_bitPos >> 3] >> offset) & lowMask(count)) << read;
+		read += count;
+		_bitPos += count;
+	}
+	return value;
+}
+
+bool	BitReader::readBool()
+{
+	return readBits(1) != 0;
+}
+
+sf::Int32	BitReader::readSigned(unsigned int nbBits)
+{
+	sf::Uint32	value = readBits(nbBits);
+
+	// Sign extension
+	if (nbBits < 32 && (value & (static_cast<sf::Uint32>(1) << (nbBits - 1))))
+		value |= ~lowMask(nbBits);
+	return static_cast<sf::Int32>(value);
+}
+
+sf::Uint32	BitReader::readVarUint()
+{
+	unsigned int	nbBits = readBits(WIRE_VAR_LEN_BITS);
+
+	if (nbBits > 32)
+	{
+		_valid = false;
+		return 0;
+	}
+	return readBits(nbBits);
+}
+
+sf::Int32	BitReader::readVarInt()
+{
+	sf::Uint32	value = readVarUint();
+
+	return static_cast<sf::Int32>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+float	BitReader::readFloat()
+{
+	sf::Uint32	bits = readBits(32);
+	float		value;
+
+	std::memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+float	BitReader::readQuantized(const s_quantizer &quantizer)
+{
+	if (quantizer.isSigned)
+		return static_cast<float>(readSigned(quantizer.nbBits)) / quantizer.precision;
+	return static_cast<float>(readBits(quantizer.nbBits)) / quantizer.precision;
+}
+
+void	BitReader::readDirection(float &x, float &y)
+{
+	float	speed = static_cast<float>(readBits(WIRE_SPEED.nbBits)) / WIRE_SPEED.precision;
+	float	angle = 0;
+
+	if (speed != 0)
+		angle = unquantizeAngle(readBits(WIRE_ANGLE_BITS), WIRE_ANGLE_BITS);
+	x = speed * std::cos(angle);
+	y = speed * std::sin(angle);
+}
+
+void	BitReader::readString(std::string &value)
+{
+	sf::Uint32	size = readVarUint();
+
+	value.clear();
+	if (static_cast<sf::Uint64>(size) * 8 > _bitSize - _bitPos)
+	{
+		_valid = false;
+		return;
+	}
+	value.reserve(size);
+	for (sf::Uint32 i = 0; i < size; ++i)
+		value.push_back(static_cast<char>(readBits(8)));
+}
+
+bool	BitReader::isValid() const
+{
+	return _valid;
+}
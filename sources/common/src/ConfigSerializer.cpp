@@ -0,0 +1,293 @@
+//
+// ConfigSerializer.cpp for Void Clash
+//
+
+#include	"ConfigSerializer.hpp"
+
+///////////////////////////////////////////////
+/////   Sections, read in the order they are written
+
+static void		writeInt(sf::Packet &packet, int value)
+{
+	packet << static_cast<sf::Int32>(value);
+}
+
+static bool		readInt(sf::Packet &packet, int &value)
+{
+	sf::Int32	tmp;
+
+	if (!(packet >> tmp))
+		return false;
+	value = tmp;
+	return true;
+}
+
+static void		writePlayer(sf::Packet &packet, const t_player &player)
+{
+	writeInt(packet, player.acceleration);
+	writeInt(packet, player.max_speed);
+	packet << player.friction;
+	writeInt(packet, player.size);
+	packet << player.velocity;
+	writeInt(packet, player.max_energy);
+	writeInt(packet, player.regen_energy);
+	writeInt(packet, player.life);
+	packet << player.regen_life;
+	writeInt(packet, player.speed_cap);
+	packet << player.invulnerable_time;
+}
+
+static bool		readPlayer(sf::Packet &packet, t_player &player)
+{
+	readInt(packet, player.acceleration);
+	readInt(packet, player.max_speed);
+	packet >> player.friction;
+	readInt(packet, player.size);
+	packet >> player.velocity;
+	readInt(packet, player.max_energy);
+	readInt(packet, player.regen_energy);
+	readInt(packet, player.life);
+	packet >> player.regen_life;
+	readInt(packet, player.speed_cap);
+	packet >> player.invulnerable_time;
+	return packet;
+}
+
+static void		writeHorde(sf::Packet &packet, const t_horde &horde)
+{
+	packet << horde.respawnTime << horde.depopTime;
+	writeInt(packet, horde.speed);
+	writeInt(packet, horde.life);
+	writeInt(packet, horde.size);
+	writeInt(packet, horde.spawn_range);
+	writeInt(packet, horde.damage);
+	writeInt(packet, horde.acceleration);
+}
+
+static bool		readHorde(sf::Packet &packet, t_horde &horde)
+{
+	packet >> horde.respawnTime >> horde.depopTime;
+	readInt(packet, horde.speed);
+	readInt(packet, horde.life);
+	readInt(packet, horde.size);
+	readInt(packet, horde.spawn_range);
+	readInt(packet, horde.damage);
+	readInt(packet, horde.acceleration);
+	return packet;
+}
+
+static void		writeServer(sf::Packet &packet, const t_server &server)
+{
+	packet << server.name;
+	writeInt(packet, server.tickrate);
+	writeInt(packet, server.snapshot_rate);
+	writeInt(packet, server.client_bandwidth);
+	writeInt(packet, server.mtu);
+	writeInt(packet, server.interpolation_delay);
+	writeInt(packet, server.max_player);
+	writeInt(packet, server.min_player);
+}
+
+static bool		readServer(sf::Packet &packet, t_server &server)
+{
+	packet >> server.name;
+	readInt(packet, server.tickrate);
+	readInt(packet, server.snapshot_rate);
+	readInt(packet, server.client_bandwidth);
+	readInt(packet, server.mtu);
+	readInt(packet, server.interpolation_delay);
+	readInt(packet, server.max_player);
+	readInt(packet, server.min_player);
+	return packet;
+}
+
+static void		writeGame(sf::Packet &packet, const t_game &game)
+{
+	writeInt(packet, game.speed);
+	packet << game.zoom;
+	writeInt(packet, game.friendly_fire_own);
+	writeInt(packet, game.friendly_fire_team);
+	writeInt(packet, game.round_nb);
+	packet << game.map;
+	writeInt(packet, game.map_duration);
+	packet << game.mode;
+	writeInt(packet, game.warmup_duration);
+}
+
+static bool		readGame(sf::Packet &packet, t_game &game)
+{
+	readInt(packet, game.speed);
+	packet >> game.zoom;
+	readInt(packet, game.friendly_fire_own);
+	readInt(packet, game.friendly_fire_team);
+	readInt(packet, game.round_nb);
+	packet >> game.map;
+	readInt(packet, game.map_duration);
+	packet >> game.mode;
+	readInt(packet, game.warmup_duration);
+	return packet;
+}
+
+static void		writeWeapon(sf::Packet &packet, const t_weapon &weapon)
+{
+	packet << weapon.name << weapon.category;
+	writeInt(packet, weapon.energy_cost);
+	writeInt(packet, weapon.init_energy_cost);
+	writeInt(packet, weapon.damage);
+	writeInt(packet, weapon.speed);
+	packet << weapon.duration << weapon.fire_rate;
+	writeInt(packet, weapon.size);
+	writeInt(packet, weapon.size_explosion);
+	writeInt(packet, weapon.pushback_fire);
+	writeInt(packet, weapon.pushback_other);
+	writeInt(packet, weapon.acceleration);
+	writeInt(packet, weapon.chain);
+	writeInt(packet, weapon.drain_energy);
+	writeInt(packet, weapon.shot_nb);
+	writeInt(packet, weapon.angle);
+	packet << weapon.collide_walls;
+	writeInt(packet, weapon.bounce);
+	writeInt(packet, weapon.detection_range);
+	writeInt(packet, weapon.life);
+	writeInt(packet, weapon.capacity);
+	writeInt(packet, weapon.slow);
+	packet << weapon.slow_duration;
+	packet << weapon.subWeaponName << weapon.desc;
+
+	// No ratings (NULL) is not the same as empty ones
+	packet << (weapon.ratings != NULL);
+	if (weapon.ratings == NULL)
+		return;
+	packet << static_cast<sf::Uint16>(weapon.ratings->size());
+	for (unsigned int i = 0; i < weapon.ratings->size(); ++i)
+	{
+		packet << weapon.ratings->at(i).first;
+		writeInt(packet, weapon.ratings->at(i).second);
+	}
+}
+
+static bool		readWeapon(sf::Packet &packet, t_weapon &weapon)
+{
+	packet >> weapon.name >> weapon.category;
+	readInt(packet, weapon.energy_cost);
+	readInt(packet, weapon.init_energy_cost);
+	readInt(packet, weapon.damage);
+	readInt(packet, weapon.speed);
+	packet >> weapon.duration >> weapon.fire_rate;
+	readInt(packet, weapon.size);
+	readInt(packet, weapon.size_explosion);
+	readInt(packet, weapon.pushback_fire);
+	readInt(packet, weapon.pushback_other);
+	readInt(packet, weapon.acceleration);
+	readInt(packet, weapon.chain);
+	readInt(packet, weapon.drain_energy);
+	readInt(packet, weapon.shot_nb);
+	readInt(packet, weapon.angle);
+	packet >> weapon.collide_walls;
+	readInt(packet, weapon.bounce);
+	readInt(packet, weapon.detection_range);
+	readInt(packet, weapon.life);
+	readInt(packet, weapon.capacity);
+	readInt(packet, weapon.slow);
+	packet >> weapon.slow_duration;
+	packet >> weapon.subWeaponName >> weapon.desc;
+	weapon.subWeapon = NULL;
+	weapon.ratings = NULL;
+
+	bool		hasRatings;
+	sf::Uint16	nb;
+
+	if (!(packet >> hasRatings) || !hasRatings)
+		return packet;
+	if (!(packet >> nb))
+		return false;
+	weapon.ratings = new std::vector<std::pair<std::string, int> >(nb);
+	for (unsigned int i = 0; i < nb; ++i)
+	{
+		packet >> weapon.ratings->at(i).first;
+		readInt(packet, weapon.ratings->at(i).second);
+	}
+	return packet;
+}
+
+///////////////////////////////////////////////
+/////   Config
+
+void		ConfigSerializer::write(sf::Packet &packet, const t_config &conf)
+{
+	packet << static_cast<sf::Uint8>(CONFIG_FORMAT_VERSION);
+	writePlayer(packet, *conf.player);
+	writeHorde(packet, *conf.horde);
+	writeServer(packet, *conf.server);
+	writeGame(packet, *conf.game);
+	packet << static_cast<sf::Uint16>(conf.weapons->size());
+	for (unsigned int i = 0; i < conf.weapons->size(); ++i)
+		writeWeapon(packet, *conf.weapons->at(i));
+}
+
+t_config	*ConfigSerializer::read(sf::Packet &packet)
+{
+	sf::Uint8	version;
+
+	if (!(packet >> version) || version != CONFIG_FORMAT_VERSION)
+		return NULL;
+
+	t_config	*conf = new t_config();
+	sf::Uint16	nb = 0;
+	bool		valid;
+
+	// Value initialized: what is not sent (server only fields...) is 0, not garbage
+	conf->player = new t_player();
+	conf->horde = new t_horde();
+	conf->server = new t_server();
+	conf->game = new t_game();
+	conf->weapons = new std::vector<t_weapon *>;
+	valid = readPlayer(packet, *conf->player) && readHorde(packet, *conf->horde) &&
+		readServer(packet, *conf->server) && readGame(packet, *conf->game) && (packet >> nb);
+	for (unsigned int i = 0; valid && i < nb; ++i)
+	{
+		conf->weapons->push_back(new t_weapon());
+		valid = readWeapon(packet, *conf->weapons->back());
+	}
+
+	if (!valid)
+	{
+		for (unsigned int i = 0; i < conf->weapons->size(); ++i)
+		{
+			delete conf->weapons->at(i)->ratings;
+			delete conf->weapons->at(i);
+		}
+		delete conf->weapons;
+		delete conf->game;
+		delete conf->server;
+		delete conf->horde;
+		delete conf->player;
+		delete conf;
+		return NULL;
+	}
+
+	// Same as ConfigParser, sub weapons point to the weapon of this name
+	for (unsigned int i = 0; i < conf->weapons->size(); ++i)
+	{
+		for (unsigned int j = 0; j < conf->weapons->size(); ++j)
+		{
+			if (conf->weapons->at(i)->subWeaponName != "" &&
+				conf->weapons->at(i)->subWeaponName == conf->weapons->at(j)->name)
+				conf->weapons->at(i)->subWeapon = conf->weapons->at(j);
+		}
+	}
+	return conf;
+}
+
+sf::Uint32	ConfigSerializer::hash(const void *data, std::size_t size)
+{
+	const sf::Uint8	*bytes = static_cast<const sf::Uint8 *>(data);
+	sf::Uint32		hash = 2166136261u;
+
+	for (std::size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619u;
+	}
+	return hash == 0 ? 1 : hash;
+}
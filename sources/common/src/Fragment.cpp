@@ -0,0 +1,155 @@
+//
+// Fragment.cpp for Void Clash
+//
+
+#include	<cstring>
+#include	"Fragment.hpp"
+
+///////////////////////////////////////////////
+/////   Splitter
+
+FragmentSplitter::FragmentSplitter(sf::Uint32 fragmentType)
+{
+	_fragmentType = fragmentType;
+	_nextId = 0;
+}
+
+FragmentSplitter::~FragmentSplitter()
+{
+}
+
+unsigned int	FragmentSplitter::split(const sf::Packet &packet, unsigned int mtu)
+{
+	const char		*data = static_cast<const char *>(packet.getData());
+	unsigned int	size = packet.getDataSize();
+	unsigned int	chunkSize;
+	unsigned int	count;
+
+	if (mtu < FRAGMENT_MIN_MTU)
+		mtu = FRAGMENT_MIN_MTU;
+	else if (mtu > sf::UdpSocket::MaxDatagramSize)
+		mtu = sf::UdpSocket::MaxDatagramSize;
+	chunkSize = mtu - FRAGMENT_HEADER_SIZE;
+	count = (size + chunkSize - 1) / chunkSize;
+
+	if (count == 0 || count > FRAGMENT_MAX_COUNT || count * chunkSize > FRAGMENT_MAX_SIZE)
+		return 0;
+	if (_fragments.size() < count)
+		_fragments.resize(count);
+
+	sf::Uint16	id = _nextId++;
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		unsigned int	offset = i * chunkSize;
+		unsigned int	length = size - offset < chunkSize ? size - offset : chunkSize;
+
+		_fragments[i].clear();
+		_fragments[i] << _fragmentType << id << static_cast<sf::Uint8>(i)
+			<< static_cast<sf::Uint8>(count) << static_cast<sf::Uint16>(chunkSize);
+		_fragments[i].append(data + offset, length);
+	}
+	return count;
+}
+
+sf::Packet	&FragmentSplitter::getFragment(unsigned int index)
+{
+	return _fragments[index];
+}
+
+///////////////////////////////////////////////
+/////   Assembler
+
+FragmentAssembler::FragmentAssembler(sf::Uint32 fragmentType)
+{
+	_fragmentType = fragmentType;
+	for (unsigned int i = 0; i < FRAGMENT_MAX_PENDING; ++i)
+		_messages[i].used = false;
+}
+
+FragmentAssembler::~FragmentAssembler()
+{
+}
+
+bool	FragmentAssembler::isFragment(const sf::Packet &packet) const
+{
+	const sf::Uint8	*data = static_cast<const sf::Uint8 *>(packet.getData());
+
+	// sf::Packet writes in network byte order
+	return packet.getDataSize() >= FRAGMENT_HEADER_SIZE &&
+		((static_cast<sf::Uint32>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3]) == _fragmentType;
+}
+
+// Message already started, or a new slot (free, timed out, or the oldest one)
+FragmentAssembler::s_message	*FragmentAssembler::findMessage(sf::Uint64 sender, sf::Uint16 id, sf::Time now)
+{
+	s_message	*slot = NULL;
+
+	for (unsigned int i = 0; i < FRAGMENT_MAX_PENDING; ++i)
+	{
+		s_message	&message = _messages[i];
+
+		if (message.used && (now - message.start).asSeconds() > FRAGMENT_TIMEOUT)
+			message.used = false;
+		if (message.used && message.sender == sender && message.id == id)
+			return &message;
+		if (slot == NULL || (slot->used && (!message.used || message.start < slot->start)))
+			slot = &message;
+	}
+	slot->used = false;
+	return slot;
+}
+
+bool	FragmentAssembler::add(sf::Packet &packet, const sf::IpAddress &ip, unsigned short port, sf::Time now)
+{
+	sf::Uint32	type;
+	sf::Uint16	id;
+	sf::Uint8	index;
+	sf::Uint8	count;
+	sf::Uint16	chunkSize;
+
+	if (!(packet >> type >> id >> index >> count >> chunkSize) || type != _fragmentType ||
+		index >= count || chunkSize == 0 || static_cast<unsigned int>(count) * chunkSize > FRAGMENT_MAX_SIZE)
+		return false;
+
+	const char		*data = static_cast<const char *>(packet.getData()) + FRAGMENT_HEADER_SIZE;
+	unsigned int	length = packet.getDataSize() - FRAGMENT_HEADER_SIZE;
+	bool			last = index == count - 1;
+
+	// Only the last fragment can be shorter
+	if ((!last && length != chunkSize) || length > chunkSize)
+		return false;
+
+	sf::Uint64	sender = (static_cast<sf::Uint64>(ip.toInteger()) << 16) | port;
+	s_message	*message = findMessage(sender, id, now);
+	if (!message->used)
+	{
+		message->used = true;
+		message->sender = sender;
+		message->id = id;
+		message->count = count;
+		message->chunkSize = chunkSize;
+		message->size = 0;
+		message->received = 0;
+		message->fragments.reset();
+		message->start = now;
+		message->data.resize(count * chunkSize);
+	}
+	else if (message->count != count || message->chunkSize != chunkSize)
+		return false;
+
+	if (message->fragments.test(index))
+		return false;
+	message->fragments.set(index);
+	++message->received;
+	std::memcpy(&message->data[index * chunkSize], data, length);
+	if (last)
+		message->size = index * chunkSize + length;
+
+	if (message->received < message->count)
+		return false;
+
+	message->used = false;
+	packet.clear();
+	packet.append(&message->data[0], message->size);
+	return true;
+}
@@ -0,0 +1,270 @@
+//
+// ReliableChannel.cpp for Void Clash
+//
+
+#include	<cmath>
+#include	<algorithm>
+#include	"ReliableChannel.hpp"
+
+#define	RELIABLE_HEADER_SIZE			7	// type / sequence / nb messages
+#define	RELIABLE_MESSAGE_HEADER_SIZE	5	// channel / id / size
+
+// sf::Packet writes in network byte order
+static sf::Uint16	readUint16(const sf::Uint8 *data)
+{
+	return static_cast<sf::Uint16>((data[0] << 8) | data[1]);
+}
+
+ReliableChannel::ReliableChannel(sf::Uint32 reliableType)
+{
+	_reliableType = reliableType;
+
+	_nextIds[CHANNEL_RELIABLE_UNORDERED] = 0;
+	_nextIds[CHANNEL_RELIABLE_ORDERED] = 0;
+	_sequence = 1; // 0 is acked by a peer which received nothing yet
+	_nextKey = 0;
+	for (unsigned int i = 0; i < RELIABLE_SENT_HISTORY; ++i)
+		_sent[i].used = false;
+	_rtt = RELIABLE_INITIAL_RTT;
+	_rttVariance = RELIABLE_INITIAL_RTT / 2.f;
+
+	_received = false;
+	_remoteSequence = 0;
+	_remoteBits = 0;
+	_nextOrdered = 0;
+	for (unsigned int i = 0; i < RELIABLE_RECEIVE_WINDOW; ++i)
+		_unorderedIds[i] = -1;
+}
+
+ReliableChannel::~ReliableChannel()
+{
+}
+
+bool	ReliableChannel::isNewer(sf::Uint16 sequence, sf::Uint16 than)
+{
+	sf::Uint16	difference = sequence - than;
+
+	return difference != 0 && difference < 0x8000;
+}
+
+///////////////////////////////////////////////
+/////   Sending side
+
+bool	ReliableChannel::send(const sf::Packet &message, eChannel channel)
+{
+	if (channel == CHANNEL_UNRELIABLE || _pending.size() >= RELIABLE_MAX_PENDING ||
+		message.getDataSize() == 0 || message.getDataSize() > 0xFFFF)
+		return false;
+
+	const char	*data = static_cast<const char *>(message.getData());
+
+	_pending.push_back(s_pendingMessage());
+	s_pendingMessage	&pending = _pending.back();
+	pending.key = _nextKey++;
+	pending.channel = static_cast<sf::Uint8>(channel);
+	pending.id = _nextIds[channel]++;
+	pending.sent = false;
+	pending.data.assign(data, data + message.getDataSize());
+	return true;
+}
+
+bool	ReliableChannel::flush(sf::Packet &datagram, sf::Time now)
+{
+	std::vector<s_pendingMessage *>	messages;
+	unsigned int	size = RELIABLE_HEADER_SIZE;
+	float			timeout = getTimeout();
+
+	// New messages, and those sent once more than the timeout ago
+	for (std::deque<s_pendingMessage>::iterator it = _pending.begin(); it != _pending.end(); ++it)
+	{
+		if (it->sent && (now - it->lastSent).asSeconds() < timeout)
+			continue;
+
+		unsigned int	messageSize = RELIABLE_MESSAGE_HEADER_SIZE + it->data.size();
+
+		if (!messages.empty() && (size + messageSize > RELIABLE_MAX_DATAGRAM_SIZE ||
+			messages.size() == RELIABLE_MAX_MESSAGES))
+			break;
+		size += messageSize;
+		messages.push_back(&*it);
+	}
+	if (messages.empty())
+		return false;
+
+	s_sentDatagram	&record = _sent[_sequence % RELIABLE_SENT_HISTORY];
+	record.used = true;
+	record.sequence = _sequence;
+	record.time = now;
+	record.keys.clear();
+
+	datagram.clear();
+	datagram << _reliableType << _sequence << static_cast<sf::Uint8>(messages.size());
+	for (std::vector<s_pendingMessage *>::iterator it = messages.begin(); it != messages.end(); ++it)
+	{
+		s_pendingMessage	*message = *it;
+
+		datagram << message->channel << message->id << static_cast<sf::Uint16>(message->data.size());
+		datagram.append(&message->data[0], message->data.size());
+		message->sent = true;
+		message->lastSent = now;
+		record.keys.push_back(message->key);
+	}
+
+	if (++_sequence == 0)
+		_sequence = 1;
+	return true;
+}
+
+bool	ReliableChannel::readAck(sf::Packet &packet, sf::Time now)
+{
+	sf::Uint16	ack;
+	sf::Uint32	bits;
+
+	if (!(packet >> ack >> bits))
+		return false;
+	ackDatagram(ack, now);
+	for (sf::Uint16 i = 0; i < RELIABLE_ACK_BITS; ++i)
+	{
+		if (bits & (1u << i))
+			ackDatagram(ack - 1 - i, now);
+	}
+	return true;
+}
+
+void	ReliableChannel::ackDatagram(sf::Uint16 sequence, sf::Time now)
+{
+	s_sentDatagram	&record = _sent[sequence % RELIABLE_SENT_HISTORY];
+
+	// Unknown, too old or already acked
+	if (!record.used || record.sequence != sequence)
+		return;
+	record.used = false;
+
+	// Each datagram is sent once, the sample is never from a retransmission
+	float	sample = (now - record.time).asSeconds();
+	_rttVariance = 0.75f * _rttVariance + 0.25f * std::fabs(_rtt - sample);
+	_rtt = 0.875f * _rtt + 0.125f * sample;
+
+	// Keys are increasing in both
+	std::vector<sf::Uint32>	&keys = record.keys;
+	_pending.erase(std::remove_if(_pending.begin(), _pending.end(),
+		[&keys](const s_pendingMessage &message)
+		{
+			return std::binary_search(keys.begin(), keys.end(), message.key);
+		}), _pending.end());
+}
+
+float	ReliableChannel::getTimeout() const
+{
+	return std::min(std::max(_rtt + 4.f * _rttVariance, RELIABLE_MIN_RTO), RELIABLE_MAX_RTO);
+}
+
+///////////////////////////////////////////////
+/////   Receiving side
+
+void	ReliableChannel::writeAck(sf::Packet &packet) const
+{
+	packet << _remoteSequence << _remoteBits;
+}
+
+bool	ReliableChannel::receive(sf::Packet &datagram)
+{
+	const sf::Uint8	*data = static_cast<const sf::Uint8 *>(datagram.getData());
+	unsigned int	size = datagram.getDataSize();
+	unsigned int	offset = RELIABLE_HEADER_SIZE;
+
+	// Read from the start, the type is skipped
+	// Checked before anything is acked or handled
+	if (size < RELIABLE_HEADER_SIZE)
+		return false;
+	sf::Uint16	sequence = readUint16(data + 4);
+	sf::Uint8	count = data[6];
+	for (sf::Uint8 i = 0; i < count; ++i)
+	{
+		if (offset + RELIABLE_MESSAGE_HEADER_SIZE > size)
+			return false;
+
+		sf::Uint8	channel = data[offset];
+
+		offset += RELIABLE_MESSAGE_HEADER_SIZE + readUint16(data + offset + 3);
+		if (offset > size || (channel != CHANNEL_RELIABLE_UNORDERED && channel != CHANNEL_RELIABLE_ORDERED))
+			return false;
+	}
+
+	// Bit i is set if the datagram (last - 1 - i) was received
+	if (!_received)
+	{
+		_received = true;
+		_remoteSequence = sequence;
+		_remoteBits = 0;
+	}
+	else if (isNewer(sequence, _remoteSequence))
+	{
+		sf::Uint16	shift = sequence - _remoteSequence;
+
+		_remoteBits = shift < RELIABLE_ACK_BITS ? _remoteBits << shift : 0;
+		if (shift <= RELIABLE_ACK_BITS)
+			_remoteBits |= 1u << (shift - 1);
+		_remoteSequence = sequence;
+	}
+	else if (sequence != _remoteSequence)
+	{
+		sf::Uint16	age = _remoteSequence - sequence;
+
+		if (age <= RELIABLE_ACK_BITS)
+			_remoteBits |= 1u << (age - 1);
+	}
+
+	offset = RELIABLE_HEADER_SIZE;
+	for (sf::Uint8 i = 0; i < count; ++i)
+	{
+		sf::Uint16	length = readUint16(data + offset + 3);
+
+		deliver(data[offset], readUint16(data + offset + 1),
+			reinterpret_cast<const char *>(data + offset + RELIABLE_MESSAGE_HEADER_SIZE), length);
+		offset += RELIABLE_MESSAGE_HEADER_SIZE + length;
+	}
+	return true;
+}
+
+// Duplicates (resent before the ack came back) are dropped
+void	ReliableChannel::deliver(sf::Uint8 channel, sf::Uint16 id, const char *data, sf::Uint16 size)
+{
+	sf::Packet	message;
+
+	message.append(data, size);
+	if (channel == CHANNEL_RELIABLE_UNORDERED)
+	{
+		sf::Int32	&handled = _unorderedIds[id % RELIABLE_RECEIVE_WINDOW];
+
+		if (handled == id)
+			return;
+		handled = id;
+		_delivered.push_back(message);
+	}
+	else if (id == _nextOrdered)
+	{
+		_delivered.push_back(message);
+		++_nextOrdered;
+
+		// Messages which were waiting for this one
+		std::map<sf::Uint16, sf::Packet>::iterator	it;
+		while ((it = _ahead.find(_nextOrdered)) != _ahead.end())
+		{
+			_delivered.push_back(it->second);
+			_ahead.erase(it);
+			++_nextOrdered;
+		}
+	}
+	else if (isNewer(id, _nextOrdered) && static_cast<sf::Uint16>(id - _nextOrdered) < RELIABLE_RECEIVE_WINDOW)
+		_ahead.insert(std::make_pair(id, message));
+}
+
+bool	ReliableChannel::popMessage(sf::Packet &message)
+{
+	if (_delivered.empty())
+		return false;
+	message = _delivered.front();
+	_delivered.pop_front();
+	return true;
+}
@@ -0,0 +1,304 @@
+//
+// Snapshot.cpp for Void Clash
+//
+
+#include	<cmath>
+#include	<algorithm>
+#include	"Snapshot.hpp"
+
+///////////////////////////////////////////////
+/////   Quantization
+
+sf::Int32	quantizePosition(float value)
+{
+	return static_cast<sf::Int32>(std::floor(value * SNAPSHOT_POS_PRECISION + 0.5f));
+}
+
+float	unquantizePosition(sf::Int32 value)
+{
+	return static_cast<float>(value) / SNAPSHOT_POS_PRECISION;
+}
+
+void	quantizeDirection(float x, float y, sf::Uint16 &angle, sf::Uint16 &speed)
+{
+	float	q = std::floor(std::sqrt(x * x + y * y) * SNAPSHOT_DIR_PRECISION + 0.5f);
+	if (q > (1 << SNAPSHOT_DIR_BITS) - 1)
+		q = (1 << SNAPSHOT_DIR_BITS) - 1;
+	speed = static_cast<sf::Uint16>(q);
+	angle = 0;
+	if (speed != 0)
+		angle = static_cast<sf::Uint16>(quantizeAngle(x, y, WIRE_ANGLE_BITS));
+}
+
+void	unquantizeDirection(sf::Uint16 angle, sf::Uint16 speed, float &x, float &y)
+{
+	float	radian = unquantizeAngle(angle, WIRE_ANGLE_BITS);
+
+	x = static_cast<float>(speed) / SNAPSHOT_DIR_PRECISION * std::cos(radian);
+	y = static_cast<float>(speed) / SNAPSHOT_DIR_PRECISION * std::sin(radian);
+}
+
+sf::Int16	quantizeAim(float value, sf::Int32 position)
+{
+	float	q = std::floor((value - unquantizePosition(position)) * SNAPSHOT_AIM_PRECISION + 0.5f);
+	if (q > 32767.f)
+		q = 32767.f;
+	else if (q < -32768.f)
+		q = -32768.f;
+	return static_cast<sf::Int16>(q);
+}
+
+float	unquantizeAim(sf::Int16 value, sf::Int32 position)
+{
+	return unquantizePosition(position) + static_cast<float>(value) / SNAPSHOT_AIM_PRECISION;
+}
+
+sf::Uint16	quantizeEnergy(float value)
+{
+	float	q = std::floor(value * SNAPSHOT_ENERGY_PRECISION + 0.5f);
+	if (q > (1 << SNAPSHOT_ENERGY_BITS) - 1)
+		q = (1 << SNAPSHOT_ENERGY_BITS) - 1;
+	else if (q < 0)
+		q = 0;
+	return static_cast<sf::Uint16>(q);
+}
+
+float	unquantizeEnergy(sf::Uint16 value)
+{
+	return static_cast<float>(value) / SNAPSHOT_ENERGY_PRECISION;
+}
+
+///////////////////////////////////////////////
+/////   Player state
+
+s_playerState::s_playerState() :
+	id(0), team(0), x(0), y(0), dirAngle(0), dirSpeed(0), aimX(0), aimY(0),
+	shieldIndex(-1), energy(0), life(0), kills(0), deaths(0), score(0),
+	latency(0), invul(false)
+{
+}
+
+// Delta against the base position if it fits, absolute otherwise
+static void	writePosition(BitWriter &writer, sf::Int32 value, const sf::Int32 *base)
+{
+	sf::Int32	limit = 1 << (SNAPSHOT_POS_DELTA_BITS - 1);
+
+	if (base && value - *base >= -limit && value - *base < limit)
+	{
+		writer.writeBool(true);
+		writer.writeSigned(value - *base, SNAPSHOT_POS_DELTA_BITS);
+	}
+	else
+	{
+		writer.writeBool(false);
+		writer.writeSigned(value, WIRE_POS_BITS);
+	}
+}
+
+static sf::Int32	readPosition(BitReader &reader, sf::Int32 base)
+{
+	if (reader.readBool())
+		return base + reader.readSigned(SNAPSHOT_POS_DELTA_BITS);
+	return reader.readSigned(WIRE_POS_BITS);
+}
+
+void	writePlayerDelta(BitWriter &writer, const s_playerState &state, const s_playerState *base)
+{
+	sf::Uint16	mask = SNAP_ALL;
+
+	if (base)
+	{
+		mask = 0;
+		if (state.team != base->team)
+			mask |= SNAP_TEAM;
+		if (state.x != base->x || state.y != base->y)
+			mask |= SNAP_POSITION;
+		if (state.dirAngle != base->dirAngle || state.dirSpeed != base->dirSpeed)
+			mask |= SNAP_DIRECTION;
+		if (state.aimX != base->aimX || state.aimY != base->aimY)
+			mask |= SNAP_AIM;
+		if (state.shieldIndex != base->shieldIndex)
+			mask |= SNAP_SHIELD;
+		if (state.energy != base->energy)
+			mask |= SNAP_ENERGY;
+		if (state.life != base->life)
+			mask |= SNAP_LIFE;
+		if (state.kills != base->kills || state.deaths != base->deaths || state.score != base->score)
+			mask |= SNAP_SCORE;
+		if (state.latency != base->latency)
+			mask |= SNAP_LATENCY;
+		if (state.invul != base->invul)
+			mask |= SNAP_INVUL;
+	}
+
+	writer.writeBits(mask, SNAPSHOT_MASK_BITS);
+	if (mask & SNAP_TEAM)
+		writer.writeBits(state.team, WIRE_TEAM_BITS);
+	if (mask & SNAP_POSITION)
+	{
+		writePosition(writer, state.x, base ? &base->x : NULL);
+		writePosition(writer, state.y, base ? &base->y : NULL);
+	}
+	if (mask & SNAP_DIRECTION)
+	{
+		writer.writeBits(state.dirSpeed, SNAPSHOT_DIR_BITS);
+		if (state.dirSpeed != 0)
+			writer.writeBits(state.dirAngle, WIRE_ANGLE_BITS);
+	}
+	if (mask & SNAP_AIM)
+	{
+		writer.writeSigned(state.aimX, SNAPSHOT_AIM_BITS);
+		writer.writeSigned(state.aimY, SNAPSHOT_AIM_BITS);
+	}
+	if (mask & SNAP_SHIELD)
+		writer.writeVarInt(state.shieldIndex);
+	if (mask & SNAP_ENERGY)
+		writer.writeBits(state.energy, SNAPSHOT_ENERGY_BITS);
+	if (mask & SNAP_LIFE)
+		writer.writeVarInt(state.life);
+	if (mask & SNAP_SCORE)
+	{
+		writer.writeVarInt(state.kills);
+		writer.writeVarInt(state.deaths);
+		writer.writeVarInt(state.score);
+	}
+	if (mask & SNAP_LATENCY)
+		writer.writeVarUint(state.latency);
+	if (mask & SNAP_INVUL)
+		writer.writeBool(state.invul);
+}
+
+bool	readPlayerDelta(BitReader &reader, s_playerState &state)
+{
+	sf::Uint16	mask = static_cast<sf::Uint16>(reader.readBits(SNAPSHOT_MASK_BITS));
+
+	if (mask & SNAP_TEAM)
+		state.team = static_cast<sf::Uint16>(reader.readBits(WIRE_TEAM_BITS));
+	if (mask & SNAP_POSITION)
+	{
+		state.x = readPosition(reader, state.x);
+		state.y = readPosition(reader, state.y);
+	}
+	if (mask & SNAP_DIRECTION)
+	{
+		state.dirSpeed = static_cast<sf::Uint16>(reader.readBits(SNAPSHOT_DIR_BITS));
+		state.dirAngle = 0;
+		if (state.dirSpeed != 0)
+			state.dirAngle = static_cast<sf::Uint16>(reader.readBits(WIRE_ANGLE_BITS));
+	}
+	if (mask & SNAP_AIM)
+	{
+		state.aimX = static_cast<sf::Int16>(reader.readSigned(SNAPSHOT_AIM_BITS));
+		state.aimY = static_cast<sf::Int16>(reader.readSigned(SNAPSHOT_AIM_BITS));
+	}
+	if (mask & SNAP_SHIELD)
+		state.shieldIndex = reader.readVarInt();
+	if (mask & SNAP_ENERGY)
+		state.energy = static_cast<sf::Uint16>(reader.readBits(SNAPSHOT_ENERGY_BITS));
+	if (mask & SNAP_LIFE)
+		state.life = static_cast<sf::Int16>(reader.readVarInt());
+	if (mask & SNAP_SCORE)
+	{
+		state.kills = static_cast<sf::Int16>(reader.readVarInt());
+		state.deaths = static_cast<sf::Int16>(reader.readVarInt());
+		state.score = static_cast<sf::Int16>(reader.readVarInt());
+	}
+	if (mask & SNAP_LATENCY)
+		state.latency = static_cast<sf::Uint16>(reader.readVarUint());
+	if (mask & SNAP_INVUL)
+		state.invul = reader.readBool();
+	return reader.isValid();
+}
+
+///////////////////////////////////////////////
+/////   Snapshot
+
+static bool	lowerId(const s_playerState &state, sf::Uint32 id)
+{
+	return state.id < id;
+}
+
+Snapshot::Snapshot()
+{
+	_sequence = 0;
+}
+
+Snapshot::~Snapshot()
+{
+}
+
+void	Snapshot::reset(sf::Uint32 sequence)
+{
+	_sequence = sequence;
+	_players.clear();
+}
+
+void	Snapshot::invalidate()
+{
+	reset(0);
+}
+
+void	Snapshot::addPlayer(const s_playerState &state)
+{
+	// Players usually come sorted, so it is nearly always a push_back
+	if (_players.empty() || _players.back().id < state.id)
+		_players.push_back(state);
+	else
+		_players.insert(std::lower_bound(_players.begin(), _players.end(), state.id, lowerId), state);
+}
+
+sf::Uint32	Snapshot::getSequence() const
+{
+	return _sequence;
+}
+
+const std::vector<s_playerState>	&Snapshot::getPlayers() const
+{
+	return _players;
+}
+
+const s_playerState	*Snapshot::findPlayer(sf::Uint32 id) const
+{
+	std::vector<s_playerState>::const_iterator it =
+		std::lower_bound(_players.begin(), _players.end(), id, lowerId);
+
+	if (it != _players.end() && it->id == id)
+		return &(*it);
+	return NULL;
+}
+
+///////////////////////////////////////////////
+/////   Snapshot history
+
+SnapshotHistory::SnapshotHistory()
+{
+}
+
+SnapshotHistory::~SnapshotHistory()
+{
+}
+
+Snapshot	&SnapshotHistory::push(sf::Uint32 sequence)
+{
+	Snapshot	&snapshot = _ring[sequence % SNAPSHOT_HISTORY_SIZE];
+
+	snapshot.reset(sequence);
+	return snapshot;
+}
+
+const Snapshot	*SnapshotHistory::find(sf::Uint32 sequence) const
+{
+	if (sequence == 0)
+		return NULL;
+
+	const Snapshot	&snapshot = _ring[sequence % SNAPSHOT_HISTORY_SIZE];
+	if (snapshot.getSequence() != sequence)
+		return NULL;
+	return &snapshot;
+}
+
+void	SnapshotHistory::clear()
+{
+	for (unsigned int i = 0; i < SNAPSHOT_HISTORY_SIZE; ++i)
+		_ring[i].invalidate();
+}
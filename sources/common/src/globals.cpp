@@ -1,13 +1,16 @@
 #include "ConfigParser.hpp"
 #include "Defines.h"
+#include <SFML/Config.hpp>
+#include <atomic>
 
 int	sizeX = 0;
 int	sizeY = 0;
 int	volume = 100;
 t_config *G_conf = NULL;
+sf::Uint32 G_confHash = 0;	// Hash of the server config in G_conf, 0 for a local one
 bool G_isServer = false;
 bool G_isOffline = false;
-int G_id = 1;
+std::atomic<int> G_id(1);	// Ids of the objects, shared by all the matches
 std::string G_ip = "0";
 int G_port = BIND_PORT_START;
 
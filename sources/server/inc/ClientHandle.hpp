@@ -11,7 +11,16 @@
 #ifndef		CLIENT_HPP_
 # define	CLIENT_HPP_
 
+#include	<deque>
 #include	<SFML/Network.hpp>
+#include	"ClientInterest.hpp"
+#include	"SendScheduler.hpp"
+#include	"ReliableChannel.hpp"
+#include	"Actions.hpp"
+
+#define	INPUT_QUEUE_MAX		8	// commands waiting, the oldest are dropped above (bursts)
+#define	INPUT_QUEUE_WINDOW	64	// in ticks, the queue length is watched over this
+#define	INPUT_QUEUE_TARGET	1	// commands always waiting over a window, more add delay and one is skipped
 
 class	Player;
 
@@ -26,17 +35,28 @@ public:
   bool	ping();
   void	pong(sf::Packet &packet);
 
-  void		setActions(sf::Packet &);
+  void		setActions(sf::Packet &, sf::Time arrival);
+  void		applyActions(); // Next command, once per tick
   void		resetActions();
   
   const sf::IpAddress	&getIp() const;
   unsigned short getPort() const;
   std::shared_ptr<Player>	getPlayer() const;
+  sf::Uint32	getAckedSnapshot() const;
+  sf::Uint32	getLastInput() const; // Sent back in snapshots for the client prediction
+  sf::Time	getLastInputArrival() const; // Global clock time the last input was received by the socket
+  ClientInterest	&getInterest();
+  SendScheduler		&getScheduler();
+  ReliableChannel	&getChannel();
+  sf::Uint32	getInputs() const; // Commands received
+  sf::Uint32	getInputsLost() const; // Commands never received, even with the redundancy
 
   // Activity
   void	active(sf::Time time);
   bool	isActive(sf::Time time); // True if server got a client reply since less than DECONNECTION_TIMEOUT
   bool	isResponsive(sf::Time time); // True if server got a client reply since less than INACTIVITY_TIMEOUT
+  void	drop(); // Not active anymore, disconnected by the next activity check
+  bool	isDropped() const;
 
   void	setStarted(bool started);
 
@@ -50,6 +70,26 @@ private:
 
   sf::Time		_lastActivity;
   float			_lastUpdateInput;
+  sf::Time		_lastInputArrival;
+  sf::Uint32		_ackedSnapshot; // Last snapshot received by the client (delta base)
+  sf::Uint32		_lastInput; // Sequence of the actions applied, 0 = none
+
+  // Commands received, one is applied each tick
+  struct	s_command
+  {
+    sf::Uint32	sequence;
+    s_actions	actions;
+  };
+  void	dropCommand();
+  std::deque<s_command>	_commands;
+  sf::Uint32		_lastQueued; // Sequence of _commands.back(), redundant copies are ignored
+  sf::Uint32		_inputs;
+  sf::Uint32		_inputsLost;
+  unsigned int		_queueTicks;
+  unsigned int		_queueMin; // Fewest commands waiting since the window started
+  ClientInterest	_interest; // What is replicated to the client
+  SendScheduler		_scheduler; // When it is sent
+  ReliableChannel	_channel; // Gameplay events which must not be lost
 
   sf::IpAddress		_ip;
   unsigned short	_port;
@@ -61,6 +101,7 @@ private:
   s_actions		*_actions;
   bool	_admin;
   bool	_started;
+  bool	_dropped;
 };
 
 
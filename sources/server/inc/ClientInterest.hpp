@@ -0,0 +1,91 @@
+//
+// ClientInterest.hpp for Void Clash
+//
+
+#ifndef		CLIENTINTEREST_HPP_
+# define	CLIENTINTEREST_HPP_
+
+#include	<vector>
+#include	<SFML/System.hpp>
+#include	"Snapshot.hpp"
+
+class	AObject;
+class	Player;
+
+// Visible area of a client, from the camera of the client
+// (at zoom * 1700 units, 45 degrees of vertical fov)
+#define	AOI_VIEW_HALF_HEIGHT	705.f	// per zoom unit
+#define	AOI_VIEW_RATIO			1.78f	// 16/9 screens
+#define	AOI_MARGIN				1000.f	// Objects just outside the screen are still relevant
+
+// Players out of view are sent at a lower rate
+#define	AOI_FAR_PRIORITY		0.5f	// priority at 1 view distance out of the view
+#define	AOI_MIN_PRIORITY		0.0625f	// 1 update every 16 ticks at least
+
+// Projectiles are sent if they cross the view within this time
+#define	AOI_PREDICTION_TIME		1.f		// in sec
+
+// Axis aligned box
+struct	s_area
+{
+	float	left;
+	float	top;
+	float	right;
+	float	bottom;
+};
+
+///////////////////////////////////////////////
+/////   Area of interest of one client
+/////	Decides which players / projectiles are replicated to him
+/////	Players far from the view accumulate priority each tick
+/////	and are sent when it reaches 1
+/////	Spectators see everything, nothing is filtered
+
+class	ClientInterest
+{
+public:
+	ClientInterest();
+	~ClientInterest();
+
+	// View of this tick, centered on the player of the client
+	void	update(const Player &player);
+	bool	isFiltering() const;
+	bool	isRelevant(const s_area &area) const;
+
+	// Players, called in id order for each snapshot sent to the client
+	void	beginSnapshot(sf::Uint32 sequence);
+	bool	mustSendPlayer(const s_playerState &state, sf::Uint32 ownId);
+	// True if the player was in the snapshot sent with this sequence
+	// (if not, the client cannot use it as a delta base)
+	bool	wasSent(sf::Uint32 sequence, sf::Uint32 id) const;
+
+	// Area crossed by a projectile in the next AOI_PREDICTION_TIME
+	static void	getSweptArea(const AObject &obj, s_area &area);
+
+private:
+	struct	s_priority
+	{
+		sf::Uint32	id;
+		float		value;
+	};
+
+	struct	s_sent
+	{
+		sf::Uint32				sequence;
+		std::vector<sf::Uint32>	ids;	// Sorted
+	};
+
+	bool	_filtering;
+	s_area	_view;	// With the margin
+	float	_viewDistance;
+
+	// Sorted by id, swapped each snapshot to drop the players who left
+	std::vector<s_priority>	_priorities;
+	std::vector<s_priority>	_previousPriorities;
+	unsigned int			_cursor;
+
+	s_sent		_sent[SNAPSHOT_HISTORY_SIZE];
+	s_sent		*_current;
+};
+
+#endif
@@ -11,6 +11,7 @@
 #ifndef		MANAGER_HPP_
 # define	MANAGER_HPP_
 
+#include	<vector>
 #include	"GameEngine.hpp"
 #include	"AObject.hpp"
 #include	"NetworkEngine.hpp"
@@ -20,11 +21,18 @@
 #include	"MapDatabase.hpp"
 #include	"AEngine.hpp"
 
+class	Match;
+class	NetworkIo;
+class	MatchScheduler;
+class	MetricsServer;
+class	WebSender;
+
 ///////////////////////////////////////////////
-/////   This class is used to initialize engines
-/////	and stock ptr to each engine
+/////   This class is used to initialize the matches
+/////	(t_server::matches) and the socket they share
 
-/////	Also used to main loop
+/////	Also used to main loop, the matches are ticked by the
+/////	MatchScheduler workers
 
 class		Manager
 {
@@ -38,17 +46,16 @@ public:
 
   //------------------------------------------------------------------//
 
-  // Game content management
-  void addNewObjects(void);
-  void deleteObjects(void);
+  const std::vector<Match *>	&getMatches() const;
 
 private:
-  // Engines
-  GameEngine	*_gameEngine;
-  NetworkEngine	*_networkEngine;
-  PhysicEngine	*_physicEngine;
+  std::vector<Match *>	_matches;
+  MatchScheduler	*_scheduler;	// Ticks the matches
+  NetworkIo		*_networkIo;	// Socket of all the matches
+  WebSender		*_webSender;	// Communicate with central server
+  MetricsServer	*_metricsServer;	// Local endpoint, t_server::metrics_port
+
+  sf::Time		_tickTime; // From t_server::tickrate
 };
 
-bool	sameAObject(std::pair<eventType, s_event> one, std::pair<eventType, s_event> two);
-bool    superiorAddr(std::pair<eventType, s_event> one, std::pair<eventType, s_event> two);
 #endif		/* MANAGER_HPP_ */
@@ -0,0 +1,74 @@
+//
+// Match.hpp for Void Clash
+//
+
+#ifndef		MATCH_HPP_
+# define	MATCH_HPP_
+
+#include	"GameEngine.hpp"
+#include	"PhysicEngine.hpp"
+#include	"Event.hpp"
+#include	"Map.hpp"
+#include	"Metrics.hpp"
+
+class	NetworkEngine;
+class	NetworkIo;
+
+///////////////////////////////////////////////
+/////   One game hosted by the server
+/////	Owns its map (mode / rotation), its events, its engines and
+/////	its clients. S_Map / Event / GPhysicEngine are per thread:
+/////	bind() makes them this match's before running its code.
+/////	The config (G_conf) is shared by all the matches
+/////	Each step of a tick is timed in its metrics
+/////	Its status (players / map / mode) is copied once per
+/////	METRICS_SAMPLE_PERIOD for the central server heartbeat
+
+class	Match
+{
+public:
+  struct	s_status
+  {
+    unsigned int	players;
+    std::string		map;
+    std::string		mode;
+  };
+
+  Match(unsigned int id, NetworkIo *io);
+  ~Match();
+
+  // Before the NetworkIo starts, it does not lock its engines
+  void	start();
+  void	stop();		// Kick the players
+  bool	tick();		// One simulation step, false when the game asks to exit
+
+  void	bind();
+
+  unsigned int		getId() const;
+  Map::MapUtils		*getMap();
+  NetworkEngine		*getNetworkEngine();
+  MatchMetrics		*getMetrics();
+  s_status			getStatus() const;	// Last published, from any thread
+
+private:
+  Match(const Match &);
+  Match	&operator=(const Match &);
+
+  void	endPhase(eTickPhase phase, sf::Time &start);
+  void	sample();	// Entities and clients, for the metrics
+  void	publishStatus();
+
+  unsigned int		_id;
+  NetworkIo			*_io;
+  Map::MapUtils		*_map;
+  Event::EventUtils	*_events;
+  GameEngine		*_gameEngine;
+  PhysicEngine		*_physicEngine;
+  NetworkEngine		*_networkEngine;
+  MatchMetrics		_metrics;
+  sf::Time			_nextSample;
+  mutable sf::Mutex	_statusMutex;
+  s_status			_status;
+};
+
+#endif
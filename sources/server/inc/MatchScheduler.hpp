@@ -0,0 +1,97 @@
+//
+// MatchScheduler.hpp for Void Clash
+//
+
+#ifndef		MATCHSCHEDULER_HPP_
+# define	MATCHSCHEDULER_HPP_
+
+#include	<SFML/System.hpp>
+#include	<vector>
+#include	<deque>
+#include	<string>
+#include	<atomic>
+#include	<mutex>
+#include	<condition_variable>
+
+class	Match;
+
+// Fixed timestep loop of each match
+#define		SERVER_MAX_CATCHUP_TICKS	8		// Ticks run back to back when late, then the late time is dropped
+#define		SERVER_SPIN_TIME			500		// in micro sec - end of the wait yields instead of sleeping
+#define		SERVER_STATS_PERIOD			10		// in sec - stats of the matches are logged
+
+///////////////////////////////////////////////
+/////   Tick the matches on a pool of worker threads
+/////	One worker per core (no more than the matches). A tick of a match
+/////	is a task due at its fixed timestep, its deadline is the next one.
+/////	A worker runs its own tasks first, then steals the oldest tasks of
+/////	the others. With nothing due, it waits for the next tick (or for a
+/////	task to steal) and yields the core for the last SERVER_SPIN_TIME.
+/////	A match has one task at most: it is never ticked by two workers
+
+class	MatchScheduler
+{
+public:
+  MatchScheduler(const std::vector<Match *> &matches, sf::Time tickTime);
+  ~MatchScheduler();
+
+  void	start();
+  void	stop();		// Wait for the running ticks, then for the workers
+
+  // False once a match asked to exit (or threw)
+  bool	isRunning() const;
+  // Error thrown by a tick, rethrown by the main thread
+  const std::string	&getError() const;
+
+  // Ticks / time / overruns of every match since the last call
+  void	logStats();
+
+private:
+  MatchScheduler(const MatchScheduler &);
+  MatchScheduler	&operator=(const MatchScheduler &);
+
+  struct	s_worker
+  {
+    sf::Thread				*thread;
+    std::mutex				mutex;
+    std::deque<unsigned int>	tasks;	// Front: owner, back: thieves
+  };
+
+  struct	s_matchState
+  {
+    sf::Time		due;		// Start of its next tick
+    unsigned int	catchUp;	// Ticks run late in a row
+
+    // Stats, reset by logStats
+    unsigned int	ticks;
+    unsigned int	overruns;	// Ticks finished after their deadline
+    sf::Time		total;
+    sf::Time		worst;
+    sf::Time		skipped;	// Late time dropped (SERVER_MAX_CATCHUP_TICKS)
+  };
+
+  void	workerLoop(unsigned int index);
+  bool	popTask(unsigned int index, unsigned int &match);
+  bool	stealTask(unsigned int index, unsigned int &match);
+  void	pushTask(unsigned int index, unsigned int match);
+  bool	waitTask(unsigned int index);
+  void	runTick(unsigned int index, unsigned int match);
+  void	halt(const std::string &error);	// Empty when a match asked to exit
+
+  const std::vector<Match *>	&_matches;
+  sf::Time				_tickTime;
+  const sf::Clock		&_clock;
+
+  std::vector<s_worker *>	_workers;
+  std::atomic<bool>		_running;
+  std::atomic<unsigned int>	_queued;	// Tasks in the deques
+
+  // Matches waiting for their next tick, their states and the error
+  std::mutex				_timersMutex;
+  std::condition_variable	_wakeUp;
+  std::vector<unsigned int>	_waiting;
+  std::vector<s_matchState>	_states;
+  std::string				_error;
+};
+
+#endif
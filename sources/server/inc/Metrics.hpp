@@ -0,0 +1,134 @@
+//
+// Metrics.hpp for Void Clash
+//
+
+#ifndef		METRICS_HPP_
+# define	METRICS_HPP_
+
+#include	<SFML/System.hpp>
+#include	<atomic>
+#include	<string>
+#include	<vector>
+#include	<ostream>
+
+// Histograms of durations (in micro sec): values are exact below 16, then
+// in 8 buckets per power of 2 (within 12.5 %) up to 2^METRICS_MAX_BITS
+#define		METRICS_SUB_BITS		3
+#define		METRICS_MAX_BITS		24
+#define		METRICS_BUCKETS			((METRICS_MAX_BITS - METRICS_SUB_BITS + 1) << METRICS_SUB_BITS)
+
+#define		METRICS_PACKET_TYPES	64		// Slots from PACKET_NONE, which counts the unknown types
+#define		METRICS_OBJECT_TYPES	16		// Slots of eObjectType
+#define		METRICS_SAMPLE_PERIOD	1		// in sec - entities and clients copied for the endpoint
+
+// Steps of Match::tick
+enum	eTickPhase
+{
+	PHASE_MAP_UPDATE = 0,
+	PHASE_RECEIVE,
+	PHASE_PHYSICS,
+	PHASE_GAME,
+	PHASE_SEND,
+	PHASE_ADD_DELETE,
+	PHASE_CLEAR_EVENTS,
+	PHASE_TICK,			// Whole tick
+	PHASE_COUNT
+};
+
+///////////////////////////////////////////////
+/////   Lock free histogram (HDR like)
+/////	Recorded by the thread ticking the match, read by the endpoint
+
+class	Histogram
+{
+public:
+  Histogram();
+
+  void	record(sf::Uint64 value);
+
+  sf::Uint64	getCount() const;
+  sf::Uint64	getSum() const;
+  sf::Uint64	getMax() const;
+  // Highest value of the bucket holding the percentile (0 - 100)
+  sf::Uint64	getPercentile(double percentile) const;
+
+private:
+  Histogram(const Histogram &);
+  Histogram	&operator=(const Histogram &);
+
+  static unsigned int	bucketOf(sf::Uint64 value);
+  static sf::Uint64		highestOf(unsigned int bucket);
+
+  std::atomic<sf::Uint32>	_buckets[METRICS_BUCKETS];
+  std::atomic<sf::Uint64>	_count;
+  std::atomic<sf::Uint64>	_sum;
+  std::atomic<sf::Uint64>	_max;
+};
+
+///////////////////////////////////////////////
+/////   Metrics of one match
+/////	Histograms and traffic are updated by the tick, lock free.
+/////	Entities and clients are copied once per METRICS_SAMPLE_PERIOD
+
+class	MatchMetrics
+{
+public:
+  struct	s_client
+  {
+    sf::Uint32		id;
+    std::string		nick;
+    std::string		ip;
+    unsigned short	port;
+    float			rtt;			// in ms, from the last ping
+    sf::Uint32		inputs;			// Commands received
+    sf::Uint32		inputsLost;		// Commands never received, even with the redundancy
+  };
+
+  MatchMetrics(unsigned int id);
+
+  // Budget of a tick, before the match is ticked
+  void	setTickTime(sf::Time tickTime);
+
+  void	recordPhase(eTickPhase phase, sf::Time duration);
+  void	recordTick(sf::Time duration);
+
+  // Datagrams as on the wire (fragments are not assembled)
+  void	countIn(const char *data, std::size_t size);
+  void	countOut(const char *data, std::size_t size);
+
+  void	publish(const std::vector<unsigned int> &entities, const std::vector<s_client> &clients);
+
+  // Read from any thread
+  void	writeText(std::ostream &out);
+  void	writeJson(std::ostream &out);
+
+  static const char	*getPhaseName(eTickPhase phase);
+  static const char	*getPacketName(unsigned int slot);
+  static const char	*getObjectName(unsigned int type);
+
+private:
+  MatchMetrics(const MatchMetrics &);
+  MatchMetrics	&operator=(const MatchMetrics &);
+
+  struct	s_traffic
+  {
+    std::atomic<sf::Uint64>	packets;
+    std::atomic<sf::Uint64>	bytes;
+  };
+
+  static unsigned int	packetSlot(const char *data, std::size_t size);
+  static void			count(s_traffic &traffic, std::size_t size);
+
+  unsigned int				_id;
+  sf::Time					_tickTime;
+  Histogram					_phases[PHASE_COUNT];
+  std::atomic<sf::Uint64>	_overBudget;	// Ticks longer than _tickTime
+  s_traffic					_in[METRICS_PACKET_TYPES];
+  s_traffic					_out[METRICS_PACKET_TYPES];
+
+  sf::Mutex					_sampleMutex;
+  std::vector<unsigned int>	_entities;		// By eObjectType
+  std::vector<s_client>		_clients;
+};
+
+#endif
@@ -0,0 +1,71 @@
+//
+// MetricsServer.hpp for Void Clash
+//
+
+#ifndef		METRICSSERVER_HPP_
+# define	METRICSSERVER_HPP_
+
+#include	<SFML/Network.hpp>
+#include	<vector>
+#include	<atomic>
+
+#define		METRICS_WAIT_TIME		100		// in ms - the thread checks if it is stopped
+#define		METRICS_REQUEST_TIMEOUT	1000	// in ms - a connection is closed if nothing is asked
+#define		METRICS_SEND_TIMEOUT	1000	// in ms - a client which does not read is dropped
+#define		METRICS_DRAIN_TIMEOUT	1000	// in ms - wait for the client to close
+#define		METRICS_DRAIN_MAX		65536	// in bytes - read while waiting for it
+
+class	Match;
+
+///////////////////////////////////////////////
+/////   SFML listener bound to the loopback only (listen() of
+/////	SFML 2.2 binds every interface)
+
+class	LocalTcpListener : public sf::TcpListener
+{
+public:
+	sf::Socket::Status	listenLocal(unsigned short port);
+};
+
+///////////////////////////////////////////////
+/////   SFML socket, with the native handle for partial sends
+
+class	MetricsSocket : public sf::TcpSocket
+{
+public:
+	using	sf::TcpSocket::getHandle;
+};
+
+///////////////////////////////////////////////
+/////   Metrics of the matches for scraping, on their own thread
+/////	Listens on 127.0.0.1 only. "GET /json" (HTTP) or a line with
+/////	"json" gets JSON, anything else the text format:
+/////	curl localhost:13800/metrics or echo json | nc localhost 13800
+/////	Every step of a request has a timeout, stop() never waits
+/////	more than a few seconds
+
+class	MetricsServer
+{
+public:
+  MetricsServer(const std::vector<Match *> &matches);
+  ~MetricsServer();
+
+  // Not fatal if the port is taken, there are just no metrics
+  bool	start(unsigned short port);
+  void	stop();
+
+private:
+  MetricsServer(const MetricsServer &);
+  MetricsServer	&operator=(const MetricsServer &);
+
+  void	serverLoop();
+  void	answer(MetricsSocket &client);
+  bool	sendAll(MetricsSocket &client, const std::string &data);
+
+  const std::vector<Match *>	&_matches;
+  LocalTcpListener		_listener;
+  sf::Thread			_thread;
+  std::atomic<bool>		_running;
+};
+
+#endif
@@ -3,6 +3,7 @@
 
 class	Manager;
 class	ClientHandle;
+class	MatchMetrics;
 
 // Debug level
 // 0 = NONE
@@ -15,6 +16,14 @@ class	ClientHandle;
 // When no packet received from client, is considered as disconnect after INACTIVITY_TIMEOUT sec
 #define		RESPONSIVE_TIMEOUT 5.f // Do not send packets if no reply after RESPONSIVE_TIMEOUT from client (removed when received a packet from client)
 
+// Network I/O thread
+#define		IO_QUEUE_IN_SIZE	1024	// Datagrams received, waiting for the simulation - MUST BE A POWER OF 2
+#define		IO_QUEUE_OUT_SIZE	4096	// Datagrams sent by the simulation, waiting for the socket - MUST BE A POWER OF 2
+#define		IO_WAIT_TIME		500		// Max time (micro sec) the I/O thread waits for incoming data before flushing sends
+
+// World data of the synchro is split in datagrams of this size (in bytes, under the MTU)
+#define		WORLD_DATA_CHUNK_SIZE	1000
+
 enum	ePacketType
 {
 	PACKET_NONE = 42,
@@ -27,11 +36,14 @@ enum	ePacketType
 	PACKET_CONFIG,				// Server -> client - t_conf
 
 	//................. Low level sync
-	PACKET_INPUT,				// Client -> server - t_actions
-	PACKET_UPDATE,				// Server -> client - loop on all game object and serialize them (light - every tickrate)
-	PACKET_SYNCHRO,				// Server -> client - loop on all game object and serialize them (medium - every sec)
-	PACKET_EVENT_ADD,			// Server -> client - Subpacket of update / welcome and sync
-	PACKET_EVENT_DELETE,		// Server -> client - Subpacket of update / welcome and sync
+	PACKET_INPUT,				// Client -> server - timestamp / last snapshot received / reliable ack / input sequence / t_actions
+	PACKET_UPDATE,				// Server -> client - timestamp / reliable ack / bit stream: snapshot sequence / base offset / last input applied / world records (light - every tickrate)
+	PACKET_SYNCHRO,				// Server -> client - players, then the world data in PACKET_WORLD_DATA (medium - every sec)
+	PACKET_EVENT_ADD,			// Unused - world records are bit packed, see eWireTag
+	PACKET_EVENT_DELETE,		// Unused - world records are bit packed, see eWireTag
+	PACKET_WORLD_DATA,			// Server -> client - bit stream: world records (walls / flags...), split in datagrams < WORLD_DATA_CHUNK_SIZE
+	PACKET_FRAGMENT,			// Both ways - message id / index / count / chunk size / part of a packet bigger than the MTU (see Fragment.hpp)
+	PACKET_RELIABLE,			// Both ways - datagram sequence / messages of the reliable channels (see ReliableChannel.hpp)
 
 	//................. General
 	PACKET_DISPLAY_STRING,			// Server -> client - int (type of display) / std::string
@@ -66,29 +78,50 @@ enum	ePacketType
 
 #include	<SFML/Network.hpp>
 #include	<list>
+#include	<unordered_map>
+#include	<vector>
+#include	<atomic>
+#include	"RingBuffer.hpp"
+#include	"UdpBatch.hpp"
+#include	"Fragment.hpp"
 #include	"Sender.hpp"
 #include	"Receiver.hpp"
 #include	"Command.hpp"
-#include	"WebSender.hpp"
+#include	"NetworkIo.hpp"
+
+///////////////////////////////////////////////
+/////   Clients of one match
+/////	Datagrams go through the socket of the NetworkIo, shared by
+/////	all the matches, in the queues of the engine
 
 class NetworkEngine
 {
 public:
-  NetworkEngine();
+  NetworkEngine(NetworkIo *io, MatchMetrics *metrics);
   ~NetworkEngine();
 
-  bool	start();
   void	stop();
   void	update();
 
+  // Called from the simulation, never touch the socket
+  // send returns false (packet dropped) if the outgoing queue is full
+  // Sent packets are queued until flush(), so a tick goes out in one batch
+  // Packets bigger than t_server::mtu are sent in fragments
+  // receive only returns complete packets
+  bool	send(sf::Packet &packet, const sf::IpAddress &ip, unsigned short port);
+  void	flush();
+  bool	receive(sf::Packet &packet, sf::IpAddress &ip, unsigned short &port, sf::Time &arrival);
+
   void	addNewClient(const sf::IpAddress & ip, unsigned short port);
+  std::list<ClientHandle *>::iterator	removeClient(std::list<ClientHandle *>::iterator it); // Does not delete the handle
+
+  // Client refused (server full), his next datagram opens a new session
+  void	closeSession(const sf::IpAddress &ip, unsigned short port);
 
   // Getterz
   std::list<ClientHandle *>		&getClients();
-  sf::UdpSocket				*getSocket();
   Receiver				*getReceiver();		// Receive from clients
   Sender				*getSender();		// Send infos to clients
-  WebSender				*getWebSender();	// Communicate with central server
 
   // Debug funcs
   void		printClientsInfo();
@@ -109,16 +142,29 @@ public:
   ClientHandle				*findClientHandleWithIP(sf::IpAddress ip, unsigned short port);
   ClientHandle				*findClientHandleWithID(sf::Uint32 id);
 
-private:
-  std::string		_serverIp;
-  unsigned short	_serverPort;
+  static sf::Uint64	addressKey(const sf::IpAddress &ip, unsigned short port);
 
-  sf::UdpSocket			_serverSocket;
+private:
+  // Fills _inQueue and empties _outQueue from the I/O thread
+  friend class	NetworkIo;
+
+  bool	pushDatagram(sf::Packet &packet, const sf::IpAddress &ip, unsigned short port);
+
+  NetworkIo				*_io;
+  MatchMetrics			*_metrics;	// Datagrams by type, of the match
+  RingBuffer<s_datagram, IO_QUEUE_IN_SIZE>	*_inQueue;	// I/O thread -> simulation
+  RingBuffer<s_datagram, IO_QUEUE_OUT_SIZE>	*_outQueue;	// Simulation -> I/O thread
+  std::atomic<sf::Uint32>	_inDropped;	// Datagrams lost because _inQueue was full, logged by the simulation
+  FragmentSplitter		_splitter;
+  FragmentAssembler		_assembler;
   std::list<ClientHandle *>	_clients;
 
+  // Lookup tables on _clients, kept by addNewClient / removeClient
+  std::unordered_map<sf::Uint64, ClientHandle *>	_clientsByAddress;
+  std::unordered_map<sf::Uint32, ClientHandle *>	_clientsById; // Player id
+
   Sender			*_sender;		// Send infos to clients
   Receiver			*_receiver;		// Receive from clients
-  WebSender			*_webSender;	// Communicate with central server
 };
 
 #endif
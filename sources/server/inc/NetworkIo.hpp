@@ -0,0 +1,75 @@
+//
+// NetworkIo.hpp for Void Clash
+//
+
+#ifndef		NETWORKIO_HPP_
+# define	NETWORKIO_HPP_
+
+#include	<SFML/Network.hpp>
+#include	<unordered_map>
+#include	<vector>
+#include	<atomic>
+#include	"UdpBatch.hpp"
+
+#define		IO_SESSION_TIMEOUT	(2 * INACTIVITY_TIMEOUT)	// in sec - a session without datagrams is closed, its match dropped the client long before
+#define		IO_SESSION_SWEEP	1		// in sec - idle sessions are looked for
+
+class	NetworkEngine;
+
+///////////////////////////////////////////////
+/////   Socket of the server, shared by all the matches
+/////	The I/O thread owns it: datagrams of a client (session, his
+/////	address) go into the incoming queue of his match, and the
+/////	outgoing queues of all the matches are sent.
+/////	A new client goes in the first match which is not full.
+/////	Only a client packet opens a session, once it is queued in its match
+
+class	NetworkIo
+{
+public:
+  NetworkIo();
+  ~NetworkIo();
+
+  // Engines are added before start, the I/O thread does not lock them
+  void	addEngine(NetworkEngine *engine);
+
+  // Bind the first free port and start the I/O thread
+  bool	start();
+  void	stop();
+
+  unsigned short	getPort() const;
+
+  // Client removed from his match, his next datagram opens a new session
+  void	closeSession(const sf::IpAddress &ip, unsigned short port);
+
+private:
+  void	ioLoop();
+  void	ioReceive();
+  void	ioSend();
+
+  struct	s_session
+  {
+    unsigned int	match;			// Index in _engines
+    sf::Time		lastArrival;
+  };
+
+  static bool	opensSession(const s_datagram &datagram);
+  unsigned int	chooseMatch() const;
+  void		expireSessions(sf::Time now);
+
+  BatchUdpSocket		_socket;
+  unsigned short		_port;
+  UdpBatch				*_batch;
+  sf::Thread			_thread;
+  std::atomic<bool>		_running;
+
+  std::vector<NetworkEngine *>	_engines;	// One per match
+  s_datagram			_received[UDP_BATCH_SIZE];	// Moved into the queue of their match
+
+  // Client address -> match, also changed by the matches
+  sf::Mutex			_sessionsMutex;
+  std::unordered_map<sf::Uint64, s_session>	_sessions;
+  std::vector<unsigned int>	_sessionCounts;
+};
+
+#endif
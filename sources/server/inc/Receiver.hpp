@@ -30,7 +30,9 @@ public:
   bool update();
 
 private:
-	void	updateClientInput(sf::IpAddress ip, unsigned short port);
+	void	handlePacket(sf::Uint32 type, sf::IpAddress ip, unsigned short port, sf::Time arrival);
+	void	handleReliable(sf::IpAddress ip, unsigned short port, sf::Time arrival);
+	void	updateClientInput(sf::IpAddress ip, unsigned short port, sf::Time arrival);
 	void	handleChat(sf::IpAddress ip, unsigned short port);
 	void	playerJoinTeam(sf::IpAddress ip, unsigned short port);
 	void	handleWeaponSelection(sf::IpAddress ip, unsigned short port);
@@ -42,7 +44,7 @@ private:
 	void	handleRequestPlayerKick(sf::IpAddress ip, unsigned short port);
 
 
-	void	updateClientActivity(sf::IpAddress ip, unsigned short port);
+	void	updateClientActivity(sf::IpAddress ip, unsigned short port, sf::Time arrival);
 	void	checkClientsActivity();
 
 
@@ -0,0 +1,77 @@
+//
+// RingBuffer.hpp for Void Clash
+//
+
+#ifndef		RINGBUFFER_HPP_
+# define	RINGBUFFER_HPP_
+
+#include	<atomic>
+
+#define		RINGBUFFER_CACHE_LINE	64	// in bytes
+
+///////////////////////////////////////////////
+/////   Lock free single producer / single consumer queue
+/////	Slots are allocated once and reused, so a slot keeps its
+/////	buffers between two uses (no allocation once warmed up)
+/////	The producer publishes in batches, so the consumer gets them at once
+/////	Capacity MUST BE A POWER OF 2
+
+template <typename T, unsigned int Capacity>
+class	RingBuffer
+{
+public:
+	RingBuffer() : _head(0), _tail(0), _written(0) {}
+
+	// Producer side
+	// offset-th free slot, NULL if the queue is full
+	// push() marks slots as written, publish() makes them visible to the consumer
+	T	*reserve(unsigned int offset = 0)
+	{
+		if (_written + offset - _head.load(std::memory_order_acquire) >= Capacity)
+			return NULL;
+		return &_slots[(_written + offset) & (Capacity - 1)];
+	}
+
+	void	push(unsigned int count = 1)
+	{
+		_written += count;
+	}
+
+	void	publish()
+	{
+		_tail.store(_written, std::memory_order_release);
+	}
+
+	// Consumer side
+	// offset-th published slot, NULL if there is none. Released by pop()
+	T	*front(unsigned int offset = 0)
+	{
+		unsigned int	head = _head.load(std::memory_order_relaxed);
+
+		if (_tail.load(std::memory_order_acquire) - head <= offset)
+			return NULL;
+		return &_slots[(head + offset) & (Capacity - 1)];
+	}
+
+	void	pop(unsigned int count = 1)
+	{
+		_head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+	}
+
+private:
+	RingBuffer(const RingBuffer &);
+	RingBuffer	&operator=(const RingBuffer &);
+
+	T	_slots[Capacity];
+
+	// Each index is written by one thread only, keep them on their own cache line
+	// Padding rather than alignas: plain new (C++11) ignores over-alignment
+	char							_padSlots[RINGBUFFER_CACHE_LINE];
+	std::atomic<unsigned int>		_head;	// Consumer
+	char							_padHead[RINGBUFFER_CACHE_LINE - sizeof(std::atomic<unsigned int>)];
+	std::atomic<unsigned int>		_tail;	// Producer
+	unsigned int					_written;	// Producer only, pushed but maybe not published yet
+	char							_padTail[RINGBUFFER_CACHE_LINE - sizeof(std::atomic<unsigned int>) - sizeof(unsigned int)];
+};
+
+#endif
@@ -0,0 +1,66 @@
+//
+// SendScheduler.hpp for Void Clash
+//
+
+#ifndef		SENDSCHEDULER_HPP_
+# define	SENDSCHEDULER_HPP_
+
+#include	<deque>
+#include	<SFML/Network.hpp>
+
+class	NetworkEngine;
+
+#define	SCHEDULER_BURST_TIME	0.1f	// in sec of bandwidth, max bytes saved while idle
+#define	SCHEDULER_MIN_BURST		1400	// in bytes, one full datagram always fits
+#define	SCHEDULER_MAX_PER_TICK	2		// queued packets sent per tick
+
+// Lower value is sent first
+enum	eSendPriority
+{
+	SEND_PRIORITY_HIGH = 0,	// Gameplay events, ping... sent at once
+	SEND_PRIORITY_NORMAL,	// Weapon selection, map list
+	SEND_PRIORITY_LOW,		// Synchro / world data, sent when the budget allows
+	SEND_PRIORITY_COUNT
+};
+
+///////////////////////////////////////////////
+/////   Outgoing traffic of one client
+/////	Snapshots are sent at t_server::snapshot_rate
+/////	Everything sent is taken from a t_server::client_bandwidth budget
+/////	(bytes / sec, 0 = unlimited), what does not fit waits in
+/////	a queue per priority and is sent in the next ticks
+
+class	SendScheduler
+{
+public:
+	SendScheduler();
+	~SendScheduler();
+
+	// Refill the budget, called once per tick
+	void	update(sf::Time elapsed);
+
+	// Send now if high priority, queue otherwise (sent by flush)
+	void	send(NetworkEngine *networkEngine, sf::Packet &packet,
+				const sf::IpAddress &ip, unsigned short port);
+	// Send queued packets while the budget allows, in priority order
+	// Called each tick after the snapshot, which goes first
+	void	flush(NetworkEngine *networkEngine, const sf::IpAddress &ip, unsigned short port);
+	// Drop the queued packets of this priority (replaced by newer ones)
+	void	discard(eSendPriority priority);
+
+	// True once per snapshot period, if the budget is not overdrawn
+	bool	isSnapshotDue();
+	void	consume(unsigned int bytes);
+
+	static eSendPriority	getPriority(const sf::Packet &packet);
+
+private:
+	bool	isLimited() const;
+
+	float		_budget;			// in bytes, can be negative after a high priority burst
+	float		_snapshotCredit;	// a snapshot is due at 1
+
+	std::deque<sf::Packet>	_queues[SEND_PRIORITY_COUNT];
+};
+
+#endif
@@ -12,6 +12,9 @@
 # define	SENDER_HPP_
 
 #include	"AObject.hpp"
+#include	"Snapshot.hpp"
+#include	"ClientInterest.hpp"
+#include	"ReliableChannel.hpp"
 
 class	NetworkEngine;
 
@@ -26,6 +29,8 @@ public:
   ~Sender();
 
   void	update();
+  // Reliable messages and queued packets of every client, once per tick
+  void	flushClients();
 
   // Send packet
   void	sendPacket(sf::Packet &packet, ClientHandle *client = NULL);
@@ -33,14 +38,16 @@ public:
   // Generic packet send
   void	sendPacketGeneric(ePacketType packetType, ClientHandle *client = NULL);
 
-  void	insertAddedObj();
+  void	insertAddedObj(bool filtered = false);
   void	insertDeletedObj();
 
-  void	insertWorldData();
+  void	insertWorldData(bool split, ClientHandle *client);
+  void	addWorldRecord(bool split, ClientHandle *client);
   template<typename T>
-  void	insertObject(AObject *obj);
+  void	insertObject(AObject *obj, BitWriter &writer);
   template<typename T>
-  void	insertWeapons(AObject *obj);
+  void	insertWeapons(AObject *obj, BitWriter &writer);
+  void	insertPlayer(const s_playerState &state, const s_playerState *base, sf::Uint32 &previousId);
 
   // EVENTS
   void	sendUpdateEvents();
@@ -52,8 +59,9 @@ public:
   void	sendStringToDisplay(std::string str, int level, ClientHandle *client = NULL);
   // Pong
   void	sendPing(float timestamp, ClientHandle *client);
-  // Config
-  void	sendConfig(ClientHandle *client = NULL);
+  // Config, not sent again to a client which has this hash
+  void	cacheConfig();
+  void	sendConfig(ClientHandle *client = NULL, sf::Uint32 clientHash = 0);
   // Weapon selection
   void	sendWeaponSelection(ClientHandle *client = NULL);
   // Check client activity to send deco
@@ -63,11 +71,42 @@ public:
 
 private:
   void	createPacket(ePacketType packetType);
+  // Snapshot of the tick as a delta for every client, by update() only
+  void	sendSnapshot();
+  void	captureSnapshot(Snapshot &snapshot);
+  void	sendSnapshotTo(ClientHandle *client, const Snapshot &snapshot, float timestamp);
+  void	sendWorldData(ClientHandle *client);
+  void	flushWorldData(ClientHandle *client);
   void	sendPacketTo(ClientHandle *client = NULL);
   void	sendPacketTo(sf::IpAddress ip, unsigned short port);
+  void	sendPacketTo(ClientHandle *client, eChannel channel);
+  void	flushChannel(ClientHandle *client);
+
+  static eChannel	getChannel(const sf::Packet &packet);
 
   sf::Packet	_packet;
   ePacketType	_packetType;
+  BitWriter		_writer; // World data, appended at the end of _packet
+  BitWriter		_record; // One world object, before it goes in _writer
+  sf::Packet	_datagram; // Reliable messages of one client, _packet is sent to the others after
+
+  // G_conf serialized once (ConfigSerializer), at start and reload
+  sf::Packet	_config;
+  sf::Uint32	_configHash;
+
+  // Snapshots
+  SnapshotHistory	_snapshots;
+  sf::Uint32		_snapshotSequence;
+  BitWriter		_eventWriter; // Added / deleted objects of the tick, same for all clients
+
+  // Projectiles added this tick, sent to the clients they are relevant to
+  struct	s_projectileRecord
+  {
+    s_area		area;
+    BitWriter	writer;
+  };
+  std::vector<s_projectileRecord>	_projectiles; // Reused, only the _nbProjectiles first are valid
+  unsigned int	_nbProjectiles;
 
   NetworkEngine	*_networkEngine;
 };
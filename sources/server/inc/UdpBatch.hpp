@@ -0,0 +1,64 @@
+//
+// UdpBatch.hpp for Void Clash
+//
+
+#ifndef		UDPBATCH_HPP_
+# define	UDPBATCH_HPP_
+
+#include	<vector>
+#include	<SFML/Network.hpp>
+
+// Max datagrams moved by one receive / send call
+#define		UDP_BATCH_SIZE	64
+
+///////////////////////////////////////////////
+/////   Raw datagram moved between the simulation and the I/O thread
+
+struct	s_datagram
+{
+	sf::IpAddress		ip;
+	unsigned short		port;
+	sf::Time			arrival;	// Global clock time when the socket got it
+	std::vector<char>	data;
+};
+
+///////////////////////////////////////////////
+/////   SFML socket, with the native handle reachable by the backend
+
+class	BatchUdpSocket : public sf::UdpSocket
+{
+public:
+	using	sf::UdpSocket::getHandle;
+};
+
+///////////////////////////////////////////////
+/////   Send / receive several datagrams per system call
+/////	Linux uses recvmmsg / sendmmsg (UdpBatch_linux.cpp)
+/////	other systems loop on the SFML socket (UdpBatch_sfml.cpp)
+/////	The socket MUST BE non blocking
+
+struct	s_udpBatchBuffers;
+
+class	UdpBatch
+{
+public:
+	UdpBatch(BatchUdpSocket &socket);
+	~UdpBatch();
+
+	// Fill up to count datagrams (count <= UDP_BATCH_SIZE)
+	// Returns the number of datagrams received, 0 if nothing is pending
+	unsigned int	receive(s_datagram **datagrams, unsigned int count);
+
+	// Send count datagrams (count <= UDP_BATCH_SIZE)
+	// Returns the number of datagrams sent, the others are dropped
+	unsigned int	send(s_datagram **datagrams, unsigned int count);
+
+private:
+	UdpBatch(const UdpBatch &);
+	UdpBatch	&operator=(const UdpBatch &);
+
+	BatchUdpSocket		&_socket;
+	s_udpBatchBuffers	*_buffers;	// Backend scratch, allocated once
+};
+
+#endif
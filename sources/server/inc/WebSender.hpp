@@ -1,46 +1,86 @@
 #ifndef		WEB_SENDER_HPP_
 # define	WEB_SENDER_HPP_
 
-#include	"AObject.hpp"
+#include	<SFML/Network.hpp>
+#include	<vector>
+#include	<string>
+#include	<mutex>
+#include	<condition_variable>
 
 // Send msg to central server every UPDATE_DELAY sec
 #define		UPDATE_DELAY	30
 
-// Central Server URL
-#define		CENTRAL_SERVER_URL	"http://voidclashserver.azurewebsites.net"
-// Central Server API
+// After a failure, first retry in RETRY_DELAY sec, doubled up to RETRY_MAX_DELAY
+#define		RETRY_DELAY		2
+#define		RETRY_MAX_DELAY	300
+
+#define		REQUEST_TIMEOUT	2000	// in ms - connection + answer
+#define		CLOSE_TIMEOUT	1000	// in ms - the server stop waits for it at most
+
+// Central Server API (the URL is t_server::central_server)
 #define		CENTRAL_SERVER_API	"api/server"
 
-class	NetworkEngine;
+class	NetworkIo;
+class	Match;
+
+///////////////////////////////////////////////
+/////   Heartbeat to the central server (the list of the servers)
+/////	A worker thread registers the server, updates it every
+/////	UPDATE_DELAY and retries with a growing delay when the central
+/////	server does not answer. It reads the status the matches publish
+/////	(Match::getStatus), never their maps.
+/////	start() does not wait for the central server. stop() drops the
+/////	request waiting for its answer and gives CLOSE_TIMEOUT to the close
+/////	(only a connection in progress, REQUEST_TIMEOUT, is waited for)
 
-enum WebSenderStatus
-{
-	WEBSENDER_NOT_INIT,
-	WEBSENDER_FAILED,
-	WEBSENDER_OK
-};
 class WebSender
 {
 public:
-	WebSender(NetworkEngine *networkEngine);
+	WebSender(NetworkIo *networkIo, const std::vector<Match *> &matches);
 	~WebSender();
 
-	bool	sendCreate();
-	void	sendUpdate();
-	bool	sendClose();
+	// "http://host[:port][/path]", not listed if empty
+	void	start(const std::string &url);
+	void	stop();
 
 private:
-	NetworkEngine	*_networkEngine;
+	WebSender(const WebSender &);
+	WebSender	&operator=(const WebSender &);
 
-	sf::Http *_http;
+	void	sendLoop();
 
-	// Server ID registered on central server
+	bool	sendCreate();
+	bool	sendUpdate();
+	void	sendClose();
+
+	// False on network error or timeout, else the HTTP status and the body
+	bool	request(const std::string &method, const std::string &body, sf::Time timeout, int &status, std::string &answer);
+	// False once stopped
+	bool	waitFor(sf::Time delay);
+	bool	isRunning();
+
+	// One server for the central server: players of all the matches, map of the first one
+	std::string	getStatus();
+
+	NetworkIo					*_networkIo;
+	const std::vector<Match *>	&_matches;
+
+	std::string		_host;
+	unsigned short	_port;
+	std::string		_path;
+	sf::IpAddress	_address;	// Resolved by the worker, once
+	bool			_answered;	// By the last request, else no close
+
+	// Server ID registered on central server, -1 if not registered
 	int			_id;
 	sf::Thread	_thread;
 
+	std::mutex				_mutex;
+	std::condition_variable	_wakeUp;
+	bool					_running;
+
 	std::string		_serverName;
 	int				_maxPlayer;
-	WebSenderStatus	_status;
 };
 
 #endif
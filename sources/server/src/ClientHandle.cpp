@@ -14,10 +14,12 @@
 #include	"NetworkEngine.hpp"
 #include	"Manager.hpp"
 #include	"Map.hpp"
+#include	"Defines.h"
 
 #include	"main.hpp"
 
-ClientHandle::ClientHandle(NetworkEngine *networkEngine, sf::IpAddress ip, unsigned short port)
+ClientHandle::ClientHandle(NetworkEngine *networkEngine, sf::IpAddress ip, unsigned short port) :
+_channel(PACKET_RELIABLE)
 {
 	_ip = ip;
 	_port = port;
@@ -28,9 +30,18 @@ ClientHandle::ClientHandle(NetworkEngine *networkEngine, sf::IpAddress ip, unsig
 	_actions = new s_actions();
 	_lastActivity = S_Map->getGlobalClock().getElapsedTime();
 	_lastUpdateInput = 0.0f;
+	_lastInputArrival = sf::Time::Zero;
+	_ackedSnapshot = 0;
+	_lastInput = 0;
+	_lastQueued = 0;
+	_inputs = 0;
+	_inputsLost = 0;
+	_queueTicks = 0;
+	_queueMin = INPUT_QUEUE_MAX;
 	_clock.restart();
 	_admin = false;
 	_started = false;
+	_dropped = false;
 }
 
 ClientHandle::~ClientHandle() {}
@@ -49,8 +60,10 @@ bool	ClientHandle::ping()
 	if (_clock.getElapsedTime().asSeconds() > 1.0f && _started)
 	{
 		// Add a packet synchro every sec
+		// The previous one is outdated if still waiting for bandwidth
+		_scheduler.discard(SEND_PRIORITY_LOW);
 		_networkEngine->getSender()->sendPacketGeneric(PACKET_SYNCHRO, this);
-		_networkEngine->getSender()->sendWeaponSelection();
+		_networkEngine->getSender()->sendWeaponSelection(this);
 
 		float timestamp;
 
@@ -86,8 +99,10 @@ void	ClientHandle::setPort(unsigned short port)
 	_port = port;
 }
 
-void	ClientHandle::setActions(sf::Packet &packet)
+void	ClientHandle::setActions(sf::Packet &packet, sf::Time arrival)
 {
+	_lastInputArrival = arrival;
+
 	// Drop old packet to work only on most recent ones
 	float timestamp;
 	if (packet >> timestamp)
@@ -105,15 +120,88 @@ void	ClientHandle::setActions(sf::Packet &packet)
 		_networkEngine->printLog(1, "Unable to extract timestamp of packet input");
 	}
 
+	// Snapshot ack, inputs may arrive out of order so keep the most recent
+	sf::Uint32	ackedSnapshot;
+	if (packet >> ackedSnapshot)
+	{
+		if (ackedSnapshot > _ackedSnapshot)
+			_ackedSnapshot = ackedSnapshot;
+	}
+	else
+		_networkEngine->printLog(1, "Unable to extract snapshot ack of packet input");
+
+	// Reliable messages the client received
+	if (!_channel.readAck(packet, arrival))
+		_networkEngine->printLog(1, "Unable to extract reliable ack of packet input");
+
+	// Last commands, oldest first, and the sequence of the last one
+	// No command until the client has the config
+	sf::Uint8	count;
+	sf::Uint32	lastSequence;
+	if (!(packet >> count >> lastSequence) || count > INPUT_REDUNDANCY || lastSequence < count)
+	{
+		_networkEngine->printLog(1, "Unable to extract commands of packet input from " + _ip.toString());
+		return;
+	}
 
 	// extract
-	if (packet >> _actions)
+	for (sf::Uint8 i = 0; i < count; ++i)
 	{
-		ADD_EVENT(ev_PLAYER_ACTION, s_event(_player, _actions));
-		//_networkEngine->printLog(3, "Update success from " + _ip.toString());
+		s_command	command;
+
+		command.sequence = lastSequence - count + 1 + i;
+		if (!(packet >> &command.actions))
+		{
+			_networkEngine->printLog(1, "Update packet extraction failed from " + _ip.toString());
+			return;
+		}
+		// Already received in a previous packet
+		if (command.sequence <= _lastQueued)
+			continue;
+		// Skipped ones were in packets all lost
+		if (_lastQueued != 0)
+			_inputsLost += command.sequence - _lastQueued - 1;
+		++_inputs;
+		_lastQueued = command.sequence;
+		_commands.push_back(command);
+	}
+	while (_commands.size() > INPUT_QUEUE_MAX)
+		dropCommand();
+}
+
+// Its presses go to the next one
+void	ClientHandle::dropCommand()
+{
+	s_command	command = _commands.front();
+
+	_commands.pop_front();
+	if (!_commands.empty())
+	{
+		_commands.front().actions.primary |= command.actions.primary;
+		_commands.front().actions.secondary |= command.actions.secondary;
 	}
-	else
-		_networkEngine->printLog(1, "Update packet extraction failed from " + _ip.toString());
+}
+
+void	ClientHandle::applyActions()
+{
+	// Commands never needed over the window only delay the next ones
+	if (_commands.size() < _queueMin)
+		_queueMin = _commands.size();
+	if (++_queueTicks >= INPUT_QUEUE_WINDOW)
+	{
+		if (_queueMin > INPUT_QUEUE_TARGET)
+			dropCommand();
+		_queueTicks = 0;
+		_queueMin = INPUT_QUEUE_MAX;
+	}
+
+	// Late or lost, the player keeps his last actions
+	if (_commands.empty())
+		return;
+	*_actions = _commands.front().actions;
+	_lastInput = _commands.front().sequence;
+	_commands.pop_front();
+	ADD_EVENT(ev_PLAYER_ACTION, s_event(_player, _actions));
 }
 
 void	ClientHandle::resetActions()
@@ -139,6 +227,46 @@ std::shared_ptr<Player>	ClientHandle::getPlayer() const
 	return (_player);
 }
 
+sf::Uint32	ClientHandle::getAckedSnapshot() const
+{
+	return (_ackedSnapshot);
+}
+
+sf::Uint32	ClientHandle::getLastInput() const
+{
+	return (_lastInput);
+}
+
+sf::Time	ClientHandle::getLastInputArrival() const
+{
+	return (_lastInputArrival);
+}
+
+ClientInterest	&ClientHandle::getInterest()
+{
+	return (_interest);
+}
+
+SendScheduler	&ClientHandle::getScheduler()
+{
+	return (_scheduler);
+}
+
+ReliableChannel	&ClientHandle::getChannel()
+{
+	return (_channel);
+}
+
+sf::Uint32	ClientHandle::getInputs() const
+{
+	return (_inputs);
+}
+
+sf::Uint32	ClientHandle::getInputsLost() const
+{
+	return (_inputsLost);
+}
+
 ///////////////////////////////////////////////
 /////   Activity
 
@@ -149,18 +277,28 @@ void	ClientHandle::active(sf::Time time)
 
 bool	ClientHandle::isActive(sf::Time time)
 {
-	if ((time - _lastActivity).asSeconds() > INACTIVITY_TIMEOUT)
+	if (_dropped || (time - _lastActivity).asSeconds() > INACTIVITY_TIMEOUT)
 		return false;
 	return true;
 }
 
 bool	ClientHandle::isResponsive(sf::Time time)
 {
-	if ((time - _lastActivity).asSeconds() > RESPONSIVE_TIMEOUT)
+	if (_dropped || (time - _lastActivity).asSeconds() > RESPONSIVE_TIMEOUT)
 		return false;
 	return true;
 }
 
+void	ClientHandle::drop()
+{
+	_dropped = true;
+}
+
+bool	ClientHandle::isDropped() const
+{
+	return _dropped;
+}
+
 ///////////////////////////////////////////////
 /////   Admin
 
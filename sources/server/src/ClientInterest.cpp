@@ -0,0 +1,146 @@
+//
+// ClientInterest.cpp for Void Clash
+//
+
+#include	<cmath>
+#include	<algorithm>
+#include	"ClientInterest.hpp"
+#include	"ConfigParser.hpp"
+#include	"Player.hpp"
+#include	"Rocket.hpp"
+#include	"Map.hpp"
+
+extern t_config *G_conf;
+
+ClientInterest::ClientInterest()
+{
+	_filtering = false;
+	_view.left = 0;
+	_view.top = 0;
+	_view.right = 0;
+	_view.bottom = 0;
+	_viewDistance = 0;
+	_cursor = 0;
+	for (unsigned int i = 0; i < SNAPSHOT_HISTORY_SIZE; ++i)
+		_sent[i].sequence = 0;
+	_current = &_sent[0];
+}
+
+ClientInterest::~ClientInterest()
+{
+}
+
+///////////////////////////////////////////////
+/////   View
+
+void	ClientInterest::update(const Player &player)
+{
+	// Same rule as MapUtils::setPlayerFollowed on the client
+	// The server does not know who a spectator follows
+	_filtering = player.getTeam() != 0 &&
+		(S_Map->getMode()->getProperty()->respawnTime != -1 || player.getLife() > 0);
+	if (!_filtering)
+		return;
+
+	// The client zoom is clamped to the config one, so this is its widest view
+	float	halfHeight = G_conf->game->zoom * AOI_VIEW_HALF_HEIGHT;
+	float	halfWidth = halfHeight * AOI_VIEW_RATIO;
+
+	_view.left = player.getX() - halfWidth - AOI_MARGIN;
+	_view.right = player.getX() + halfWidth + AOI_MARGIN;
+	_view.top = player.getY() - halfHeight - AOI_MARGIN;
+	_view.bottom = player.getY() + halfHeight + AOI_MARGIN;
+	_viewDistance = halfHeight + AOI_MARGIN;
+}
+
+bool	ClientInterest::isFiltering() const
+{
+	return _filtering;
+}
+
+bool	ClientInterest::isRelevant(const s_area &area) const
+{
+	if (!_filtering)
+		return true;
+	return area.right >= _view.left && area.left <= _view.right &&
+		area.bottom >= _view.top && area.top <= _view.bottom;
+}
+
+void	ClientInterest::getSweptArea(const AObject &obj, s_area &area)
+{
+	// dir is in units per 20ms / game speed (see PhysicEngine::update)
+	float	time = AOI_PREDICTION_TIME * 50.f / G_conf->game->speed;
+	float	endX = obj.getX() + obj.getDirX() * time;
+	float	endY = obj.getY() + obj.getDirY() * time;
+
+	// Rockets fly straight to their impact
+	const Rocket	*rocket = dynamic_cast<const Rocket *>(&obj);
+	if (rocket)
+	{
+		endX = rocket->getImpact().first;
+		endY = rocket->getImpact().second;
+	}
+
+	area.left = std::min(obj.getX(), endX);
+	area.right = std::max(obj.getX(), endX);
+	area.top = std::min(obj.getY(), endY);
+	area.bottom = std::max(obj.getY(), endY);
+}
+
+///////////////////////////////////////////////
+/////   Players priority
+
+void	ClientInterest::beginSnapshot(sf::Uint32 sequence)
+{
+	_priorities.swap(_previousPriorities);
+	_priorities.clear();
+	_cursor = 0;
+
+	_current = &_sent[sequence % SNAPSHOT_HISTORY_SIZE];
+	_current->sequence = sequence;
+	_current->ids.clear();
+}
+
+bool	ClientInterest::mustSendPlayer(const s_playerState &state, sf::Uint32 ownId)
+{
+	s_priority	priority;
+	bool		send = true;
+
+	// Previous priority, players before this id have left
+	priority.id = state.id;
+	priority.value = 1.f; // New players are sent at once
+	while (_cursor < _previousPriorities.size() && _previousPriorities[_cursor].id < state.id)
+		++_cursor;
+	if (_cursor < _previousPriorities.size() && _previousPriorities[_cursor].id == state.id)
+		priority.value = _previousPriorities[_cursor].value;
+
+	if (_filtering && state.id != ownId)
+	{
+		float	x = state.x / SNAPSHOT_POS_PRECISION;
+		float	y = state.y / SNAPSHOT_POS_PRECISION;
+		float	dx = std::max(std::max(_view.left - x, x - _view.right), 0.f);
+		float	dy = std::max(std::max(_view.top - y, y - _view.bottom), 0.f);
+		float	distance = std::sqrt(dx * dx + dy * dy);
+
+		if (distance > 0)
+		{
+			priority.value += std::max(AOI_FAR_PRIORITY * _viewDistance / distance, AOI_MIN_PRIORITY);
+			send = priority.value >= 1.f;
+		}
+	}
+
+	if (send)
+	{
+		priority.value = 0;
+		_current->ids.push_back(state.id);
+	}
+	_priorities.push_back(priority);
+	return send;
+}
+
+bool	ClientInterest::wasSent(sf::Uint32 sequence, sf::Uint32 id) const
+{
+	const s_sent	&sent = _sent[sequence % SNAPSHOT_HISTORY_SIZE];
+
+	return sent.sequence == sequence && std::binary_search(sent.ids.begin(), sent.ids.end(), id);
+}
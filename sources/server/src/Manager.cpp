@@ -17,8 +17,14 @@
 #include	"Defines.h"
 #include	"Log.hpp"
 #include	"Map.hpp"
+#include	"Match.hpp"
+#include	"MatchScheduler.hpp"
+#include	"MetricsServer.hpp"
+#include	"NetworkIo.hpp"
+#include	"WebSender.hpp"
 
 extern std::string G_ip;
+extern t_config	*G_conf;
 extern int sizeX;
 extern int sizeY;
 
@@ -52,16 +58,19 @@ void intHandler(int dummy) {
 
 
 Manager::Manager() :
-_gameEngine(NULL), _physicEngine(NULL)
+_scheduler(NULL), _networkIo(NULL), _webSender(NULL), _metricsServer(NULL)
 {
 	G_isRunning = false;
 }
 
 Manager::~Manager()
 {
-	delete _gameEngine;
-	delete _physicEngine;
-	delete _networkEngine;
+	delete _scheduler;
+	delete _metricsServer;
+	delete _webSender;
+	delete _networkIo;
+	for (unsigned int i = 0; i < _matches.size(); ++i)
+		delete _matches[i];
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -82,22 +91,43 @@ void	Manager::start()
 	S_Log->start(DEBUG_LEVEL, true);
 	VC_INFO_CRITICAL("Server is starting...");
 
-	Event::getMainEventList();
+	// The first match loads the config, the others share it
+	_networkIo = new NetworkIo();
+	_matches.push_back(new Match(0, _networkIo));
+	_matches.back()->start();
+	for (int i = 1; i < G_conf->server->matches; ++i)
+	{
+		_matches.push_back(new Match(i, _networkIo));
+		_matches.back()->start();
+	}
 
-	_gameEngine = new GameEngine();
-	_physicEngine = new PhysicEngine();
-	_gameEngine->start();
-	_physicEngine->start();
+	// Network, once every match has its queues
+	if (!_networkIo->start())
+		throw std::runtime_error("Unable to bind a port");
+	_webSender = new WebSender(_networkIo, _matches);
+	_webSender->start(G_conf->server->central_server);
 
-	S_Map->addNewObjects();
-	Event::clearEvents();
+	// Fixed timestep
+	int	tickrate = G_conf->server->tickrate;
+	if (tickrate <= 0)
+	{
+		VC_WARNING_CRITICAL("Invalid tickrate in config, using " + std::to_string(SERVER_TICKRATE));
+		tickrate = SERVER_TICKRATE;
+	}
+	_tickTime = sf::microseconds(1000000 / tickrate);
+	for (unsigned int i = 0; i < _matches.size(); ++i)
+	{
+		_matches[i]->getMap()->setFixedTimestep(_tickTime);
+		_matches[i]->getMetrics()->setTickTime(_tickTime);
+	}
+	VC_INFO_CRITICAL("Tickrate set to " + std::to_string(tickrate) + ", " + std::to_string(_matches.size()) + " matches");
 
-	// NetworkEngine
-	_networkEngine = new NetworkEngine();
-	_networkEngine->start();
+	_scheduler = new MatchScheduler(_matches, _tickTime);
 
-	// Set FPS limit
-	S_Map->setFpsLimit(SERVER_TICKRATE);
+	// Next to the game port when several servers run on the machine
+	_metricsServer = new MetricsServer(_matches);
+	if (G_conf->server->metrics_port > 0)
+		_metricsServer->start(G_conf->server->metrics_port + _networkIo->getPort() - BIND_PORT_START);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -107,33 +137,26 @@ void	Manager::start()
 void		Manager::run(void)
 {
 	VC_INFO_CRITICAL("-- Server is running. Use ctrl-C to stop it. --");
-	while (G_isRunning)
-	{
-		// Sleep & update delta time & time related events
-		S_Map->update();
-
-		// Receive packets from clients
-		_networkEngine->getReceiver()->update();
-
-		// Physic Engine
-		_physicEngine->update(S_Map->getDeltaTime());
-
-		// Game Engine
-		if (_gameEngine->update(S_Map->getDeltaTime()) == EXIT)
-			return stop();
-
-		// Network
-		//_networkEngine->update();
 
-		// Send packets (update / events) to clients
-		_networkEngine->getSender()->update();
+	// The workers tick the matches, this thread waits for ctrl-C
+	const sf::Clock	&clock = Map::MapUtils::getGlobalClock();
+	sf::Time		nextStats = clock.getElapsedTime() + sf::seconds(SERVER_STATS_PERIOD);
 
-		S_Map->addNewObjects();
-		S_Map->deleteObjects();
-
-		// Clear events
-		Event::clearEvents();
+	_scheduler->start();
+	while (G_isRunning && _scheduler->isRunning())
+	{
+		sf::sleep(sf::milliseconds(100));
+		if (clock.getElapsedTime() >= nextStats)
+		{
+			_scheduler->logStats();
+			nextStats += sf::seconds(SERVER_STATS_PERIOD);
+		}
 	}
+	_scheduler->stop();
+
+	// A tick threw, same as before from the main thread
+	if (!_scheduler->getError().empty())
+		throw std::runtime_error(_scheduler->getError());
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -144,17 +167,28 @@ void	Manager::stop(void)
 {
 	S_Log->info("Server is closing...");
 
+	// No tick while the matches are stopped
+	if (_scheduler)
+		_scheduler->stop();
+
 	// Kick all players
-	auto it = S_Map->getPlayers()->begin();
-	auto end = S_Map->getPlayers()->end();
-	while (it != end)
-	{
-		_networkEngine->getSender()->sendPacketEvent(PACKET_EVENT_KICK_PLAYER, (*it)->getId());
-		++it;
-	}
+	for (unsigned int i = 0; i < _matches.size(); ++i)
+		_matches[i]->stop();
+
+	// Stop the socket once the kicks are sent + send close to central server
+	if (_networkIo)
+		_networkIo->stop();
+	if (_metricsServer)
+		_metricsServer->stop();
+	if (_webSender)
+		_webSender->stop();
+}
 
-	// Stop the engine + send stop to web server
-	_gameEngine->stop();
-	_physicEngine->stop();
-	_networkEngine->stop();
+//////////////////////////////////////////////////////////////////////
+/////	Getterz
+//////////////////////////////////////////////////////////////////////
+
+const std::vector<Match *>	&Manager::getMatches() const
+{
+	return _matches;
 }
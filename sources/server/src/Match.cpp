@@ -0,0 +1,212 @@
+//
+// Match.cpp for Void Clash
+//
+
+#include	"Match.hpp"
+#include	"NetworkEngine.hpp"
+#include	"ClientHandle.hpp"
+#include	"Log.hpp"
+
+Match::Match(unsigned int id, NetworkIo *io) :
+_id(id), _io(io), _networkEngine(NULL), _metrics(id)
+{
+	_map = new Map::MapUtils;
+	_events = new Event::EventUtils;
+	_gameEngine = new GameEngine();
+	_physicEngine = new PhysicEngine();
+}
+
+Match::~Match()
+{
+	bind();
+	delete _networkEngine;
+	delete _gameEngine;
+	delete _physicEngine;
+	delete _map;
+	delete _events;
+	Map::MapUtils::setInstance(NULL);
+	Event::EventUtils::setInstance(NULL);
+}
+
+void	Match::bind()
+{
+	Map::MapUtils::setInstance(_map);
+	Event::EventUtils::setInstance(_events);
+	GPhysicEngine = _physicEngine;
+}
+
+///////////////////////////////////////////////
+/////   Start / stop
+
+void	Match::start()
+{
+	VC_INFO_CRITICAL("Starting match " + std::to_string(_id));
+	bind();
+	Event::getMainEventList();
+
+	_gameEngine->start();
+	_physicEngine->start();
+
+	S_Map->addNewObjects();
+	Event::clearEvents();
+
+	// Once the config is loaded (cached by the Sender)
+	_networkEngine = new NetworkEngine(_io, &_metrics);
+
+	// Before the first tick, for the registration on the central server
+	publishStatus();
+}
+
+void	Match::stop()
+{
+	bind();
+
+	// Kick all players
+	auto it = S_Map->getPlayers()->begin();
+	auto end = S_Map->getPlayers()->end();
+	while (it != end)
+	{
+		if (*it)
+			_networkEngine->getSender()->sendPacketEvent(PACKET_EVENT_KICK_PLAYER, (*it)->getId());
+		++it;
+	}
+
+	_gameEngine->stop();
+	_physicEngine->stop();
+	_networkEngine->stop();
+}
+
+///////////////////////////////////////////////
+/////   Simulation step, the match is bound
+
+bool	Match::tick()
+{
+	const sf::Clock	&clock = Map::MapUtils::getGlobalClock();
+	sf::Time		start = clock.getElapsedTime();
+	sf::Time		phase = start;
+
+	// Update delta time & time related events
+	S_Map->update();
+	endPhase(PHASE_MAP_UPDATE, phase);
+
+	// Receive packets from clients
+	_networkEngine->getReceiver()->update();
+	endPhase(PHASE_RECEIVE, phase);
+
+	// Physic Engine
+	_physicEngine->update(S_Map->getDeltaTime());
+	endPhase(PHASE_PHYSICS, phase);
+
+	// Game Engine
+	if (_gameEngine->update(S_Map->getDeltaTime()) == EXIT)
+		return false;
+
+	// Players as they are in the snapshot, for the lag compensation
+	S_Map->getHitboxHistory()->record(*S_Map->getPlayers(), S_Map->getClock().getElapsedTime());
+	endPhase(PHASE_GAME, phase);
+
+	// Send packets (update / events) to clients
+	_networkEngine->getSender()->update();
+	_networkEngine->flush();
+	endPhase(PHASE_SEND, phase);
+
+	S_Map->addNewObjects();
+	S_Map->deleteObjects();
+	endPhase(PHASE_ADD_DELETE, phase);
+
+	// Clear events
+	Event::clearEvents();
+	endPhase(PHASE_CLEAR_EVENTS, phase);
+
+	_metrics.recordTick(phase - start);
+	if (phase >= _nextSample)
+	{
+		sample();
+		_nextSample = phase + sf::seconds(METRICS_SAMPLE_PERIOD);
+	}
+	return true;
+}
+
+void	Match::endPhase(eTickPhase phase, sf::Time &start)
+{
+	sf::Time	now = Map::MapUtils::getGlobalClock().getElapsedTime();
+
+	_metrics.recordPhase(phase, now - start);
+	start = now;
+}
+
+///////////////////////////////////////////////
+/////   Metrics copied for the endpoint (not every tick)
+
+void	Match::sample()
+{
+	std::vector<unsigned int>			entities(METRICS_OBJECT_TYPES, 0);
+	std::vector<MatchMetrics::s_client>	clients;
+
+	entities[WALL] = S_Map->getWalls()->size();
+	for (EntityStore<AObject>::const_iterator it = S_Map->getElems()->begin(); it != S_Map->getElems()->end(); ++it)
+	{
+		if (*it && (*it)->getType() < METRICS_OBJECT_TYPES)
+			++entities[(*it)->getType()];
+	}
+
+	std::list<ClientHandle *>	&handles = _networkEngine->getClients();
+	for (std::list<ClientHandle *>::const_iterator it = handles.begin(); it != handles.end(); ++it)
+	{
+		MatchMetrics::s_client	client;
+
+		client.id = (*it)->getPlayer()->getId();
+		client.nick = (*it)->getPlayer()->getNick();
+		client.ip = (*it)->getIp().toString();
+		client.port = (*it)->getPort();
+		client.rtt = (*it)->getPlayer()->getLatency() / 1000.f;
+		client.inputs = (*it)->getInputs();
+		client.inputsLost = (*it)->getInputsLost();
+		clients.push_back(client);
+	}
+	_metrics.publish(entities, clients);
+	publishStatus();
+}
+
+// Copied whole, a reader never sees half of an update
+void	Match::publishStatus()
+{
+	s_status	status;
+
+	status.players = S_Map->getPlayers()->size();
+	status.map = S_Map->getMapDatabase()->getCurrentMapName();
+	status.mode = S_Map->getMode()->getModeName();
+
+	sf::Lock	lock(_statusMutex);
+	_status = status;
+}
+
+///////////////////////////////////////////////
+/////   Getterz
+
+unsigned int	Match::getId() const
+{
+	return _id;
+}
+
+Map::MapUtils	*Match::getMap()
+{
+	return _map;
+}
+
+NetworkEngine	*Match::getNetworkEngine()
+{
+	return _networkEngine;
+}
+
+MatchMetrics	*Match::getMetrics()
+{
+	return &_metrics;
+}
+
+Match::s_status	Match::getStatus() const
+{
+	sf::Lock	lock(_statusMutex);
+
+	return _status;
+}
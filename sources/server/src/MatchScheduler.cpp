@@ -0,0 +1,298 @@
+//
+// MatchScheduler.cpp for Void Clash
+//
+
+#include	<thread>
+#include	<chrono>
+#include	<functional>
+#include	<stdexcept>
+#include	"MatchScheduler.hpp"
+#include	"Match.hpp"
+#include	"Map.hpp"
+#include	"Log.hpp"
+
+MatchScheduler::MatchScheduler(const std::vector<Match *> &matches, sf::Time tickTime) :
+_matches(matches), _tickTime(tickTime), _clock(Map::MapUtils::getGlobalClock()),
+_running(false), _queued(0)
+{
+	unsigned int	count = std::thread::hardware_concurrency();
+
+	// Unknown core count, or more cores than matches to tick
+	if (count == 0)
+		count = 1;
+	if (count > _matches.size())
+		count = _matches.size();
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		_workers.push_back(new s_worker);
+		_workers.back()->thread = new sf::Thread(std::bind(&MatchScheduler::workerLoop, this, i));
+	}
+	_states.resize(_matches.size(), s_matchState());
+	VC_INFO_CRITICAL(std::to_string(count) + " workers for " + std::to_string(_matches.size()) + " matches");
+}
+
+MatchScheduler::~MatchScheduler()
+{
+	stop();
+	for (unsigned int i = 0; i < _workers.size(); ++i)
+	{
+		delete _workers[i]->thread;
+		delete _workers[i];
+	}
+}
+
+///////////////////////////////////////////////
+/////   Start / stop
+
+void	MatchScheduler::start()
+{
+	sf::Time	now = _clock.getElapsedTime();
+
+	_running = true;
+	for (unsigned int i = 0; i < _matches.size(); ++i)
+	{
+		_states[i].due = now;
+		_waiting.push_back(i);
+	}
+	for (unsigned int i = 0; i < _workers.size(); ++i)
+		_workers[i]->thread->launch();
+}
+
+void	MatchScheduler::stop()
+{
+	{
+		std::lock_guard<std::mutex>	lock(_timersMutex);
+		_running = false;
+	}
+	_wakeUp.notify_all();
+	for (unsigned int i = 0; i < _workers.size(); ++i)
+		_workers[i]->thread->wait();
+}
+
+bool	MatchScheduler::isRunning() const
+{
+	return _running;
+}
+
+const std::string	&MatchScheduler::getError() const
+{
+	return _error;
+}
+
+///////////////////////////////////////////////
+/////   Workers
+
+void	MatchScheduler::workerLoop(unsigned int index)
+{
+	unsigned int	match;
+
+	while (_running)
+	{
+		if (popTask(index, match) || stealTask(index, match))
+			runTick(index, match);
+		else
+			waitTask(index);
+	}
+}
+
+bool	MatchScheduler::popTask(unsigned int index, unsigned int &match)
+{
+	std::lock_guard<std::mutex>	lock(_workers[index]->mutex);
+
+	if (_workers[index]->tasks.empty())
+		return false;
+	match = _workers[index]->tasks.front();
+	_workers[index]->tasks.pop_front();
+	--_queued;
+	return true;
+}
+
+bool	MatchScheduler::stealTask(unsigned int index, unsigned int &match)
+{
+	for (unsigned int i = 1; i < _workers.size(); ++i)
+	{
+		s_worker					*victim = _workers[(index + i) % _workers.size()];
+		std::lock_guard<std::mutex>	lock(victim->mutex);
+
+		if (!victim->tasks.empty())
+		{
+			match = victim->tasks.back();
+			victim->tasks.pop_back();
+			--_queued;
+			return true;
+		}
+	}
+	return false;
+}
+
+void	MatchScheduler::pushTask(unsigned int index, unsigned int match)
+{
+	std::lock_guard<std::mutex>	lock(_workers[index]->mutex);
+
+	_workers[index]->tasks.push_back(match);
+	++_queued;
+}
+
+// Nothing to run: take the due matches, else wait for the next one
+bool	MatchScheduler::waitTask(unsigned int index)
+{
+	std::unique_lock<std::mutex>	lock(_timersMutex);
+
+	// Pushed since the deques were checked
+	if (!_running || _queued > 0)
+		return false;
+
+	sf::Time		now = _clock.getElapsedTime();
+	sf::Time		next;
+	bool			found = false;
+	unsigned int	taken = 0;
+	unsigned int	i = 0;
+	while (i < _waiting.size())
+	{
+		unsigned int	match = _waiting[i];
+
+		if (_states[match].due <= now)
+		{
+			pushTask(index, match);
+			_waiting[i] = _waiting.back();
+			_waiting.pop_back();
+			++taken;
+		}
+		else
+		{
+			if (!found || _states[match].due < next)
+				next = _states[match].due;
+			found = true;
+			++i;
+		}
+	}
+
+	// Several are due, the idle workers steal them
+	if (taken > 1)
+		_wakeUp.notify_all();
+	if (taken > 0)
+		return true;
+
+	// Every match is queued or running, woken up when one is done
+	if (!found)
+	{
+		_wakeUp.wait(lock);
+		return false;
+	}
+
+	sf::Time	remaining = next - now;
+	if (remaining > sf::microseconds(SERVER_SPIN_TIME))
+		_wakeUp.wait_for(lock, std::chrono::microseconds((remaining - sf::microseconds(SERVER_SPIN_TIME)).asMicroseconds()));
+	else
+	{
+		// Too close to sleep (it may wake up too late), give the core
+		lock.unlock();
+		std::this_thread::yield();
+	}
+	return false;
+}
+
+///////////////////////////////////////////////
+/////   Tick of a match, from its due time to its deadline
+
+void	MatchScheduler::runTick(unsigned int index, unsigned int match)
+{
+	sf::Time	start = _clock.getElapsedTime();
+	bool		running;
+
+	try
+	{
+		_matches[match]->bind();
+		running = _matches[match]->tick();
+	}
+	catch (const std::runtime_error &error)
+	{
+		return halt(error.what());
+	}
+	if (!running)
+		return halt("");
+
+	sf::Time						end = _clock.getElapsedTime();
+	sf::Time						skipped;
+	std::unique_lock<std::mutex>	lock(_timersMutex);
+	s_matchState					&state = _states[match];
+
+	++state.ticks;
+	state.total += end - start;
+	if (end - start > state.worst)
+		state.worst = end - start;
+	state.due += _tickTime;
+	if (end > state.due)
+		++state.overruns;
+
+	if (end < state.due)
+	{
+		state.catchUp = 0;
+		_waiting.push_back(match);
+		lock.unlock();
+		_wakeUp.notify_one();
+		return;
+	}
+
+	// Late, catch up with the next tick right now
+	if (++state.catchUp >= SERVER_MAX_CATCHUP_TICKS)
+	{
+		// Still late, drop that time instead of falling further behind
+		skipped = end - state.due;
+		state.skipped += skipped;
+		state.due = end;
+		state.catchUp = 0;
+	}
+	lock.unlock();
+	if (skipped != sf::Time::Zero)
+		VC_WARNING("Match " + std::to_string(_matches[match]->getId()) + " is late, skipping " + std::to_string(skipped.asMilliseconds()) + " ms");
+	pushTask(index, match);
+}
+
+void	MatchScheduler::halt(const std::string &error)
+{
+	{
+		std::lock_guard<std::mutex>	lock(_timersMutex);
+		if (_error.empty())
+			_error = error;
+		_running = false;
+	}
+	_wakeUp.notify_all();
+}
+
+///////////////////////////////////////////////
+/////   Stats
+
+void	MatchScheduler::logStats()
+{
+	std::vector<s_matchState>	states;
+
+	{
+		std::lock_guard<std::mutex>	lock(_timersMutex);
+		states = _states;
+		for (unsigned int i = 0; i < _states.size(); ++i)
+		{
+			_states[i].ticks = 0;
+			_states[i].overruns = 0;
+			_states[i].total = sf::Time::Zero;
+			_states[i].worst = sf::Time::Zero;
+			_states[i].skipped = sf::Time::Zero;
+		}
+	}
+
+	for (unsigned int i = 0; i < states.size(); ++i)
+	{
+		sf::Int64	average = states[i].ticks > 0 ? states[i].total.asMicroseconds() / states[i].ticks : 0;
+		std::string	stats = "Match " + std::to_string(_matches[i]->getId()) + ": "
+			+ std::to_string(states[i].ticks) + " ticks, avg " + std::to_string(average)
+			+ " us, max " + std::to_string(states[i].worst.asMicroseconds())
+			+ " us, " + std::to_string(states[i].overruns) + " over budget, "
+			+ std::to_string(states[i].skipped.asMilliseconds()) + " ms skipped";
+
+		// Always shown when a match can not keep up
+		if (states[i].overruns > 0)
+			VC_WARNING_CRITICAL(stats);
+		else
+			VC_INFO(stats);
+	}
+}
@@ -0,0 +1,346 @@
+//
+// Metrics.cpp for Void Clash
+//
+
+#include	<algorithm>
+#include	"Metrics.hpp"
+#include	"NetworkEngine.hpp"
+#include	"AObject.hpp"
+
+static_assert(PACKET_REQUEST_HORDE_DESACTIVATE - PACKET_NONE < METRICS_PACKET_TYPES, "METRICS_PACKET_TYPES is too small");
+static_assert(CAPTURE < METRICS_OBJECT_TYPES, "METRICS_OBJECT_TYPES is too small");
+
+// Percentiles written for each phase
+static const double	percentiles[] = { 50, 90, 99, 99.9 };
+static const char	*percentileNames[] = { "p50", "p90", "p99", "p999" };
+
+///////////////////////////////////////////////
+/////   Histogram
+
+Histogram::Histogram() :
+_count(0), _sum(0), _max(0)
+{
+	for (unsigned int i = 0; i < METRICS_BUCKETS; ++i)
+		_buckets[i] = 0;
+}
+
+void	Histogram::record(sf::Uint64 value)
+{
+	_buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_relaxed);
+	_sum.fetch_add(value, std::memory_order_relaxed);
+
+	sf::Uint64	max = _max.load(std::memory_order_relaxed);
+	while (value > max && !_max.compare_exchange_weak(max, value, std::memory_order_relaxed))
+		;
+}
+
+sf::Uint64	Histogram::getCount() const
+{
+	return _count.load(std::memory_order_relaxed);
+}
+
+sf::Uint64	Histogram::getSum() const
+{
+	return _sum.load(std::memory_order_relaxed);
+}
+
+sf::Uint64	Histogram::getMax() const
+{
+	return _max.load(std::memory_order_relaxed);
+}
+
+// Buckets are read one by one while the tick records, close enough
+sf::Uint64	Histogram::getPercentile(double percentile) const
+{
+	sf::Uint64	count = getCount();
+	sf::Uint64	target = static_cast<sf::Uint64>(count * percentile / 100.0 + 0.5);
+	sf::Uint64	seen = 0;
+
+	if (count == 0)
+		return 0;
+	if (target == 0)
+		target = 1;
+	for (unsigned int i = 0; i < METRICS_BUCKETS; ++i)
+	{
+		seen += _buckets[i].load(std::memory_order_relaxed);
+		if (seen >= target)
+			return std::min(highestOf(i), getMax());
+	}
+	return getMax();
+}
+
+// Exact below 2^(METRICS_SUB_BITS + 1), then the METRICS_SUB_BITS bits after the highest one
+unsigned int	Histogram::bucketOf(sf::Uint64 value)
+{
+	const sf::Uint64	limit = (static_cast<sf::Uint64>(1) << METRICS_MAX_BITS) - 1;
+	unsigned int		highest = 0;
+
+	if (value > limit)
+		value = limit;
+	if (value < (1 << (METRICS_SUB_BITS + 1)))
+		return static_cast<unsigned int>(value);
+	while ((value >> highest) > 1)
+		++highest;
+	return ((highest - METRICS_SUB_BITS) << METRICS_SUB_BITS) + static_cast<unsigned int>(value >> (highest - METRICS_SUB_BITS));
+}
+
+sf::Uint64	Histogram::highestOf(unsigned int bucket)
+{
+	if (bucket < (1 << (METRICS_SUB_BITS + 1)))
+		return bucket;
+
+	unsigned int	shift = (bucket >> METRICS_SUB_BITS) - 1;
+	sf::Uint64		mantissa = (bucket & ((1 << METRICS_SUB_BITS) - 1)) + (1 << METRICS_SUB_BITS);
+	return ((mantissa + 1) << shift) - 1;
+}
+
+///////////////////////////////////////////////
+/////   MatchMetrics
+
+MatchMetrics::MatchMetrics(unsigned int id) :
+_id(id), _overBudget(0), _entities(METRICS_OBJECT_TYPES, 0)
+{
+	for (unsigned int i = 0; i < METRICS_PACKET_TYPES; ++i)
+	{
+		_in[i].packets = 0;
+		_in[i].bytes = 0;
+		_out[i].packets = 0;
+		_out[i].bytes = 0;
+	}
+}
+
+void	MatchMetrics::setTickTime(sf::Time tickTime)
+{
+	_tickTime = tickTime;
+}
+
+void	MatchMetrics::recordPhase(eTickPhase phase, sf::Time duration)
+{
+	_phases[phase].record(duration.asMicroseconds());
+}
+
+void	MatchMetrics::recordTick(sf::Time duration)
+{
+	_phases[PHASE_TICK].record(duration.asMicroseconds());
+	if (duration > _tickTime)
+		_overBudget.fetch_add(1, std::memory_order_relaxed);
+}
+
+void	MatchMetrics::countIn(const char *data, std::size_t size)
+{
+	count(_in[packetSlot(data, size)], size);
+}
+
+void	MatchMetrics::countOut(const char *data, std::size_t size)
+{
+	count(_out[packetSlot(data, size)], size);
+}
+
+void	MatchMetrics::count(s_traffic &traffic, std::size_t size)
+{
+	traffic.packets.fetch_add(1, std::memory_order_relaxed);
+	traffic.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+// Type is the first Uint32 of the packet (network byte order)
+unsigned int	MatchMetrics::packetSlot(const char *data, std::size_t size)
+{
+	const unsigned char	*bytes = reinterpret_cast<const unsigned char *>(data);
+	sf::Uint32			type;
+
+	if (size < sizeof(sf::Uint32))
+		return 0;
+	type = (static_cast<sf::Uint32>(bytes[0]) << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+	if (type < PACKET_NONE || type - PACKET_NONE >= METRICS_PACKET_TYPES)
+		return 0;
+	return type - PACKET_NONE;
+}
+
+void	MatchMetrics::publish(const std::vector<unsigned int> &entities, const std::vector<s_client> &clients)
+{
+	sf::Lock	lock(_sampleMutex);
+
+	_entities = entities;
+	_clients = clients;
+}
+
+///////////////////////////////////////////////
+/////   Output, one line per value (Prometheus text format)
+
+void	MatchMetrics::writeText(std::ostream &out)
+{
+	std::string	match = "match=\"" + std::to_string(_id) + "\"";
+
+	out << "voidclash_tick_budget_us{" << match << "} " << _tickTime.asMicroseconds() << "\n";
+	out << "voidclash_tick_over_budget_total{" << match << "} " << _overBudget.load(std::memory_order_relaxed) << "\n";
+	for (unsigned int i = 0; i < PHASE_COUNT; ++i)
+	{
+		const Histogram	&histogram = _phases[i];
+		std::string		labels = match + ",phase=\"" + getPhaseName(static_cast<eTickPhase>(i)) + "\"";
+
+		for (unsigned int p = 0; p < sizeof(percentiles) / sizeof(*percentiles); ++p)
+			out << "voidclash_tick_phase_us{" << labels << ",quantile=\"" << percentiles[p] / 100.0 << "\"} " << histogram.getPercentile(percentiles[p]) << "\n";
+		out << "voidclash_tick_phase_us_max{" << labels << "} " << histogram.getMax() << "\n";
+		out << "voidclash_tick_phase_us_sum{" << labels << "} " << histogram.getSum() << "\n";
+		out << "voidclash_tick_phase_us_count{" << labels << "} " << histogram.getCount() << "\n";
+	}
+
+	for (unsigned int i = 0; i < METRICS_PACKET_TYPES; ++i)
+	{
+		if (getPacketName(i) == NULL)
+			continue;
+		std::string	labels = match + ",type=\"" + getPacketName(i) + "\"";
+
+		if (_in[i].packets.load(std::memory_order_relaxed) > 0)
+		{
+			out << "voidclash_packets_total{" << labels << ",direction=\"in\"} " << _in[i].packets.load(std::memory_order_relaxed) << "\n";
+			out << "voidclash_bytes_total{" << labels << ",direction=\"in\"} " << _in[i].bytes.load(std::memory_order_relaxed) << "\n";
+		}
+		if (_out[i].packets.load(std::memory_order_relaxed) > 0)
+		{
+			out << "voidclash_packets_total{" << labels << ",direction=\"out\"} " << _out[i].packets.load(std::memory_order_relaxed) << "\n";
+			out << "voidclash_bytes_total{" << labels << ",direction=\"out\"} " << _out[i].bytes.load(std::memory_order_relaxed) << "\n";
+		}
+	}
+
+	sf::Lock	lock(_sampleMutex);
+	for (unsigned int i = 0; i < _entities.size(); ++i)
+	{
+		if (getObjectName(i) != NULL)
+			out << "voidclash_entities{" << match << ",type=\"" << getObjectName(i) << "\"} " << _entities[i] << "\n";
+	}
+	for (std::vector<s_client>::const_iterator it = _clients.begin(); it != _clients.end(); ++it)
+	{
+		std::string	labels = match + ",client=\"" + std::to_string(it->id) + "\",address=\"" + it->ip + ":" + std::to_string(it->port) + "\"";
+
+		out << "voidclash_client_rtt_ms{" << labels << "} " << it->rtt << "\n";
+		out << "voidclash_client_inputs_total{" << labels << "} " << it->inputs << "\n";
+		out << "voidclash_client_inputs_lost_total{" << labels << "} " << it->inputsLost << "\n";
+	}
+}
+
+static std::string	escapeJson(const std::string &str)
+{
+	std::string	escaped;
+
+	for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+	{
+		if (*it == '"' || *it == '\\')
+			escaped += '\\';
+		if (static_cast<unsigned char>(*it) >= ' ')
+			escaped += *it;
+	}
+	return escaped;
+}
+
+void	MatchMetrics::writeJson(std::ostream &out)
+{
+	out << "{\"id\":" << _id
+		<< ",\"tick_budget_us\":" << _tickTime.asMicroseconds()
+		<< ",\"over_budget\":" << _overBudget.load(std::memory_order_relaxed)
+		<< ",\"phases\":{";
+	for (unsigned int i = 0; i < PHASE_COUNT; ++i)
+	{
+		const Histogram	&histogram = _phases[i];
+
+		out << (i > 0 ? "," : "") << "\"" << getPhaseName(static_cast<eTickPhase>(i)) << "\":{"
+			<< "\"count\":" << histogram.getCount() << ",\"sum_us\":" << histogram.getSum();
+		for (unsigned int p = 0; p < sizeof(percentiles) / sizeof(*percentiles); ++p)
+			out << ",\"" << percentileNames[p] << "_us\":" << histogram.getPercentile(percentiles[p]);
+		out << ",\"max_us\":" << histogram.getMax() << "}";
+	}
+
+	const char	*directions[] = { "in", "out" };
+	s_traffic	*traffics[] = { _in, _out };
+	out << "},\"packets\":{";
+	for (unsigned int d = 0; d < 2; ++d)
+	{
+		bool	first = true;
+
+		out << (d > 0 ? "," : "") << "\"" << directions[d] << "\":{";
+		for (unsigned int i = 0; i < METRICS_PACKET_TYPES; ++i)
+		{
+			sf::Uint64	packets = traffics[d][i].packets.load(std::memory_order_relaxed);
+
+			if (getPacketName(i) == NULL || packets == 0)
+				continue;
+			out << (first ? "" : ",") << "\"" << getPacketName(i) << "\":{\"packets\":" << packets
+				<< ",\"bytes\":" << traffics[d][i].bytes.load(std::memory_order_relaxed) << "}";
+			first = false;
+		}
+		out << "}";
+	}
+
+	sf::Lock	lock(_sampleMutex);
+	bool		first = true;
+	out << "},\"entities\":{";
+	for (unsigned int i = 0; i < _entities.size(); ++i)
+	{
+		if (getObjectName(i) == NULL)
+			continue;
+		out << (first ? "" : ",") << "\"" << getObjectName(i) << "\":" << _entities[i];
+		first = false;
+	}
+	out << "},\"clients\":[";
+	for (std::vector<s_client>::const_iterator it = _clients.begin(); it != _clients.end(); ++it)
+	{
+		out << (it != _clients.begin() ? "," : "") << "{\"id\":" << it->id
+			<< ",\"nick\":\"" << escapeJson(it->nick) << "\""
+			<< ",\"address\":\"" << it->ip << ":" << it->port << "\""
+			<< ",\"rtt_ms\":" << it->rtt
+			<< ",\"inputs\":" << it->inputs
+			<< ",\"inputs_lost\":" << it->inputsLost << "}";
+	}
+	out << "]}";
+}
+
+///////////////////////////////////////////////
+/////   Names
+
+const char	*MatchMetrics::getPhaseName(eTickPhase phase)
+{
+	static const char	*names[PHASE_COUNT] =
+	{
+		"map_update", "receive", "physics", "game", "send", "add_delete", "clear_events", "tick"
+	};
+
+	return names[phase];
+}
+
+// NULL when the slot is not a type
+const char	*MatchMetrics::getPacketName(unsigned int slot)
+{
+	static const char	*names[] =
+	{
+		"UNKNOWN",
+		"VERSION_CHECK", "EVENT_IDENT", "CONFIRMATION", "WELCOME", "CONFIG",
+		"INPUT", "UPDATE", "SYNCHRO", "EVENT_ADD", "EVENT_DELETE", "WORLD_DATA", "FRAGMENT", "RELIABLE",
+		"DISPLAY_STRING", "EVENT_CHAT", "EVENT_JOIN_TEAM", "NICKNAME_CHANGE", "PING", "WEAPON_SELECTION",
+		"RESET_ROUND", "GAME_START", "MAP_LIST", "EVENT_SERVER_FULL", "EVENT_SWITCH_MAP_MODE",
+		"EVENT_KICK_PLAYER", "EVENT_QUIT",
+		"EVENT_KILL", "EVENT_PLAYER_HIT", "EVENT_LAUNCHED", "EVENT_CAPTURE_FLAG", "EVENT_TURRET_DESTROYED",
+		"REQUEST_CHANGE_MAP", "REQUEST_CHANGE_MODE", "REQUEST_PLAYER_KICK", "REQUEST_HORDE_ACTIVATE",
+		"REQUEST_HORDE_DESACTIVATE"
+	};
+	static_assert(sizeof(names) / sizeof(*names) == PACKET_REQUEST_HORDE_DESACTIVATE - PACKET_NONE + 1, "A packet type has no name");
+
+	if (slot >= sizeof(names) / sizeof(*names))
+		return NULL;
+	return names[slot];
+}
+
+const char	*MatchMetrics::getObjectName(unsigned int type)
+{
+	static const char	*names[] =
+	{
+		"NONE", "WALL", "PLAYER", "BOT",
+		"BULLET", "BOMB", "ROCKET", "TURRET", "SHIELD",
+		"EXPLOSION", "GRAVITY_FIELD", "SPEED_FIELD", "RESPAWN", "FLAG", "CAPTURE"
+	};
+	static_assert(sizeof(names) / sizeof(*names) == CAPTURE + 1, "An object type has no name");
+
+	if (type >= sizeof(names) / sizeof(*names))
+		return NULL;
+	return names[type];
+}
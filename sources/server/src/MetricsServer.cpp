@@ -0,0 +1,180 @@
+//
+// MetricsServer.cpp for Void Clash
+//
+
+#include	<sstream>
+#include	<cstring>
+#include	"MetricsServer.hpp"
+#include	"Match.hpp"
+#include	"Log.hpp"
+
+#if defined (_WIN32)
+#include	<winsock2.h>
+#define		METRICS_WOULD_BLOCK	(WSAGetLastError() == WSAEWOULDBLOCK)
+#else
+#include	<cerrno>
+#include	<sys/socket.h>
+#include	<netinet/in.h>
+#include	<arpa/inet.h>
+#define		METRICS_WOULD_BLOCK	(errno == EAGAIN || errno == EWOULDBLOCK)
+#endif
+
+#ifndef		MSG_NOSIGNAL
+# define	MSG_NOSIGNAL	0
+#endif
+
+sf::Socket::Status	LocalTcpListener::listenLocal(unsigned short port)
+{
+	sockaddr_in	address;
+
+	close();
+	create();
+	std::memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (::bind(getHandle(), reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1
+		|| ::listen(getHandle(), SOMAXCONN) == -1)
+	{
+		close();
+		return sf::Socket::Error;
+	}
+	return sf::Socket::Done;
+}
+
+MetricsServer::MetricsServer(const std::vector<Match *> &matches) :
+_matches(matches), _thread(&MetricsServer::serverLoop, this), _running(false)
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+	stop();
+}
+
+bool	MetricsServer::start(unsigned short port)
+{
+	if (_listener.listenLocal(port) != sf::Socket::Done)
+	{
+		VC_WARNING_CRITICAL("Unable to bind port " + std::to_string(port) + " for the metrics");
+		return false;
+	}
+	_listener.setBlocking(false);
+	_running = true;
+	_thread.launch();
+	VC_INFO_CRITICAL("Metrics on port " + std::to_string(port));
+	return true;
+}
+
+void	MetricsServer::stop()
+{
+	if (!_running)
+		return;
+	_running = false;
+	_thread.wait();
+	_listener.close();
+}
+
+///////////////////////////////////////////////
+/////   Metrics thread, one request at a time
+
+void	MetricsServer::serverLoop()
+{
+	sf::SocketSelector	selector;
+
+	selector.add(_listener);
+	while (_running)
+	{
+		if (!selector.wait(sf::milliseconds(METRICS_WAIT_TIME)))
+			continue;
+
+		MetricsSocket	client;
+		if (_listener.accept(client) != sf::Socket::Done)
+			continue;
+		answer(client);
+	}
+}
+
+void	MetricsServer::answer(MetricsSocket &client)
+{
+	sf::SocketSelector	selector;
+	char				request[1024];
+	std::size_t			received = 0;
+
+	// First line only, the rest of the request is ignored
+	client.setBlocking(false);
+	selector.add(client);
+	if (!selector.wait(sf::milliseconds(METRICS_REQUEST_TIMEOUT))
+		|| client.receive(request, sizeof(request), received) != sf::Socket::Done)
+		return;
+
+	std::string			line(request, received);
+	line = line.substr(0, line.find_first_of("\r\n"));
+	bool				http = line.compare(0, 4, "GET ") == 0;
+	bool				json = line.find("json") != std::string::npos;
+	std::ostringstream	body;
+
+	if (json)
+	{
+		body << "{\"matches\":[";
+		for (unsigned int i = 0; i < _matches.size(); ++i)
+		{
+			body << (i > 0 ? "," : "");
+			_matches[i]->getMetrics()->writeJson(body);
+		}
+		body << "]}\n";
+	}
+	else
+	{
+		for (unsigned int i = 0; i < _matches.size(); ++i)
+			_matches[i]->getMetrics()->writeText(body);
+	}
+
+	std::string	response;
+	if (http)
+	{
+		response = "HTTP/1.0 200 OK\r\nContent-Type: ";
+		response += json ? "application/json" : "text/plain; version=0.0.4";
+		response += "\r\nContent-Length: " + std::to_string(body.str().size()) + "\r\nConnection: close\r\n\r\n";
+	}
+	response += body.str();
+	if (!sendAll(client, response))
+		return;
+
+	// Closed by the client first, the port is not kept in TIME_WAIT
+	// and the server can be restarted at once
+	sf::Clock	clock;
+	std::size_t	drained = 0;
+	while (_running && drained < METRICS_DRAIN_MAX
+		&& clock.getElapsedTime() < sf::milliseconds(METRICS_DRAIN_TIMEOUT)
+		&& selector.wait(sf::milliseconds(METRICS_WAIT_TIME)))
+	{
+		sf::Socket::Status	status = client.receive(request, sizeof(request), received);
+
+		if (status == sf::Socket::Done)
+			drained += received;
+		else if (status != sf::Socket::NotReady)
+			break;
+	}
+}
+
+// Non blocking socket: SFML 2.2 loses what a partial send wrote
+bool	MetricsServer::sendAll(MetricsSocket &client, const std::string &data)
+{
+	sf::Clock	clock;
+	std::size_t	sent = 0;
+
+	while (sent < data.size())
+	{
+		int	result = ::send(client.getHandle(), data.data() + sent, static_cast<int>(data.size() - sent), MSG_NOSIGNAL);
+
+		if (result > 0)
+			sent += result;
+		else if (result < 0 && METRICS_WOULD_BLOCK && _running
+				 && clock.getElapsedTime() < sf::milliseconds(METRICS_SEND_TIMEOUT))
+			sf::sleep(sf::milliseconds(1));
+		else
+			return false;
+	}
+	return true;
+}
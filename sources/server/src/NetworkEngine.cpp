@@ -7,51 +7,113 @@
 #include	"main.hpp"
 #include	"Defines.h"
 #include	"Log.hpp"
+#include	"ConfigParser.hpp"
+#include	"Metrics.hpp"
+
+extern t_config *G_conf;
 
 ///////////////////////////////////////////////
 /////   NetworkEngine class
 
-NetworkEngine::NetworkEngine()
+NetworkEngine::NetworkEngine(NetworkIo *io, MatchMetrics *metrics) :
+_io(io), _metrics(metrics), _inDropped(0), _splitter(PACKET_FRAGMENT), _assembler(PACKET_FRAGMENT)
 {
+	_inQueue = new RingBuffer<s_datagram, IO_QUEUE_IN_SIZE>();
+	_outQueue = new RingBuffer<s_datagram, IO_QUEUE_OUT_SIZE>();
 	_sender = new Sender(this);
 	_receiver = new Receiver(this);
-	_webSender = new WebSender(this);
+	_io->addEngine(this);
 }
 
 NetworkEngine::~NetworkEngine()
 {
-	delete _webSender;
 	delete _receiver;
 	delete _sender;
+	delete _outQueue;
+	delete _inQueue;
+}
+
+void	NetworkEngine::stop()
+{
+	// Flush what is already queued (kicks...), sent before the I/O thread stops
+	_sender->flushClients();
+	flush();
+}
+
+void	NetworkEngine::update()
+{
 }
 
-bool NetworkEngine::start()
+///////////////////////////////////////////////
+/////   Simulation side of the I/O queues
+
+bool	NetworkEngine::send(sf::Packet &packet, const sf::IpAddress &ip, unsigned short port)
 {
-	int port = BIND_PORT_START;
-	while (port != BIND_PORT_END)
+	if (packet.getDataSize() == 0)
+		return false;
+	if (packet.getDataSize() <= static_cast<unsigned int>(G_conf->server->mtu))
+		return pushDatagram(packet, ip, port);
+
+	// Too big for one datagram, no IP fragmentation
+	unsigned int	count = _splitter.split(packet, G_conf->server->mtu);
+	if (count == 0)
 	{
-		if (_serverSocket.bind(port) == sf::Socket::Done)
-		{
-			_serverSocket.setBlocking(false);
-			if (!_webSender->sendCreate())
-				return (false);
-			VC_INFO_CRITICAL("Bind done on port " + std::to_string(port));
-			return (true);
-		}
-		VC_WARNING_CRITICAL("Unable to bind port :" + std::to_string(port));
-		++port;
+		printLog(1, "Packet of " + std::to_string(packet.getDataSize()) + " bytes is too big, dropping it for " + ip.toString());
+		return false;
 	}
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		if (!pushDatagram(_splitter.getFragment(i), ip, port))
+			return false;
+	}
+	return true;
+}
 
-	return false;
+bool	NetworkEngine::pushDatagram(sf::Packet &packet, const sf::IpAddress &ip, unsigned short port)
+{
+	s_datagram	*datagram = _outQueue->reserve();
+	if (datagram == NULL)
+	{
+		printLog(1, "Outgoing queue is full, dropping packet for " + ip.toString());
+		return false;
+	}
+	const char	*data = static_cast<const char *>(packet.getData());
+	datagram->ip = ip;
+	datagram->port = port;
+	datagram->data.assign(data, data + packet.getDataSize());
+	_outQueue->push();
+	_metrics->countOut(data, packet.getDataSize());
+	return true;
 }
 
-void	NetworkEngine::stop()
+void	NetworkEngine::flush()
 {
-	_webSender->sendClose();
+	_outQueue->publish();
 }
 
-void	NetworkEngine::update()
+bool	NetworkEngine::receive(sf::Packet &packet, sf::IpAddress &ip, unsigned short &port, sf::Time &arrival)
 {
+	sf::Uint32	dropped = _inDropped.exchange(0);
+	if (dropped > 0)
+		printLog(1, "Incoming queue was full, " + std::to_string(dropped) + " packets dropped");
+
+	s_datagram	*datagram;
+	while ((datagram = _inQueue->front()) != NULL)
+	{
+		packet.clear();
+		if (!datagram->data.empty())
+			packet.append(datagram->data.data(), datagram->data.size());
+		_metrics->countIn(datagram->data.data(), datagram->data.size());
+		ip = datagram->ip;
+		port = datagram->port;
+		arrival = datagram->arrival;
+		_inQueue->pop();
+
+		// Fragments are kept until their packet is complete
+		if (!_assembler.isFragment(packet) || _assembler.add(packet, ip, port, arrival))
+			return true;
+	}
+	return false;
 }
 
 void	NetworkEngine::addNewClient(const sf::IpAddress & ip, unsigned short port)
@@ -60,6 +122,8 @@ void	NetworkEngine::addNewClient(const sf::IpAddress & ip, unsigned short port)
 
 	ClientHandle	*client = new ClientHandle(this, ip, port);
 	_clients.push_back(client);
+	_clientsByAddress[addressKey(ip, port)] = client;
+	_clientsById[client->getPlayer()->getId()] = client;
 	_sender->sendPacketEvent(PACKET_VERSION_CHECK, VOID_CLASH_VERSION, client);
 	_sender->sendPacketEvent(PACKET_EVENT_IDENT, client->getPlayer()->getId(), client);
 	printClientsInfo();
@@ -67,6 +131,19 @@ void	NetworkEngine::addNewClient(const sf::IpAddress & ip, unsigned short port)
 	_sender->sendStringToDisplay(strToSend, 2);
 }
 
+std::list<ClientHandle *>::iterator	NetworkEngine::removeClient(std::list<ClientHandle *>::iterator it)
+{
+	_clientsByAddress.erase(addressKey((*it)->getIp(), (*it)->getPort()));
+	_clientsById.erase((*it)->getPlayer()->getId());
+	closeSession((*it)->getIp(), (*it)->getPort());
+	return _clients.erase(it);
+}
+
+void	NetworkEngine::closeSession(const sf::IpAddress &ip, unsigned short port)
+{
+	_io->closeSession(ip, port);
+}
+
 void	NetworkEngine::pingClients()
 {
 	for (std::list<ClientHandle *>::iterator it = _clients.begin(); it != _clients.end(); ++it)
@@ -105,61 +182,42 @@ void		NetworkEngine::printLogWithId(int level, const std::string &msg, const sf:
 
 // find funcs
 
+sf::Uint64	NetworkEngine::addressKey(const sf::IpAddress &ip, unsigned short port)
+{
+	return (static_cast<sf::Uint64>(ip.toInteger()) << 16) | port;
+}
+
 std::shared_ptr<AObject> NetworkEngine::findObjectWithID(sf::Uint32 id)
 {
-	std::list<std::shared_ptr<AObject>>			*list = S_Map->getElems();
-	std::list<std::shared_ptr<AObject>>::iterator        it = list->begin();
-	std::list<std::shared_ptr<AObject>>::iterator        end = list->end();
-	while (it != end)
-	{
-		if ((*it)->getId() == id)
-			return (*it);
-		++it;
-	}
-	return NULL;
+	return S_Map->findObjectWithID(id);
 }
 
 std::shared_ptr<Player>	NetworkEngine::findPlayerWithIP(sf::IpAddress ip, unsigned short port)
 {
-	auto	it = _clients.begin();
-	auto	end = _clients.end();
+	ClientHandle	*client = findClientHandleWithIP(ip, port);
 
-	while (it != end)
-	{
-		if ((*it)->getIp().toInteger() == ip.toInteger() && (*it)->getPort() == port)
-			return (*it)->getPlayer();
-		++it;
-	}
-	return NULL;
+	if (client == NULL)
+		return NULL;
+	return client->getPlayer();
 }
 
 ClientHandle	*NetworkEngine::findClientHandleWithIP(sf::IpAddress ip, unsigned short port)
 {
-	std::list<ClientHandle *>::iterator	it = _clients.begin();
-	std::list<ClientHandle *>::iterator	end = _clients.end();
+	auto	found = _clientsByAddress.find(addressKey(ip, port));
 
-	while (it != end)
-	{
-		if ((*it)->getIp().toInteger() == ip.toInteger() && (*it)->getPort() == port)
-			return (*it);
-		++it;
-	}
-	return NULL;
+	if (found == _clientsByAddress.end())
+		return NULL;
+	return found->second;
 }
 
 
 ClientHandle	*NetworkEngine::findClientHandleWithID(sf::Uint32 id)
 {
-	std::list<ClientHandle *>::iterator	it = _clients.begin();
-	std::list<ClientHandle *>::iterator	end = _clients.end();
+	auto	found = _clientsById.find(id);
 
-	while (it != end)
-	{
-		if ((*it)->getPlayer()->getId() == id)
-			return (*it);
-		++it;
-	}
-	return NULL;
+	if (found == _clientsById.end())
+		return NULL;
+	return found->second;
 }
 
 ///////////////////////////////////////////////
@@ -170,11 +228,6 @@ std::list<ClientHandle *>	&NetworkEngine::getClients()
 	return (_clients);
 }
 
-sf::UdpSocket	*NetworkEngine::getSocket()
-{
-	return (&_serverSocket);
-}
-
 Sender		*NetworkEngine::getSender()
 {
 	return (_sender);
@@ -185,11 +238,6 @@ Receiver	*NetworkEngine::getReceiver()
 	return (_receiver);
 }
 
-WebSender	*NetworkEngine::getWebSender()
-{
-	return (_webSender);
-}
-
 ///////////////////////////////////////////////
 /////   Debug functions
 
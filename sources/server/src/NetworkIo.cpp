@@ -0,0 +1,225 @@
+//
+// NetworkIo.cpp for Void Clash
+//
+
+#include	"NetworkIo.hpp"
+#include	"NetworkEngine.hpp"
+#include	"Map.hpp"
+#include	"Defines.h"
+#include	"Log.hpp"
+#include	"ConfigParser.hpp"
+
+extern t_config *G_conf;
+
+NetworkIo::NetworkIo() :
+_port(0), _thread(&NetworkIo::ioLoop, this), _running(false)
+{
+	_batch = new UdpBatch(_socket);
+}
+
+NetworkIo::~NetworkIo()
+{
+	stop();
+	delete _batch;
+}
+
+void	NetworkIo::addEngine(NetworkEngine *engine)
+{
+	_engines.push_back(engine);
+	_sessionCounts.push_back(0);
+}
+
+bool	NetworkIo::start()
+{
+	int port = BIND_PORT_START;
+	while (port != BIND_PORT_END)
+	{
+		if (_socket.bind(port) == sf::Socket::Done)
+		{
+			_socket.setBlocking(false);
+			_port = port;
+			_running = true;
+			_thread.launch();
+			VC_INFO_CRITICAL("Bind done on port " + std::to_string(port));
+			return (true);
+		}
+		VC_WARNING_CRITICAL("Unable to bind port :" + std::to_string(port));
+		++port;
+	}
+
+	return false;
+}
+
+void	NetworkIo::stop()
+{
+	if (!_running)
+		return;
+	_running = false;
+	_thread.wait();
+}
+
+unsigned short	NetworkIo::getPort() const
+{
+	return _port;
+}
+
+///////////////////////////////////////////////
+/////   Sessions
+
+void	NetworkIo::closeSession(const sf::IpAddress &ip, unsigned short port)
+{
+	sf::Lock	lock(_sessionsMutex);
+	auto		found = _sessions.find(NetworkEngine::addressKey(ip, port));
+
+	if (found == _sessions.end())
+		return;
+	--_sessionCounts[found->second.match];
+	_sessions.erase(found);
+}
+
+// Type of a packet sent by the clients, anything else (junk, scans...)
+// is dropped without a session
+bool	NetworkIo::opensSession(const s_datagram &datagram)
+{
+	const unsigned char	*bytes = reinterpret_cast<const unsigned char *>(&datagram.data[0]);
+	sf::Uint32			type;
+
+	if (datagram.data.size() < sizeof(type))
+		return false;
+	// sf::Packet writes in network byte order
+	type = (static_cast<sf::Uint32>(bytes[0]) << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
+	return type > PACKET_NONE && type <= PACKET_REQUEST_HORDE_DESACTIVATE && type != PACKET_EVENT_QUIT;
+}
+
+// _sessionsMutex is locked
+unsigned int	NetworkIo::chooseMatch() const
+{
+	// Matches are filled one after the other, when all are full the
+	// least crowded one tells the client (PACKET_EVENT_SERVER_FULL)
+	unsigned int	match = 0;
+	for (unsigned int i = 0; i < _engines.size(); ++i)
+	{
+		if (_sessionCounts[i] < static_cast<unsigned int>(G_conf->server->max_player))
+		{
+			match = i;
+			break;
+		}
+		if (_sessionCounts[i] < _sessionCounts[match])
+			match = i;
+	}
+	return match;
+}
+
+// Clients which left without PACKET_EVENT_QUIT
+void	NetworkIo::expireSessions(sf::Time now)
+{
+	sf::Lock	lock(_sessionsMutex);
+
+	for (auto it = _sessions.begin(); it != _sessions.end();)
+	{
+		if ((now - it->second.lastArrival).asSeconds() > IO_SESSION_TIMEOUT)
+		{
+			--_sessionCounts[it->second.match];
+			it = _sessions.erase(it);
+		}
+		else
+			++it;
+	}
+}
+
+///////////////////////////////////////////////
+/////   I/O thread
+
+void	NetworkIo::ioLoop()
+{
+	sf::SocketSelector	selector;
+	const sf::Clock		&clock = Map::MapUtils::getGlobalClock();
+	sf::Time			nextSweep = clock.getElapsedTime() + sf::seconds(IO_SESSION_SWEEP);
+
+	selector.add(_socket);
+	while (_running)
+	{
+		if (selector.wait(sf::microseconds(IO_WAIT_TIME)))
+			ioReceive();
+		ioSend();
+		if (clock.getElapsedTime() >= nextSweep)
+		{
+			expireSessions(clock.getElapsedTime());
+			nextSweep += sf::seconds(IO_SESSION_SWEEP);
+		}
+	}
+	ioSend();
+}
+
+void	NetworkIo::ioReceive()
+{
+	s_datagram		*datagrams[UDP_BATCH_SIZE];
+	unsigned int	received;
+
+	for (unsigned int i = 0; i < UDP_BATCH_SIZE; ++i)
+		datagrams[i] = &_received[i];
+	while ((received = _batch->receive(datagrams, UDP_BATCH_SIZE)) > 0)
+	{
+		sf::Time	arrival = Map::MapUtils::getGlobalClock().getElapsedTime();
+		sf::Lock	lock(_sessionsMutex);
+
+		for (unsigned int i = 0; i < received; ++i)
+		{
+			sf::Uint64	key = NetworkEngine::addressKey(_received[i].ip, _received[i].port);
+			auto		found = _sessions.find(key);
+			bool		opened = found == _sessions.end();
+
+			if (opened && !opensSession(_received[i]))
+				continue;
+
+			unsigned int	match = opened ? chooseMatch() : found->second.match;
+			NetworkEngine	*engine = _engines[match];
+			s_datagram		*datagram = engine->_inQueue->reserve();
+
+			// Queue of this match is full, no session for a datagram it never sees
+			if (datagram == NULL)
+			{
+				++engine->_inDropped;
+				continue;
+			}
+			if (opened)
+			{
+				s_session	session;
+
+				session.match = match;
+				found = _sessions.insert(std::make_pair(key, session)).first;
+				++_sessionCounts[match];
+			}
+			found->second.lastArrival = arrival;
+			datagram->ip = _received[i].ip;
+			datagram->port = _received[i].port;
+			datagram->arrival = arrival;
+			datagram->data.swap(_received[i].data);
+			engine->_inQueue->push();
+		}
+		for (unsigned int i = 0; i < _engines.size(); ++i)
+			_engines[i]->_inQueue->publish();
+	}
+}
+
+void	NetworkIo::ioSend()
+{
+	s_datagram		*datagrams[UDP_BATCH_SIZE];
+	unsigned int	count;
+
+	for (unsigned int i = 0; i < _engines.size(); ++i)
+	{
+		RingBuffer<s_datagram, IO_QUEUE_OUT_SIZE>	*queue = _engines[i]->_outQueue;
+
+		do
+		{
+			count = 0;
+			while (count < UDP_BATCH_SIZE && (datagrams[count] = queue->front(count)) != NULL)
+				++count;
+			if (count > 0)
+				_batch->send(datagrams, count);
+			queue->pop(count);
+		}
+		while (count == UDP_BATCH_SIZE);
+	}
+}
@@ -44,92 +44,138 @@ bool	Receiver::update()
 {
 	sf::IpAddress		ip;
 	unsigned short	port;
+	sf::Time		arrival;
 	sf::Uint32		type;
 
-	_packet.clear();
-	while (_networkEngine->getSocket()->receive(_packet, ip, port) == sf::Socket::Done)
+	// Datagrams are received by the network I/O thread, arrival is the time it got them
+	while (_networkEngine->receive(_packet, ip, port, arrival))
+	{
+		updateClientActivity(ip, port, arrival);
+		_packet >> type;
+		handlePacket(type, ip, port, arrival);
+		_packet.clear();
+	}
+	checkClientsActivity();
+
+	// One command of each client per tick, whatever was received
+	for (std::list<ClientHandle *>::iterator it = _networkEngine->getClients().begin();
+		it != _networkEngine->getClients().end(); ++it)
+		(*it)->applyActions();
+	return (true);
+}
+
+///////////////////////////////////////////////
+/////   Execute or call function according
+/////	to packet type
+
+void	Receiver::handlePacket(sf::Uint32 type, sf::IpAddress ip, unsigned short port, sf::Time arrival)
+{
+	ClientHandle *client = _networkEngine->findClientHandleWithIP(ip, port);
+	if (type == PACKET_INPUT)
+		updateClientInput(ip, port, arrival);
+	else if (type == PACKET_CONFIRMATION)
 	{
-		updateClientActivity(ip, port);
-		ClientHandle *client = _networkEngine->findClientHandleWithIP(ip, port);
 		_packet >> type;
-		if (type == PACKET_INPUT)
-			updateClientInput(ip, port);
-		else if (type == PACKET_CONFIRMATION)
+		if (client)
 		{
-			_packet >> type;
-			if (client)
+			if (type == PACKET_EVENT_IDENT)
 			{
-				if (type == PACKET_EVENT_IDENT)
-				{
-					_networkEngine->printLogWithId(2, "Confirmation packet of PACKET_EVENT_IDENT received from ", client->getPlayer()->getId());
-					_networkEngine->getSender()->sendConfig(client);
-					client->setStarted(true);
-				}
-				if (type == PACKET_CONFIG)
-				{
-					_networkEngine->printLogWithId(2, "Confirmation packet of PACKET_CONFIG received from ", client->getPlayer()->getId());
-					_networkEngine->getSender()->sendPacketGeneric(PACKET_WELCOME, client);
-					_networkEngine->getSender()->sendPacketEvent(PACKET_EVENT_SWITCH_MAP_MODE, S_Map->getMode()->getModeEnum(), client);
-					_networkEngine->getSender()->sendMapList(client);
-				}
+				// Hash of the config the client already has, 0 if none
+				sf::Uint32	configHash = 0;
+
+				_packet >> configHash;
+				_networkEngine->printLogWithId(2, "Confirmation packet of PACKET_EVENT_IDENT received from ", client->getPlayer()->getId());
+				_networkEngine->getSender()->sendConfig(client, configHash);
+				client->setStarted(true);
+			}
+			if (type == PACKET_CONFIG)
+			{
+				_networkEngine->printLogWithId(2, "Confirmation packet of PACKET_CONFIG received from ", client->getPlayer()->getId());
+				_networkEngine->getSender()->sendPacketGeneric(PACKET_WELCOME, client);
+				_networkEngine->getSender()->sendPacketEvent(PACKET_EVENT_SWITCH_MAP_MODE, S_Map->getMode()->getModeEnum(), client);
+				_networkEngine->getSender()->sendMapList(client);
 			}
-			else
-				_networkEngine->printLog(1, "Confirmation packet received but unable to find player");
-		}
-		else if (type == PACKET_PING)
-			client->pong(_packet);
-		else if (type == PACKET_EVENT_CHAT)
-			handleChat(ip, port);
-		else if (type == PACKET_EVENT_JOIN_TEAM)
-			playerJoinTeam(ip, port);
-		else if (type == PACKET_WEAPON_SELECTION)
-			handleWeaponSelection(ip, port);
-		else if (type == PACKET_EVENT_QUIT)
-			handleQuit(ip, port);
-		else if (type == PACKET_NICKNAME_CHANGE)
-			handleChangeNick(ip, port);
-		else if (type == PACKET_REQUEST_CHANGE_MAP)
-			handleRequestSwitchMap(ip, port);
-		else if (type == PACKET_REQUEST_CHANGE_MODE)
-			handleRequestSwitchMode(ip, port);
-		else if (type == PACKET_REQUEST_PLAYER_KICK)
-			handleRequestPlayerKick(ip, port);
-		else if (type == PACKET_REQUEST_HORDE_ACTIVATE)
-		{
-			if (!client->isAdmin())
-				_networkEngine->getSender()->sendStringToDisplay("Unauthorized access to activate horde. Use /auth password", 0, client);
-			else
-				S_Map->getMode()->activeHorde();
-		}
-		else if (type == PACKET_REQUEST_HORDE_DESACTIVATE)
-		{
-			if (!client->isAdmin())
-				_networkEngine->getSender()->sendStringToDisplay("Unauthorized access to desactivate horde. Use /auth password", 0, client);
-			else
-				S_Map->getMode()->desactiveHorde();
 		}
 		else
-		{
-			_networkEngine->printLog(1, "Packet integrity check failed. Clearing it...");
-			_packet.clear();
-		}
+			_networkEngine->printLog(1, "Confirmation packet received but unable to find player");
+	}
+	else if (type == PACKET_RELIABLE)
+		handleReliable(ip, port, arrival);
+	else if (type == PACKET_PING)
+		client->pong(_packet);
+	else if (type == PACKET_EVENT_CHAT)
+		handleChat(ip, port);
+	else if (type == PACKET_EVENT_JOIN_TEAM)
+		playerJoinTeam(ip, port);
+	else if (type == PACKET_WEAPON_SELECTION)
+		handleWeaponSelection(ip, port);
+	else if (type == PACKET_EVENT_QUIT)
+		handleQuit(ip, port);
+	else if (type == PACKET_NICKNAME_CHANGE)
+		handleChangeNick(ip, port);
+	else if (type == PACKET_REQUEST_CHANGE_MAP)
+		handleRequestSwitchMap(ip, port);
+	else if (type == PACKET_REQUEST_CHANGE_MODE)
+		handleRequestSwitchMode(ip, port);
+	else if (type == PACKET_REQUEST_PLAYER_KICK)
+		handleRequestPlayerKick(ip, port);
+	else if (type == PACKET_REQUEST_HORDE_ACTIVATE)
+	{
+		if (!client->isAdmin())
+			_networkEngine->getSender()->sendStringToDisplay("Unauthorized access to activate horde. Use /auth password", 0, client);
+		else
+			S_Map->getMode()->activeHorde();
+	}
+	else if (type == PACKET_REQUEST_HORDE_DESACTIVATE)
+	{
+		if (!client->isAdmin())
+			_networkEngine->getSender()->sendStringToDisplay("Unauthorized access to desactivate horde. Use /auth password", 0, client);
+		else
+			S_Map->getMode()->desactiveHorde();
+	}
+	else
+	{
+		_networkEngine->printLog(1, "Packet integrity check failed. Clearing it...");
 		_packet.clear();
 	}
-	checkClientsActivity();
-	return (true);
+}
+
+///////////////////////////////////////////////
+/////   Messages of the reliable channel of a client
+/////	Handled like the other packets, in the order he sent them
+
+void	Receiver::handleReliable(sf::IpAddress ip, unsigned short port, sf::Time arrival)
+{
+	ClientHandle	*client = _networkEngine->findClientHandleWithIP(ip, port);
+	sf::Uint32		type;
+
+	if (client == NULL)
+		return;
+	if (!client->getChannel().receive(_packet))
+	{
+		_networkEngine->printLog(1, "Reliable packet integrity check failed. Clearing it...");
+		return;
+	}
+	// The client can leave while his messages are handled
+	while ((client = _networkEngine->findClientHandleWithIP(ip, port)) != NULL &&
+		client->getChannel().popMessage(_packet))
+	{
+		if ((_packet >> type) && type != PACKET_RELIABLE)
+			handlePacket(type, ip, port, arrival);
+	}
 }
 
 ///////////////////////////////////////////////
 /////   Receive inputs from clients
 /////	Create new client if IP is not registered
 
-void	Receiver::updateClientInput(sf::IpAddress ip, unsigned short port)
+void	Receiver::updateClientInput(sf::IpAddress ip, unsigned short port, sf::Time arrival)
 {
 	ClientHandle *client;
 	client = _networkEngine->findClientHandleWithIP(ip, port);
 	if (client == NULL)
 		return;
-	client->setActions(_packet);
+	client->setActions(_packet, arrival);
 }
 
 void	Receiver::handleChat(sf::IpAddress ip, unsigned short port)
@@ -140,12 +186,17 @@ void	Receiver::handleChat(sf::IpAddress ip, unsigned short port)
 	_packet.clear();
 	if (_command->chatHandle(msg, ip, port)) // Don't send commands to clients
 		return;
+
+	std::shared_ptr<Player>	player = _networkEngine->findPlayerWithIP(ip, port);
+	if (player == NULL)
+		return;
+
 	_packet << PACKET_EVENT_CHAT;
-	_packet << _networkEngine->findPlayerWithIP(ip, port)->getId();
+	_packet << player->getId();
 	_packet << msg;
 	_networkEngine->getSender()->sendPacket(_packet);
 	_networkEngine->printLogWithId(2, "Message received : \"" + msg + "\" from player ",
-		_networkEngine->findPlayerWithIP(ip, port)->getId());
+		player->getId());
 }
 
 void	Receiver::playerJoinTeam(sf::IpAddress ip, unsigned short port)
@@ -221,7 +272,7 @@ void	Receiver::handleQuit(sf::IpAddress ip, unsigned short port)
 				_networkEngine->printLogWithId(2, "Client is flagged as disconnect. Id of player is ", (*it)->getPlayer()->getId(), YELLOW);
 				ADD_EVENT(ev_DELETE, std::dynamic_pointer_cast<AObject>((*it)->getPlayer()));
 
-				it = _networkEngine->getClients().erase(it);
+				it = _networkEngine->removeClient(it);
 				return;
 			}
 			++it;
@@ -331,7 +382,7 @@ void	Receiver::handleRequestPlayerKick(sf::IpAddress ip, unsigned short port)
 /////   Check activity of clients and send disco if not
 /////	Update player activity or add them if new client
 
-void	Receiver::updateClientActivity(sf::IpAddress ip, unsigned short port)
+void	Receiver::updateClientActivity(sf::IpAddress ip, unsigned short port, sf::Time arrival)
 {
 	ClientHandle *client;
 	client = _networkEngine->findClientHandleWithIP(ip, port);
@@ -340,13 +391,14 @@ void	Receiver::updateClientActivity(sf::IpAddress ip, unsigned short port)
 		if (_networkEngine->getClients().size() + 1 > (unsigned int)G_conf->server->max_player)
 		{
 			_networkEngine->getSender()->sendPacketEvent(PACKET_EVENT_SERVER_FULL, 0, ip, port);
+			_networkEngine->closeSession(ip, port);
 			return;
 		}
 		_networkEngine->addNewClient(ip, port);
 		return;
 	}
 	// Refresh clock of client handler
-	client->active(S_Map->getGlobalClock().getElapsedTime());
+	client->active(arrival);
 }
 
 void	Receiver::checkClientsActivity()
@@ -364,8 +416,12 @@ void	Receiver::checkClientsActivity()
 			_networkEngine->printLogWithId(2, "Client is flagged as disconnect. Id of player is ", (*it)->getPlayer()->getId(), YELLOW);
 			ADD_EVENT(ev_DELETE, std::dynamic_pointer_cast<AObject>((*it)->getPlayer()));
 
-			delete *it;
-			it = _networkEngine->getClients().erase(it);
+			// Reliable messages lost, told directly
+			ClientHandle	*client = *it;
+			if (client->isDropped())
+				_networkEngine->getSender()->sendPacketEvent(PACKET_EVENT_KICK_PLAYER, client->getPlayer()->getId(), client->getIp(), client->getPort());
+			it = _networkEngine->removeClient(it);
+			delete client;
 			
 			return;
 		}
@@ -0,0 +1,131 @@
+//
+// SendScheduler.cpp for Void Clash
+//
+
+#include	<algorithm>
+#include	"SendScheduler.hpp"
+#include	"NetworkEngine.hpp"
+#include	"ConfigParser.hpp"
+
+extern t_config *G_conf;
+
+// Fixed timesteps are rounded to the micro sec, 128 ticks of 7812 us
+// do not make exactly 1 sec
+#define	SNAPSHOT_CREDIT_EPSILON	0.01f
+
+static float	getMaxBudget()
+{
+	return std::max(G_conf->server->client_bandwidth * SCHEDULER_BURST_TIME,
+		static_cast<float>(SCHEDULER_MIN_BURST));
+}
+
+SendScheduler::SendScheduler()
+{
+	_budget = SCHEDULER_MIN_BURST;
+	_snapshotCredit = 1.f;
+}
+
+SendScheduler::~SendScheduler()
+{
+}
+
+void	SendScheduler::update(sf::Time elapsed)
+{
+	_snapshotCredit = std::min(_snapshotCredit + G_conf->server->snapshot_rate * elapsed.asSeconds(), 1.f);
+	if (isLimited())
+		_budget = std::min(_budget + G_conf->server->client_bandwidth * elapsed.asSeconds(), getMaxBudget());
+}
+
+bool	SendScheduler::isLimited() const
+{
+	return G_conf->server->client_bandwidth > 0;
+}
+
+///////////////////////////////////////////////
+/////   Packets
+
+void	SendScheduler::send(NetworkEngine *networkEngine, sf::Packet &packet,
+							const sf::IpAddress &ip, unsigned short port)
+{
+	eSendPriority	priority = getPriority(packet);
+
+	// Events must not wait, even if it overdraws the budget
+	if (priority == SEND_PRIORITY_HIGH)
+	{
+		if (networkEngine->send(packet, ip, port))
+			consume(packet.getDataSize());
+		return;
+	}
+	_queues[priority].push_back(packet);
+}
+
+void	SendScheduler::flush(NetworkEngine *networkEngine, const sf::IpAddress &ip, unsigned short port)
+{
+	unsigned int	sent = 0;
+
+	for (unsigned int priority = 0; priority < SEND_PRIORITY_COUNT; ++priority)
+	{
+		std::deque<sf::Packet>	&queue = _queues[priority];
+
+		while (!queue.empty())
+		{
+			// Even without budget, large data is spread over the ticks
+			if (sent++ == SCHEDULER_MAX_PER_TICK)
+				return;
+
+			float	size = static_cast<float>(queue.front().getDataSize());
+
+			// A packet bigger than the max budget goes once the budget is full
+			// Lower priorities wait behind it
+			if (isLimited() && size > _budget && _budget < getMaxBudget())
+				return;
+			if (networkEngine->send(queue.front(), ip, port))
+				consume(queue.front().getDataSize());
+			queue.pop_front();
+		}
+	}
+}
+
+void	SendScheduler::discard(eSendPriority priority)
+{
+	_queues[priority].clear();
+}
+
+///////////////////////////////////////////////
+/////   Snapshots
+
+bool	SendScheduler::isSnapshotDue()
+{
+	if (_snapshotCredit < 1.f - SNAPSHOT_CREDIT_EPSILON)
+		return false;
+	// Skipped, the next delta carries the changes
+	if (isLimited() && _budget <= 0)
+		return false;
+	_snapshotCredit = std::max(_snapshotCredit - 1.f, 0.f);
+	return true;
+}
+
+void	SendScheduler::consume(unsigned int bytes)
+{
+	if (isLimited())
+		_budget -= bytes;
+}
+
+///////////////////////////////////////////////
+/////   Priority from the packet type (first field)
+
+eSendPriority	SendScheduler::getPriority(const sf::Packet &packet)
+{
+	const sf::Uint8	*data = static_cast<const sf::Uint8 *>(packet.getData());
+	sf::Uint32		type;
+
+	if (packet.getDataSize() < sizeof(type))
+		return SEND_PRIORITY_HIGH;
+	// sf::Packet writes in network byte order
+	type = (static_cast<sf::Uint32>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+	if (type == PACKET_SYNCHRO || type == PACKET_WORLD_DATA)
+		return SEND_PRIORITY_LOW;
+	if (type == PACKET_WEAPON_SELECTION || type == PACKET_MAP_LIST)
+		return SEND_PRIORITY_NORMAL;
+	return SEND_PRIORITY_HIGH;
+}
@@ -22,12 +22,18 @@
 #include	"Respawn.hpp"
 #include	"Event.hpp"
 #include	"Map.hpp"
+#include	"Log.hpp"
 
 extern t_config *G_conf;
 
 Sender::Sender(NetworkEngine *networkEngine) :
 _networkEngine(networkEngine)
 {
+	_snapshotSequence = 0;
+	_nbProjectiles = 0;
+	_configHash = 0;
+	if (G_conf)
+		cacheConfig();
 }
 
 Sender::~Sender()
@@ -35,9 +41,24 @@ Sender::~Sender()
 
 void	Sender::update()
 {
+	for (std::list<ClientHandle *>::const_iterator it = _networkEngine->getClients().begin(); it != _networkEngine->getClients().end(); ++it)
+		(*it)->getScheduler().update(S_Map->getDeltaTime());
+
 	_networkEngine->pingClients();
 	sendUpdateEvents();
-	sendPacketGeneric(PACKET_UPDATE);
+	sendSnapshot();
+	flushClients();
+}
+
+// Reliable messages of the tick and those not acked in time, then
+// what is left of the budget goes to the queued packets
+void	Sender::flushClients()
+{
+	for (std::list<ClientHandle *>::const_iterator it = _networkEngine->getClients().begin(); it != _networkEngine->getClients().end(); ++it)
+	{
+		flushChannel(*it);
+		(*it)->getScheduler().flush(_networkEngine, (*it)->getIp(), (*it)->getPort());
+	}
 }
 
 ///////////////////////////////////////////////
@@ -59,6 +80,13 @@ void	Sender::sendPacket(sf::Packet &packet, ClientHandle *client)
 
 void	Sender::sendPacketGeneric(ePacketType packetType, ClientHandle *client)
 {
+	// Snapshots are made by update() only, once per tick
+	if (packetType == PACKET_UPDATE)
+	{
+		VC_ERROR("PACKET_UPDATE is not a generic packet, see Sender::update");
+		return;
+	}
+
 	_packet.clear();
 	_packet << packetType;
 	_packetType = packetType;
@@ -73,18 +101,89 @@ void	Sender::sendPacketGeneric(ePacketType packetType, ClientHandle *client)
 		_packet << S_Map->getMode()->getRoundNumber();
 		_packet << S_Map->getClock().getElapsedTime().asMilliseconds();
 	}
-	if (packetType == PACKET_UPDATE)
-	{
-		float timestamp;
-		timestamp = S_Map->getClock().getElapsedTime().asMicroseconds();
-		_packet << timestamp;
-	}
 	if (packetType == PACKET_WELCOME)
 	{
 		_packet << S_Map->getClock().getElapsedTime().asMilliseconds() << S_Map->getWarmupDuration().asMilliseconds() << S_Map->getMapDuration().asMilliseconds() << S_Map->getScore().first << S_Map->getScore().second;
 	}
 	createPacket(packetType);
 	sendPacketTo(client);
+
+	// Too big for one datagram, sent after the players
+	if (packetType == PACKET_SYNCHRO)
+		sendWorldData(client);
+}
+
+///////////////////////////////////////////////
+/////   Send the world state of this tick
+/////	Each client receives a delta against the last
+/////	snapshot he acknowledged (full state if none)
+/////	Only what is in his area of interest is sent (see ClientInterest)
+
+void	Sender::sendSnapshot()
+{
+	Snapshot	&snapshot = _snapshots.push(++_snapshotSequence);
+	captureSnapshot(snapshot);
+
+	// Added / deleted objects are the same for every client
+	_writer.clear();
+	_nbProjectiles = 0;
+	insertAddedObj(true);
+	insertDeletedObj();
+	_eventWriter = _writer;
+
+	_packetType = PACKET_UPDATE;
+	float timestamp;
+	timestamp = S_Map->getClock().getElapsedTime().asMicroseconds();
+
+	// Each client at his own rate / bandwidth
+	for (std::list<ClientHandle *>::const_iterator it = _networkEngine->getClients().begin(); it != _networkEngine->getClients().end(); ++it)
+	{
+		if ((*it)->getScheduler().isSnapshotDue())
+			sendSnapshotTo(*it, snapshot, timestamp);
+	}
+}
+
+void	Sender::sendSnapshotTo(ClientHandle *client, const Snapshot &snapshot, float timestamp)
+{
+	if (!client->isResponsive(S_Map->getGlobalClock().getElapsedTime()))
+		return;
+
+	// Base is NULL if never acked or too old, then everything is sent
+	const Snapshot	*base = _snapshots.find(client->getAckedSnapshot());
+	sf::Uint32		baseSequence = 0;
+	if (base)
+		baseSequence = base->getSequence();
+
+	ClientInterest	&interest = client->getInterest();
+	interest.update(*client->getPlayer());
+	interest.beginSnapshot(snapshot.getSequence());
+
+	// Base is sent as an offset, 0 = no base
+	// A player not sent in the base snapshot is unknown there for the client
+	sf::Uint32	previousId = 0;
+	_writer.clear();
+	_writer.writeBits(snapshot.getSequence(), 32);
+	_writer.writeVarUint(base ? snapshot.getSequence() - baseSequence : 0);
+	_writer.writeVarUint(client->getLastInput());
+	for (std::vector<s_playerState>::const_iterator it = snapshot.getPlayers().begin(); it != snapshot.getPlayers().end(); ++it)
+	{
+		if (interest.mustSendPlayer(*it, client->getPlayer()->getId()))
+			insertPlayer(*it, base && interest.wasSent(baseSequence, it->id) ? base->findPlayer(it->id) : NULL, previousId);
+	}
+	_writer.append(_eventWriter);
+	for (unsigned int i = 0; i < _nbProjectiles; ++i)
+	{
+		if (interest.isRelevant(_projectiles[i].area))
+			_writer.append(_projectiles[i].writer);
+	}
+	_writer.writeBits(WIRE_END, WIRE_TAG_BITS);
+
+	_packet.clear();
+	_packet << PACKET_UPDATE << timestamp;
+	client->getChannel().writeAck(_packet);
+	_writer.appendTo(_packet);
+	if (_networkEngine->send(_packet, client->getIp(), client->getPort()))
+		client->getScheduler().consume(_packet.getDataSize());
 }
 
 ///////////////////////////////////////////////
@@ -146,27 +245,80 @@ void	Sender::sendPing(float timestamp, ClientHandle *client)
 
 ///////////////////////////////////////////////
 /////   Send packet to clients
+/////	Through the scheduler of the client (see SendScheduler)
+/////	Events which must not be lost go through his reliable channel
 
 void	Sender::sendPacketTo(ClientHandle *client)
 {
+	eChannel	channel = getChannel(_packet);
+
 	if (client == NULL)
 	{
 		for (std::list<ClientHandle *>::const_iterator it = _networkEngine->getClients().begin(); it != _networkEngine->getClients().end(); ++it)
 		{
 			if (_packetType != PACKET_UPDATE || (*it)->isResponsive(S_Map->getGlobalClock().getElapsedTime()))
-				_networkEngine->getSocket()->send(_packet, (*it)->getIp(), (*it)->getPort());
+				sendPacketTo(*it, channel);
 		}
 	}
 	else
 	{
 		if (_packetType != PACKET_UPDATE || client->isResponsive(S_Map->getGlobalClock().getElapsedTime()))
-			_networkEngine->getSocket()->send(_packet, (client)->getIp(), (client)->getPort());
+			sendPacketTo(client, channel);
+	}
+}
+
+void	Sender::sendPacketTo(ClientHandle *client, eChannel channel)
+{
+	if (channel == CHANNEL_UNRELIABLE)
+		client->getScheduler().send(_networkEngine, _packet, client->getIp(), client->getPort());
+	else if (!client->isDropped() && !client->getChannel().send(_packet, channel))
+	{
+		// Its game state would be wrong without this message
+		_networkEngine->printLogWithId(1, "Too many reliable messages waiting for an ack, disconnecting player ",
+			client->getPlayer()->getId());
+		client->drop();
+	}
+}
+
+// Batched by flushClients, resent each tick until acked
+void	Sender::flushChannel(ClientHandle *client)
+{
+	while (client->getChannel().flush(_datagram, S_Map->getGlobalClock().getElapsedTime()))
+		client->getScheduler().send(_networkEngine, _datagram, client->getIp(), client->getPort());
+}
+
+// From the packet type (first field)
+eChannel	Sender::getChannel(const sf::Packet &packet)
+{
+	const sf::Uint8	*data = static_cast<const sf::Uint8 *>(packet.getData());
+	sf::Uint32		type;
+
+	if (packet.getDataSize() < sizeof(type))
+		return CHANNEL_UNRELIABLE;
+	// sf::Packet writes in network byte order
+	type = (static_cast<sf::Uint32>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+	switch (type)
+	{
+	case PACKET_EVENT_KILL:
+	case PACKET_EVENT_CAPTURE_FLAG:
+	case PACKET_EVENT_CHAT:
+	case PACKET_EVENT_SWITCH_MAP_MODE:
+	case PACKET_EVENT_KICK_PLAYER:
+	case PACKET_DISPLAY_STRING:
+	case PACKET_RESET_ROUND:
+	case PACKET_GAME_START:
+		return CHANNEL_RELIABLE_ORDERED;
+	case PACKET_EVENT_TURRET_DESTROYED:
+	case PACKET_EVENT_LAUNCHED:
+		return CHANNEL_RELIABLE_UNORDERED;
+	default:
+		return CHANNEL_UNRELIABLE;
 	}
 }
 
 void	Sender::sendPacketTo(sf::IpAddress ip, unsigned short port)
 {
-	_networkEngine->getSocket()->send(_packet, ip, port);
+	_networkEngine->send(_packet, ip, port);
 }
 
 
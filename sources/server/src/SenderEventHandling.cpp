@@ -23,35 +23,30 @@
 #include	"Event.hpp"
 #include	"Map.hpp"
 #include	"AssetPath.h"
+#include	"ConfigSerializer.hpp"
 
 extern t_config *G_conf;
-extern std::string G_configPath;
 
 // Config
-void	Sender::sendConfig(ClientHandle *client)
+void	Sender::cacheConfig()
 {
-	//// Reset all weapons
-	//std::list<Player *>::iterator	it = S_Map->getPlayers()->begin();
-	//std::list<Player *>::iterator	end = S_Map->getPlayers()->end();
-	//while (it != end)
-	//{
-	//	Player *player = dynamic_cast<Player *>(*it);
-	//	if (player)
-	//		player->setWeapons(NULL, NULL, NULL, NULL);
-	//	++it;
-	//}
-
-	// Send config to clients
-	ConfigParser	*parse = new ConfigParser;
+	_config.clear();
+	ConfigSerializer::write(_config, *G_conf);
+	_configHash = ConfigSerializer::hash(_config.getData(), _config.getDataSize());
+	_networkEngine->printLog(2, "Config serialized, " + std::to_string(_config.getDataSize()) + " bytes");
+}
 
-	_packet.clear();
-	//S_Map->loadConfig(G_configPath + "config.json");
-	if (!parse->loadFile(G_configPath + "config.json"))
-		return;
+void	Sender::sendConfig(ClientHandle *client, sf::Uint32 clientHash)
+{
+	// Already received from this server (reconnection)
+	bool	cached = client != NULL && clientHash == _configHash;
 
-	_networkEngine->printLogWithId(2, "Sending config packet to ", client->getPlayer()->getId());
-	std::string toSend = parse->getString();
-	_packet << PACKET_CONFIG << toSend;
+	_packet.clear();
+	_packet << PACKET_CONFIG << _configHash << !cached;
+	if (!cached)
+		_packet.append(_config.getData(), _config.getDataSize());
+	if (client)
+		_networkEngine->printLogWithId(2, cached ? "Config cached by " : "Sending config packet to ", client->getPlayer()->getId());
 	sendPacketTo(client);
 }
 
@@ -119,6 +114,7 @@ void	Sender::sendUpdateEvents()
 	if (Event::getEventByType(ev_CONFIG) != NULL)
 	{
 		sendPacketGeneric(PACKET_WELCOME);
+		cacheConfig();
 		sendConfig();
 		sendPacketEvent(PACKET_EVENT_SWITCH_MAP_MODE, S_Map->getMode()->getModeEnum());
 	}
@@ -126,8 +122,8 @@ void	Sender::sendUpdateEvents()
 	// SEND BOMB LAUNCH EVENT
 	if (Event::getEventByType(ev_BOMB_LAUNCHED) != NULL)
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(ev_BOMB_LAUNCHED)->begin();
-		std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(ev_BOMB_LAUNCHED)->end();
+		t_eventList::const_iterator it = Event::getEventByType(ev_BOMB_LAUNCHED)->begin();
+		t_eventList::const_iterator end = Event::getEventByType(ev_BOMB_LAUNCHED)->end();
 
 		while (it != end)
 		{
@@ -165,8 +161,8 @@ void	Sender::sendUpdateEvents()
 	// SEND KILL EVENT - Trigger = hitter, data = killed
 	if (Event::getEventByType(ev_KILL) != NULL)
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(ev_KILL)->begin();
-		std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(ev_KILL)->end();
+		t_eventList::const_iterator it = Event::getEventByType(ev_KILL)->begin();
+		t_eventList::const_iterator end = Event::getEventByType(ev_KILL)->end();
 
 		while (it != end)
 		{
@@ -224,8 +220,8 @@ void	Sender::sendUpdateEvents()
 	// SEND HIT EVENT - Trigger = Object who killed (bullet...), data = killed
 	if (Event::getEventByType(ev_PLAYER_HIT) != NULL)
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(ev_PLAYER_HIT)->begin();
-		std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(ev_PLAYER_HIT)->end();
+		t_eventList::const_iterator it = Event::getEventByType(ev_PLAYER_HIT)->begin();
+		t_eventList::const_iterator end = Event::getEventByType(ev_PLAYER_HIT)->end();
 
 		while (it != end)
 		{
@@ -243,8 +239,8 @@ void	Sender::sendUpdateEvents()
 
 	if (Event::getEventByType(ev_CAPTURE_FLAG) != NULL)
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(ev_CAPTURE_FLAG)->begin();
-		std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(ev_CAPTURE_FLAG)->end();
+		t_eventList::const_iterator it = Event::getEventByType(ev_CAPTURE_FLAG)->begin();
+		t_eventList::const_iterator end = Event::getEventByType(ev_CAPTURE_FLAG)->end();
 		while (it != end)
 		{
 			Flag *flag = (Flag *)(*it).second.trigger.get();
@@ -259,8 +255,8 @@ void	Sender::sendUpdateEvents()
 
 	if (Event::getEventByType(ev_TURRET_DESTROYED) != NULL)
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(ev_TURRET_DESTROYED)->begin();
-		std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(ev_TURRET_DESTROYED)->end();
+		t_eventList::const_iterator it = Event::getEventByType(ev_TURRET_DESTROYED)->begin();
+		t_eventList::const_iterator end = Event::getEventByType(ev_TURRET_DESTROYED)->end();
 		while (it != end)
 		{
 			AObject *turret = (AObject *)(*it).second.trigger.get();
@@ -30,112 +30,153 @@
 
 ///////////////////////////////////////////////
 /////   Overload of operator <<
-/////	to create packet with classes info
+/////	to write classes info on the wire (schemas in BitStream.hpp)
 
-sf::Packet& operator <<(sf::Packet& packet, const Player &m)
+// X / Y / DIR (speed + angle)
+static BitWriter& writeMovement(BitWriter& writer, const AObject &m)
 {
-	return packet << m.getEnergy() << m.getLife() << m.getKills() << m.getDeaths() << m.getLatency() << m.getScore() << m.isInvulnerable();
+	writer.writeQuantized(m.getX(), WIRE_POSITION);
+	writer.writeQuantized(m.getY(), WIRE_POSITION);
+	writer.writeDirection(m.getDirX(), m.getDirY());
+	return writer;
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const Bullet &m)
+// WIDTH / HEIGHT
+static BitWriter& writeArea(BitWriter& writer, const AObject &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY();
-	// X / Y / DIRX / DIRY
+	writer.writeQuantized(static_cast<float>(m.getWidth()), WIRE_SIZE);
+	writer.writeQuantized(static_cast<float>(m.getHeight()), WIRE_SIZE);
+	return writer;
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const GravityField &m)
+BitWriter& operator <<(BitWriter& writer, const Bullet &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY();
-	// X / Y / DIRX / DIRY
+	return writeMovement(writer, m);
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const Bomb &m)
+BitWriter& operator <<(BitWriter& writer, const GravityField &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY() << m.isLaunched();
-	// X / Y / DIRX / DIRY / LAUNCHED
+	return writeMovement(writer, m);
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const Rocket &m)
+BitWriter& operator <<(BitWriter& writer, const Bomb &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY() << m.getImpact().first << m.getImpact().second;
-	// X / Y / DIRX / DIRY / LAUNCHED
+	writeMovement(writer, m).writeBool(m.isLaunched());
+	return writer;
+	// MOVEMENT / LAUNCHED
 }
 
+BitWriter& operator <<(BitWriter& writer, const Rocket &m)
+{
+	writeMovement(writer, m);
+	writer.writeQuantized(m.getImpact().first, WIRE_POSITION);
+	writer.writeQuantized(m.getImpact().second, WIRE_POSITION);
+	return writer;
+	// MOVEMENT / IMPACT X / IMPACT Y
+}
 
-sf::Packet& operator <<(sf::Packet& packet, const Turret &m)
+BitWriter& operator <<(BitWriter& writer, const Turret &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY();
-	// X / Y / DIRX / DIRY
+	return writeMovement(writer, m);
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const Bot &m)
+BitWriter& operator <<(BitWriter& writer, const Bot &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY();
-	// X / Y / DIRX / DIRY
+	return writeMovement(writer, m);
 }
 
+BitWriter& operator <<(BitWriter& writer, const Explosion &m)
+{
+	return writeMovement(writer, m);
+}
 
-sf::Packet& operator <<(sf::Packet& packet, const Explosion &m)
+BitWriter& operator <<(BitWriter& writer, const SpeedField &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY();
-	// X / Y / DIRX / DIRY
+	return writeArea(writeMovement(writer, m), m);
+	// MOVEMENT / WIDTH / HEIGTH
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const SpeedField &m)
+BitWriter& operator <<(BitWriter& writer, const Capture &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY() << m.getWidth() << m.getHeight();
-	// X / Y / DIRX / DIRY / WIDTH / HEIGTH
+	writeArea(writeMovement(writer, m), m).writeFloat(m.getControledStatus());
+	return writer;
+	// MOVEMENT / WIDTH / HEIGTH / times
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const Capture &m)
+BitWriter& operator <<(BitWriter& writer, const Respawn &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY() << m.getWidth() << m.getHeight() << m.getControledStatus();
-	// X / Y / DIRX / DIRY / WIDTH / HEIGTH / times
+	writeArea(writeMovement(writer, m), m).writeBits(m.getTeam(), WIRE_TEAM_BITS);
+	return writer;
+	// MOVEMENT / WIDTH / HEIGTH / TEAM
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const Respawn &m)
+BitWriter& operator <<(BitWriter& writer, const Flag &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY() << m.getWidth() << m.getHeight() << m.getTeam();
-	// X / Y / DIRX / DIRY / WIDTH / HEIGTH / TEAM
+	writeMovement(writer, m).writeBits(m.getTeam(), WIRE_TEAM_BITS);
+	writer.writeQuantized(m.getInitX(), WIRE_POSITION);
+	writer.writeQuantized(m.getInitY(), WIRE_POSITION);
+	return writer;
+	// MOVEMENT / TEAM / INIT X / INIT Y
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const Flag &m)
+BitWriter& operator <<(BitWriter& writer, const Wall &m)
 {
-	return packet << m.getX() << m.getY() << m.getDirX() << m.getDirY() << m.getTeam() << m.getInitX() << m.getInitY();
-	// X / Y / DIRX / DIRY / WIDTH / HEIGTH / TEAM
+	// Angle / dir / len are used by the collisions as is, not quantized
+	writer.writeQuantized(m.getX(), WIRE_POSITION);
+	writer.writeQuantized(m.getY(), WIRE_POSITION);
+	writer.writeQuantized(m.getEndX(), WIRE_POSITION);
+	writer.writeQuantized(m.getEndY(), WIRE_POSITION);
+	writer.writeFloat(m.getAngle());
+	writer.writeFloat(m.getDirX());
+	writer.writeFloat(m.getDirY());
+	writer.writeVarUint(m.getLen());
+	return writer;
+	// X / Y / ENDX / ENDY / ANGLE / DIRX / DIRY / LEN
 }
 
-sf::Packet& operator <<(sf::Packet& packet, const Wall &m)
+///////////////////////////////////////////////
+/////   Snapshot of every player for this tick
+
+void	Sender::captureSnapshot(Snapshot &snapshot)
 {
-	return packet << m.getX() << m.getY() << m.getEndX() << m.getEndY() << m.getAngle() << m.getDirX() << m.getDirY() << m.getLen();
-	// ID / X / Y / ENDX / ENDY / ANGLE / DIRX / DIRY / LEN
+	s_playerState	state;
+
+	for (EntityStore<Player>::const_iterator it = S_Map->getPlayers()->begin(); it != S_Map->getPlayers()->end(); it++)
+	{
+		capturePlayerState(state, *(*it));
+		snapshot.addPlayer(state);
+	}
 }
 
 ///////////////////////////////////////////////
-/////   Create a packet and send it to ALL clients
-/////	to update their existing classes
-/////	or create new class
+/////   Create a packet with the full world state
+/////	(welcome / synchro)
 
 void	Sender::createPacket(ePacketType packetType)
 {
-	// Insert player's info
-	for (std::list<std::shared_ptr<Player>>::const_iterator it = S_Map->getPlayers()->begin(); it != S_Map->getPlayers()->end(); it++)
-	{
-		Player	*player = dynamic_cast<Player *>((*it).get());
-		int shieldIndex = -1;
-		if (player->getShield())
-			shieldIndex = player->getShield()->getWeaponIndex();
+	s_playerState	state;
+	sf::Uint32		previousId = 0;
+
+	_writer.clear();
 
-		_packet << PACKET_EVENT_ADD << player->getId() << player->getType() << player->getTeam() << player->getX() << player->getY() << player->getDirX() << player->getDirY() << player->getAim().first << player->getAim().second << shieldIndex << *player;
+	// Insert player's info - no base, every field is sent
+	for (EntityStore<Player>::const_iterator it = S_Map->getPlayers()->begin(); it != S_Map->getPlayers()->end(); it++)
+	{
+		capturePlayerState(state, *(*it));
+		insertPlayer(state, NULL, previousId);
 		if (packetType == PACKET_SYNCHRO)
-			_packet << player->getNick();
+			_writer.writeString((*it)->getNick());
 	}
 	insertAddedObj();
 	insertDeletedObj();
 
 	// All world data (walls / speedfields...)
-	if (packetType == PACKET_WELCOME || packetType == PACKET_SYNCHRO)
-		insertWorldData();
+	// Split in its own packets for the synchro (see sendWorldData)
+	if (packetType == PACKET_WELCOME)
+		insertWorldData(false, NULL);
+
+	_writer.writeBits(WIRE_END, WIRE_TAG_BITS);
+	_writer.appendTo(_packet);
 
 	// // DEBUG - Send it to all clients
 	// int	clientNb = _networkEngine->getNbClient();
@@ -153,46 +194,66 @@ void	Sender::insertDeletedObj()
 {
 	if (Event::getEventByType(ev_DELETE) == NULL)
 		return;
-	std::list<std::pair<eventType, s_event> >::iterator it =
+	t_eventList::iterator it =
 		Event::getEventByType(ev_DELETE)->begin();
 
 	while (it != Event::getEventByType(ev_DELETE)->end())
 	{
 		//if ((*it).second.trigger && ((*it).second.trigger->getType() == PLAYER || (*it).second.trigger->getType() == TURRET))
 		if ((*it).second.trigger && ((*it).second.trigger->getType() == PLAYER))
-			_packet << PACKET_EVENT_DELETE << (*it).second.trigger->getId();
+		{
+			_writer.writeBits(WIRE_DELETE, WIRE_TAG_BITS);
+			_writer.writeVarUint((*it).second.trigger->getId());
+		}
 		++it;
 	}
 }
 
 // Called each tick
-void	Sender::insertAddedObj()
+// Projectiles are short lived and numerous, if filtered they are written
+// in their own record, sent only to the clients they are relevant to
+void	Sender::insertAddedObj(bool filtered)
 {
 	if (Event::getEventByType(ev_START) == NULL)
 		return;
-	std::list<std::pair<eventType, s_event> >::iterator it =
+	t_eventList::iterator it =
 		Event::getEventByType(ev_START)->begin();
 
 	while (it != Event::getEventByType(ev_START)->end())
 	{
-		if ((*it).second.trigger->getType() == BULLET)
-			insertWeapons<Bullet>((*it).second.trigger.get());
-		else if ((*it).second.trigger->getType() == BOMB)
-			insertWeapons<Bomb>((*it).second.trigger.get());
-		else if ((*it).second.trigger->getType() == ROCKET)
-			insertWeapons<Rocket>((*it).second.trigger.get());
-		else if ((*it).second.trigger->getType() == TURRET)
-			insertWeapons<Turret>((*it).second.trigger.get());
-		else if ((*it).second.trigger->getType() == GRAVITY_FIELD)
-			insertWeapons<GravityField>((*it).second.trigger.get());
-		else if ((*it).second.trigger->getType() == BOT)
-			insertObject<Bot>((*it).second.trigger.get());
+		AObject	*obj = (*it).second.trigger.get();
+
+		if (filtered && (obj->getType() == BULLET || obj->getType() == ROCKET))
+		{
+			if (_nbProjectiles == _projectiles.size())
+				_projectiles.resize(_nbProjectiles + 1);
+			s_projectileRecord	&record = _projectiles[_nbProjectiles++];
+			record.writer.clear();
+			ClientInterest::getSweptArea(*obj, record.area);
+			if (obj->getType() == BULLET)
+				insertWeapons<Bullet>(obj, record.writer);
+			else
+				insertWeapons<Rocket>(obj, record.writer);
+		}
+		else if (obj->getType() == BULLET)
+			insertWeapons<Bullet>(obj, _writer);
+		else if (obj->getType() == BOMB)
+			insertWeapons<Bomb>(obj, _writer);
+		else if (obj->getType() == ROCKET)
+			insertWeapons<Rocket>(obj, _writer);
+		else if (obj->getType() == TURRET)
+			insertWeapons<Turret>(obj, _writer);
+		else if (obj->getType() == GRAVITY_FIELD)
+			insertWeapons<GravityField>(obj, _writer);
+		else if (obj->getType() == BOT)
+			insertObject<Bot>(obj, _writer);
 		++it;
 	}
 }
 
 // Call on welcome / synch
-void	Sender::insertWorldData()
+// If split, records are sent in PACKET_WORLD_DATA chunks to the client
+void	Sender::insertWorldData(bool split, ClientHandle *client)
 {
 	// ELEMS OBJ
 	{
@@ -202,30 +263,32 @@ void	Sender::insertWorldData()
 		{
 			if (!S_Map->checkIfDeleteEventForObj(*it))
 			{
+				_record.clear();
 				if ((*it)->getType() == SPEED_FIELD)
-					insertObject<SpeedField>((*it).get());
+					insertObject<SpeedField>((*it).get(), _record);
 				if ((*it)->getType() == CAPTURE)
-					insertObject<Capture>((*it).get());
+					insertObject<Capture>((*it).get(), _record);
 				else if ((*it)->getType() == RESPAWN)
-					insertObject<Respawn>((*it).get());
+					insertObject<Respawn>((*it).get(), _record);
 				else if ((*it)->getType() == FLAG)
 				{
-					insertObject<Flag>((*it).get());
+					insertObject<Flag>((*it).get(), _record);
 					Flag *f = dynamic_cast<Flag *>((*it).get());
 					if (f)
 					{
 						if (f->getOwner())
-							_packet << f->getOwner()->getId();
+							_record.writeVarUint(f->getOwner()->getId());
 						else
-							_packet << 0;
+							_record.writeVarUint(0);
 					}
 				}
 				else if ((*it)->getType() == BOT)
-					insertObject<Bot>((*it).get());
+					insertObject<Bot>((*it).get(), _record);
 				//else if ((*it)->getType() == TURRET)
 				//	insertWeapons<Turret>((*it));
 				//else if ((*it)->getType() == GRAVITY_FIELD)
 				//	insertWeapons<GravityField>((*it));
+				addWorldRecord(split, client);
 			}
 			++it;
 		}
@@ -236,24 +299,63 @@ void	Sender::insertWorldData()
 	auto	end = S_Map->getWalls()->end();
 	while (it != end)
 	{
-		insertObject<Wall>((*it).get());
+		_record.clear();
+		insertObject<Wall>((*it).get(), _record);
+		addWorldRecord(split, client);
 		++it;
 	}
 }
 
+void	Sender::addWorldRecord(bool split, ClientHandle *client)
+{
+	// Keep room for WIRE_END
+	if (split && _writer.getBitSize() + _record.getBitSize() + WIRE_TAG_BITS > WORLD_DATA_CHUNK_SIZE * 8)
+		flushWorldData(client);
+	_writer.append(_record);
+}
+
+///////////////////////////////////////////////
+/////   World data of the synchro, in datagrams under the MTU
+/////	Each chunk is complete, the client applies them in any order
+
+void	Sender::sendWorldData(ClientHandle *client)
+{
+	_writer.clear();
+	insertWorldData(true, client);
+	flushWorldData(client);
+}
+
+void	Sender::flushWorldData(ClientHandle *client)
+{
+	if (_writer.getBitSize() == 0)
+		return;
+	_writer.writeBits(WIRE_END, WIRE_TAG_BITS);
+	_packetType = PACKET_WORLD_DATA;
+	_packet.clear();
+	_packet << PACKET_WORLD_DATA;
+	_writer.appendTo(_packet);
+	sendPacketTo(client);
+	_writer.clear();
+}
+
 // World object
 template<typename T>
-void	Sender::insertObject(AObject *obj)
+void	Sender::insertObject(AObject *obj, BitWriter &writer)
 {
 	T	*templatedObj;
 	templatedObj = dynamic_cast<T *>(obj);
 	if (templatedObj)
-		_packet << PACKET_EVENT_ADD << obj->getId() << obj->getType() << *templatedObj;
+	{
+		writer.writeBits(WIRE_ADD, WIRE_TAG_BITS);
+		writer.writeVarUint(obj->getId());
+		writer.writeBits(obj->getType(), WIRE_TYPE_BITS);
+		writer << *templatedObj;
+	}
 }
 
 // Weapons (bullet / bomb...)
 template<typename T>
-void	Sender::insertWeapons(AObject *obj)
+void	Sender::insertWeapons(AObject *obj, BitWriter &writer)
 {
 	T	*templatedObj;
 	templatedObj = dynamic_cast<T *>(obj);
@@ -263,6 +365,20 @@ void	Sender::insertWeapons(AObject *obj)
 		unsigned int ownerId = 0;
 		if (templatedObj && templatedObj->getOwner())
 			ownerId = templatedObj->getOwner()->getId();
-		_packet << PACKET_EVENT_ADD << obj->getId() << obj->getType() << ownerId << *templatedObj << templatedObj->getWeaponIndex();
+		writer.writeBits(WIRE_ADD, WIRE_TAG_BITS);
+		writer.writeVarUint(obj->getId());
+		writer.writeBits(obj->getType(), WIRE_TYPE_BITS);
+		writer.writeVarUint(ownerId);
+		writer << *templatedObj;
+		writer.writeVarInt(templatedObj->getWeaponIndex());
 	}
 }
+
+// Player, ids are sent as a delta with the previous player
+void	Sender::insertPlayer(const s_playerState &state, const s_playerState *base, sf::Uint32 &previousId)
+{
+	_writer.writeBits(WIRE_PLAYER, WIRE_TAG_BITS);
+	_writer.writeVarInt(static_cast<sf::Int32>(state.id - previousId));
+	writePlayerDelta(_writer, state, base);
+	previousId = state.id;
+}
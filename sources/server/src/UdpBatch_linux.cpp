@@ -0,0 +1,96 @@
+#if defined(linux) || defined(__linux)
+
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE
+#endif
+#include	<sys/types.h>
+#include	<sys/socket.h>
+#include	<netinet/in.h>
+#include	<arpa/inet.h>
+#include	<cstring>
+#include	<cerrno>
+#include	"UdpBatch.hpp"
+
+///////////////////////////////////////////////
+/////   recvmmsg / sendmmsg backend
+
+struct	s_udpBatchBuffers
+{
+	struct mmsghdr		headers[UDP_BATCH_SIZE];
+	struct iovec		iovecs[UDP_BATCH_SIZE];
+	struct sockaddr_in	addresses[UDP_BATCH_SIZE];
+	std::vector<char>	data;	// UDP_BATCH_SIZE * MaxDatagramSize, receive only
+};
+
+UdpBatch::UdpBatch(BatchUdpSocket &socket) :
+_socket(socket)
+{
+	_buffers = new s_udpBatchBuffers();
+	_buffers->data.resize(UDP_BATCH_SIZE * sf::UdpSocket::MaxDatagramSize);
+}
+
+UdpBatch::~UdpBatch()
+{
+	delete _buffers;
+}
+
+unsigned int	UdpBatch::receive(s_datagram **datagrams, unsigned int count)
+{
+	std::memset(_buffers->headers, 0, sizeof(_buffers->headers[0]) * count);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		_buffers->iovecs[i].iov_base = &_buffers->data[i * sf::UdpSocket::MaxDatagramSize];
+		_buffers->iovecs[i].iov_len = sf::UdpSocket::MaxDatagramSize;
+		_buffers->headers[i].msg_hdr.msg_iov = &_buffers->iovecs[i];
+		_buffers->headers[i].msg_hdr.msg_iovlen = 1;
+		_buffers->headers[i].msg_hdr.msg_name = &_buffers->addresses[i];
+		_buffers->headers[i].msg_hdr.msg_namelen = sizeof(_buffers->addresses[i]);
+	}
+
+	int		received = recvmmsg(_socket.getHandle(), _buffers->headers, count, MSG_DONTWAIT, NULL);
+	if (received <= 0)
+		return 0;
+
+	for (int i = 0; i < received; ++i)
+	{
+		const char	*data = static_cast<const char *>(_buffers->iovecs[i].iov_base);
+		datagrams[i]->ip = sf::IpAddress(ntohl(_buffers->addresses[i].sin_addr.s_addr));
+		datagrams[i]->port = ntohs(_buffers->addresses[i].sin_port);
+		datagrams[i]->data.assign(data, data + _buffers->headers[i].msg_len);
+	}
+	return received;
+}
+
+unsigned int	UdpBatch::send(s_datagram **datagrams, unsigned int count)
+{
+	std::memset(_buffers->headers, 0, sizeof(_buffers->headers[0]) * count);
+	std::memset(_buffers->addresses, 0, sizeof(_buffers->addresses[0]) * count);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		_buffers->addresses[i].sin_family = AF_INET;
+		_buffers->addresses[i].sin_addr.s_addr = htonl(datagrams[i]->ip.toInteger());
+		_buffers->addresses[i].sin_port = htons(datagrams[i]->port);
+		_buffers->iovecs[i].iov_base = datagrams[i]->data.data();
+		_buffers->iovecs[i].iov_len = datagrams[i]->data.size();
+		_buffers->headers[i].msg_hdr.msg_iov = &_buffers->iovecs[i];
+		_buffers->headers[i].msg_hdr.msg_iovlen = 1;
+		_buffers->headers[i].msg_hdr.msg_name = &_buffers->addresses[i];
+		_buffers->headers[i].msg_hdr.msg_namelen = sizeof(_buffers->addresses[i]);
+	}
+
+	// sendmmsg may stop early, retry from the first datagram not sent
+	// A real error (socket buffer full...) drops the rest, like sf::UdpSocket::send would
+	unsigned int	sent = 0;
+	while (sent < count)
+	{
+		int		result = sendmmsg(_socket.getHandle(), _buffers->headers + sent, count - sent, MSG_DONTWAIT);
+		if (result < 0 && errno == EINTR)
+			continue;
+		if (result <= 0)
+			break;
+		sent += result;
+	}
+	return sent;
+}
+
+#endif
@@ -0,0 +1,48 @@
+#if !defined(linux) && !defined(__linux)
+
+#include	"UdpBatch.hpp"
+
+///////////////////////////////////////////////
+/////   Fallback, one SFML call per datagram
+
+struct	s_udpBatchBuffers
+{
+	char	data[sf::UdpSocket::MaxDatagramSize];
+};
+
+UdpBatch::UdpBatch(BatchUdpSocket &socket) :
+_socket(socket)
+{
+	_buffers = new s_udpBatchBuffers();
+}
+
+UdpBatch::~UdpBatch()
+{
+	delete _buffers;
+}
+
+unsigned int	UdpBatch::receive(s_datagram **datagrams, unsigned int count)
+{
+	std::size_t		size;
+	unsigned int	received = 0;
+
+	while (received < count &&
+		_socket.receive(_buffers->data, sizeof(_buffers->data), size, datagrams[received]->ip, datagrams[received]->port) == sf::Socket::Done)
+	{
+		datagrams[received]->data.assign(_buffers->data, _buffers->data + size);
+		++received;
+	}
+	return received;
+}
+
+unsigned int	UdpBatch::send(s_datagram **datagrams, unsigned int count)
+{
+	unsigned int	sent = 0;
+
+	for (unsigned int i = 0; i < count; ++i)
+		if (_socket.send(datagrams[i]->data.data(), datagrams[i]->data.size(), datagrams[i]->ip, datagrams[i]->port) == sf::Socket::Done)
+			++sent;
+	return sent;
+}
+
+#endif
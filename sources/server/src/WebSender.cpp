@@ -1,148 +1,271 @@
 #include	<sstream>
+#include	<cstdlib>
+#include	<algorithm>
+#include	<chrono>
 #include	"WebSender.hpp"
-#include	"NetworkEngine.hpp"
-#include	"Map.hpp"
+#include	"Match.hpp"
+#include	"NetworkIo.hpp"
 #include	"ConfigParser.hpp"
 #include	"Log.hpp"
 
 extern t_config	*G_conf;
-WebSender::WebSender(NetworkEngine *networkEngine) :
-	_networkEngine(networkEngine),
-	_thread(&WebSender::sendUpdate, this)
+
+WebSender::WebSender(NetworkIo *networkIo, const std::vector<Match *> &matches) :
+	_networkIo(networkIo),
+	_matches(matches),
+	_port(80),
+	_address(sf::IpAddress::None),
+	_answered(false),
+	_id(-1),
+	_thread(&WebSender::sendLoop, this),
+	_running(false)
 {
-	_http = new sf::Http;
-	_http->setHost(CENTRAL_SERVER_URL);
-	_thread.launch();
-	_serverName = G_conf->server->name.c_str();
+	_serverName = G_conf->server->name;
 	_maxPlayer = G_conf->server->max_player;
-	_status = WEBSENDER_NOT_INIT;
 }
 
 WebSender::~WebSender()
 {
-	_thread.terminate();
-	delete _http;
+	stop();
 }
 
-// Post request
-bool	WebSender::sendCreate()
+//////////////////////////////////////////////////////////////////////
+/////	Start / stop, never wait for the central server
+//////////////////////////////////////////////////////////////////////
+
+void	WebSender::start(const std::string &url)
 {
-	//http://voidclash.azurewebsites.net/Help
-	//Id = 3 & Name = zaza&CurrentMode = CaptureTheFlag&PlayerNumber = 12 & CurrentMap = De_dust2
-
-	// prparation de la requte
-	sf::Http::Request request(CENTRAL_SERVER_API, sf::Http::Request::Post);
-
-	// encodage des paramtres dans le corps de la requte
-	std::ostringstream stream;
-	stream
-		<< "&Name=" << _serverName
-		<< "&CurrentMap=" << S_Map->getMapDatabase()->getCurrentMapName().c_str()
-		<< "&PlayerNumber=" << S_Map->getPlayers()->size()
-		<< "&MaxPlayer=" << _maxPlayer
-		<< "&Port=" << _networkEngine->getSocket()->getLocalPort()
-		<< "&CurrentMode=" << S_Map->getMode()->getModeName().c_str();
-	request.setBody(stream.str());
-
-	// envoi de la requte au serveur
-	sf::Http::Response response = _http->sendRequest(request, sf::seconds(2));
-
-	// vrification du statut
-	if (response.getStatus() == sf::Http::Response::Ok || response.getStatus() == sf::Http::Response::Created)
+	std::string	address = url;
+
+	if (address.compare(0, 7, "http://") == 0)
+		address = address.substr(7);
+	else if (address.find("://") != std::string::npos)
 	{
-		VC_INFO_CRITICAL("Server CREATION has been successfully sent to central server");
-
-		// Get ID
-		std::string str = response.getBody();
-		std::size_t pos = str.find("Id\":") + 4;
-		std::size_t end = str.find(",");
-		std::size_t len = end - pos;
-		std::string tmp = str.substr(pos, len);
-		_id = atoi(tmp.c_str());
-		_status = WEBSENDER_OK;
-		return true;
+		VC_WARNING_CRITICAL("Central server " + url + " not supported (http only), the server is not listed");
+		return;
 	}
-	else
+
+	// host[:port][/path]
+	std::size_t	slash = address.find('/');
+	_path = slash == std::string::npos ? "" : address.substr(slash);
+	if (!_path.empty() && _path[_path.size() - 1] == '/')
+		_path.erase(_path.size() - 1);
+	_path += "/" CENTRAL_SERVER_API;
+	address = address.substr(0, slash);
+
+	std::size_t	colon = address.find(':');
+	_host = address.substr(0, colon);
+	if (colon != std::string::npos)
+		_port = static_cast<unsigned short>(atoi(address.substr(colon + 1).c_str()));
+
+	if (_host.empty() || _port == 0)
 	{
-		VC_WARNING_CRITICAL("Unable to send server CREATION to central server");
-		_status = WEBSENDER_FAILED;
+		VC_INFO_CRITICAL("No central server, the server is not listed");
+		return;
 	}
-	return false;
+	_running = true;
+	_thread.launch();
+	VC_INFO_CRITICAL("Central server: " + _host + ":" + std::to_string(_port) + _path);
 }
 
-// Put request
-void	WebSender::sendUpdate()
+void	WebSender::stop()
 {
-	sf::sleep(sf::seconds(UPDATE_DELAY));
-	//http://voidclash.azurewebsites.net/Help
-	//Id = 3 & Name = zaza&CurrentMode = CaptureTheFlag&PlayerNumber = 12 & CurrentMap = De_dust2
+	{
+		std::lock_guard<std::mutex>	lock(_mutex);
+
+		if (!_running)
+			return;
+		_running = false;
+	}
+	_wakeUp.notify_all();
+	_thread.wait();
+}
 
-	// prparation de la requte
-	while (42)
+//////////////////////////////////////////////////////////////////////
+/////	Worker thread
+/////	Register, then update every UPDATE_DELAY. After a failure the
+/////	delay starts at RETRY_DELAY and is doubled up to RETRY_MAX_DELAY
+//////////////////////////////////////////////////////////////////////
+
+void	WebSender::sendLoop()
+{
+	sf::Time	retry = sf::seconds(RETRY_DELAY);
+	sf::Time	delay = sf::Time::Zero;
+
+	while (waitFor(delay))
 	{
-		if (_status == WEBSENDER_OK)
+		if (_id < 0 ? sendCreate() : sendUpdate())
 		{
-			sf::Http::Request request(CENTRAL_SERVER_API, sf::Http::Request::Put);
-			request.setField("Content-Type", "application/x-www-form-urlencoded");
-
-			// encodage des paramtres dans le corps de la requte
-			std::ostringstream stream;
-			stream << "Id=" << _id
-				<< "&Name=" << _serverName
-				<< "&CurrentMap=" << S_Map->getMapDatabase()->getCurrentMapName().c_str()
-				<< "&PlayerNumber=" << S_Map->getPlayers()->size()
-				<< "&MaxPlayer=" << _maxPlayer
-				<< "&Port=" << _networkEngine->getSocket()->getLocalPort()
-				<< "&CurrentMode=" << S_Map->getMode()->getModeName().c_str();
-			request.setBody(stream.str());
-
-			// envoi de la requte au serveur
-			sf::Http::Response response = _http->sendRequest(request, sf::seconds(2));
-
-			// vrification du statut
-			sf::Http::Response::Status status = response.getStatus();
-			if (status == sf::Http::Response::Ok || status == sf::Http::Response::Created || status == sf::Http::Response::Accepted)
-			{
-				VC_INFO_CRITICAL("Server UPDATE has been successfully sent to central server");
-			}
-			else
-			{
-				VC_WARNING_CRITICAL("Unable to send server UPDATE to central server");
-				sendCreate();
-			}
+			retry = sf::seconds(RETRY_DELAY);
+			delay = sf::seconds(UPDATE_DELAY);
 		}
 		else
-			sendCreate();
-		sf::sleep(sf::seconds(UPDATE_DELAY));
+		{
+			delay = retry;
+			retry = std::min(retry + retry, sf::seconds(RETRY_MAX_DELAY));
+			VC_WARNING("Central server: next try in " + std::to_string(delay.asMilliseconds() / 1000) + " sec");
+		}
 	}
+	sendClose();
 }
 
-// Delete request
-bool	WebSender::sendClose()
+bool	WebSender::waitFor(sf::Time delay)
 {
-	//http://voidclash.azurewebsites.net/Help
-	//Id = 3 & Name = zaza&CurrentMode = CaptureTheFlag&PlayerNumber = 12 & CurrentMap = De_dust2
+	std::unique_lock<std::mutex>	lock(_mutex);
+
+	_wakeUp.wait_for(lock, std::chrono::microseconds(delay.asMicroseconds()), [this]() { return !_running; });
+	return _running;
+}
 
-	// prparation de la requte
-	sf::Http::Request request(CENTRAL_SERVER_API, sf::Http::Request::Delete);
+bool	WebSender::isRunning()
+{
+	std::lock_guard<std::mutex>	lock(_mutex);
 
-	// encodage des paramtres dans le corps de la requte
-	std::ostringstream stream;
-	stream << "Id=" << _id;
-	request.setBody(stream.str());
+	return _running;
+}
 
-	// envoi de la requte au serveur
-	sf::Http::Response response = _http->sendRequest(request, sf::seconds(2));
+// Post request
+bool	WebSender::sendCreate()
+{
+	int			status;
+	std::string	answer;
 
-	// vrification du statut
-	if (response.getStatus() == sf::Http::Response::Ok || response.getStatus() == sf::Http::Response::Created)
+	if (!request("POST", getStatus(), sf::milliseconds(REQUEST_TIMEOUT), status, answer)
+		|| (status != 200 && status != 201))
 	{
-		VC_INFO_CRITICAL("Server CLOSE has been successfully sent to central server");
-		return true;
+		VC_WARNING_CRITICAL("Unable to send server CREATION to central server");
+		return false;
+	}
+
+	// Get ID
+	std::size_t	pos = answer.find("Id\":");
+	if (pos == std::string::npos)
+	{
+		VC_WARNING_CRITICAL("No server ID in the central server answer");
+		return false;
+	}
+	_id = atoi(answer.c_str() + pos + 4);
+	VC_INFO_CRITICAL("Server CREATION has been successfully sent to central server");
+	return true;
+}
+
+// Put request
+bool	WebSender::sendUpdate()
+{
+	int			status;
+	std::string	answer;
+
+	if (!request("PUT", "Id=" + std::to_string(_id) + getStatus(), sf::milliseconds(REQUEST_TIMEOUT), status, answer))
+	{
+		VC_WARNING_CRITICAL("Unable to send server UPDATE to central server");
+		return false;
 	}
+	if (status != 200 && status != 201 && status != 202 && status != 204)
+	{
+		// Unknown for the central server (restarted...), registered again
+		VC_WARNING_CRITICAL("Server UPDATE refused by central server (" + std::to_string(status) + ")");
+		_id = -1;
+		return false;
+	}
+	VC_INFO("Server UPDATE has been successfully sent to central server");
+	return true;
+}
+
+// Delete request
+void	WebSender::sendClose()
+{
+	int			status;
+	std::string	answer;
+
+	// Not sent if the central server did not answer the last request
+	if (_id < 0 || !_answered)
+		return;
+	if (request("DELETE", "Id=" + std::to_string(_id), sf::milliseconds(CLOSE_TIMEOUT), status, answer)
+		&& (status == 200 || status == 202 || status == 204))
+		VC_INFO_CRITICAL("Server CLOSE has been successfully sent to central server");
 	else
 		VC_WARNING_CRITICAL("Unable to send server CLOSE to central server");
-	
-	return false;
 }
 
+//////////////////////////////////////////////////////////////////////
+/////	HTTP/1.0 request, the answer is read until the central server
+/////	closes. Unlike sf::Http the whole request has a timeout, and a
+/////	request still waiting for its answer is dropped when stopped
+//////////////////////////////////////////////////////////////////////
+
+bool	WebSender::request(const std::string &method, const std::string &body, sf::Time timeout, int &status, std::string &answer)
+{
+	sf::Clock		clock;
+	sf::TcpSocket	socket;
+
+	_answered = false;
+	if (_address == sf::IpAddress::None)
+		_address = sf::IpAddress(_host);
+	if (_address == sf::IpAddress::None
+		|| socket.connect(_address, _port, timeout) != sf::Socket::Done)
+		return false;
+
+	std::ostringstream	stream;
+	stream << method << " " << _path << " HTTP/1.0\r\n"
+		<< "Host: " << _host << "\r\n"
+		<< "Content-Type: application/x-www-form-urlencoded\r\n"
+		<< "Content-Length: " << body.size() << "\r\n"
+		<< "Connection: close\r\n\r\n"
+		<< body;
+	std::string	data = stream.str();
+	if (socket.send(data.data(), data.size()) != sf::Socket::Done)
+		return false;
+
+	sf::SocketSelector	selector;
+	std::string			response;
+	char				buffer[1024];
+	std::size_t			received;
+	bool				closed = false;
+
+	selector.add(socket);
+	while (!closed)
+	{
+		// The close is sent once stopped, the others are dropped
+		sf::Time	remaining = timeout - clock.getElapsedTime();
+		if (remaining <= sf::Time::Zero || (method != "DELETE" && !isRunning()))
+			return false;
+		if (!selector.wait(std::min(remaining, sf::milliseconds(100))))
+			continue;
+
+		sf::Socket::Status	result = socket.receive(buffer, sizeof(buffer), received);
+		if (result == sf::Socket::Done)
+			response.append(buffer, received);
+		else if (result == sf::Socket::Disconnected)
+			closed = true;
+		else
+			return false;
+	}
+
+	// "HTTP/1.1 200 OK\r\n...\r\n\r\nbody"
+	std::size_t	space = response.find(' ');
+	std::size_t	end = response.find("\r\n\r\n");
+	if (response.compare(0, 5, "HTTP/") != 0 || space == std::string::npos || end == std::string::npos)
+		return false;
+	status = atoi(response.c_str() + space);
+	answer = response.substr(end + 4);
+	_answered = true;
+	return true;
+}
+
+// Name / map / players... of the server
+std::string	WebSender::getStatus()
+{
+	std::ostringstream	stream;
+	Match::s_status		first = _matches.front()->getStatus();
+	unsigned int		players = first.players;
+
+	for (unsigned int i = 1; i < _matches.size(); ++i)
+		players += _matches[i]->getStatus().players;
+	stream << "&Name=" << _serverName
+		<< "&CurrentMap=" << first.map
+		<< "&PlayerNumber=" << players
+		<< "&MaxPlayer=" << _maxPlayer * _matches.size()
+		<< "&Port=" << _networkIo->getPort()
+		<< "&CurrentMode=" << first.mode;
+	return stream.str();
+}
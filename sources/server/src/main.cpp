@@ -40,7 +40,6 @@ int		init_game()
 		manager.run();
 		manager.stop();
 		VC_INFO_CRITICAL("Exiting...");
-		sf::sleep(sf::seconds(1)); // Sleep to send to send close request
 		S_Log->stop();
 	}
 	catch (std::runtime_error error)
@@ -15,19 +15,22 @@
 #include	<list>
 #include	"EventComponent.hpp"
 #include	"EventContainer.hpp"
+#include	"Defines.h"
 
 
 #if defined (_WIN32)
-#define ADD_EVENT(X, Y) Event::addEvent(__FUNCTION__, __LINE__, X, Y)
+#define EVENT_FUNCTION __FUNCTION__
 #else
-#define ADD_EVENT(X, Y) Event::addEvent(__PRETTY_FUNCTION__, __LINE__, X, Y)
+#define EVENT_FUNCTION __PRETTY_FUNCTION__
 #endif
 
-
-#if defined (_WIN32)
-#define ADD_EVENT_SIMPLE(X) Event::addEvent(__FUNCTION__, __LINE__, X)
+// Origin of events is only kept in debug builds
+#ifndef NDEBUG
+#define ADD_EVENT(X, Y) Event::addEvent(EVENT_FUNCTION, __LINE__, X, Y)
+#define ADD_EVENT_SIMPLE(X) Event::addEvent(EVENT_FUNCTION, __LINE__, X)
 #else
-#define ADD_EVENT_SIMPLE(X) Event::addEvent(__PRETTY_FUNCTION__, __LINE__, X)
+#define ADD_EVENT(X, Y) Event::addEvent(NULL, 0, X, Y)
+#define ADD_EVENT_SIMPLE(X) Event::addEvent(NULL, 0, X)
 #endif
 
 
@@ -39,30 +42,33 @@ namespace	Event
     EventUtils(void);
     ~EventUtils(void);
 
+    // One per thread, the server binds the one of the match it ticks
     static EventUtils* getInstance(void);
+    static void setInstance(EventUtils *instance);
   
     void clearEvents(void);
-	void addEvent(const std::string& funcName, int line, eventType type, s_event event);
+	void addEvent(const char *funcName, int line, eventType type, s_event event);
     bool eventAlreadyAddedForId(eventType type, sf::Uint32 id);
 	bool eventAlreadyAddedForEntity(eventType type, const std::shared_ptr<AObject> &entity);
-    std::list<std::pair<eventType, s_event> >* getEventByType(eventType type);
-	std::list<std::pair<eventType, s_event> >* getEventByObject(const std::shared_ptr<AObject> &trigger);
-    std::list<std::pair<eventType, s_event> >* getMainEventList(void);
+    t_eventList* getEventByType(eventType type);
+	t_eventList* getEventByObject(const std::shared_ptr<AObject> &trigger);
+    t_eventList* getMainEventList(void);
 
   private:
-    static EventUtils *_instance;
-	std::map<std::shared_ptr<AObject>, EventContainer> _eventByObject;
-    std::map<eventType, EventContainer> _eventByType;
-    std::list<std::pair<eventType, s_event> >_main;
+    static VC_THREAD_LOCAL EventUtils *_instance;
+    EventContainer _eventByType[ev_COUNT];
+    t_eventList _main;
+    t_eventList _eventByObject; // Built on demand by getEventByObject
+    sf::Uint32 _frame; // ev_DELETE dedup, see AObject::getDeleteMark
   };
 
   void clearEvents(void);
-  void addEvent(const std::string &funcName, int line, eventType type, s_event event = s_event());
+  void addEvent(const char *funcName, int line, eventType type, s_event event = s_event());
   bool eventAlreadyAddedForId(eventType type, sf::Uint32 id);
   bool eventAlreadyAddedForEntity(eventType type, const std::shared_ptr<AObject> &entity);
-  std::list<std::pair<eventType, s_event> >* getEventByType(eventType type);
-  std::list<std::pair<eventType, s_event> >* getEventByObject(const std::shared_ptr<AObject> &trigger);
-  std::list<std::pair<eventType, s_event> >* getMainEventList(void);
+  t_eventList* getEventByType(eventType type);
+  t_eventList* getEventByObject(const std::shared_ptr<AObject> &trigger);
+  t_eventList* getMainEventList(void);
 }
 
 #endif		/* !__EVENTTYPE_H__ */
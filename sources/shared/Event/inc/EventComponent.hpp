@@ -8,6 +8,7 @@
 #ifndef		__EVENTCOMPONENT_H__
 # define	__EVENTCOMPONENT_H__
 
+#include	<vector>
 #include	"AObject.hpp"
 
 enum		eventType	// Arguments of s_event (Trigger - Data)
@@ -26,7 +27,7 @@ enum		eventType	// Arguments of s_event (Trigger - Data)
 	ev_TURRET_LAUNCHED,	// Player (owner) - NULL
 	ev_GRAVITY_LAUNCHED,	// Player (owner) - NULL
 	ev_TURRET_FIRE,		// Player (owner) - AObject (bullet or rocket)
-	ev_WALL_COLLISION,	// AObject of collided object - t_impact struct
+	ev_WALL_COLLISION,	// AObject of collided object - s_event::impact
 	ev_EXPLOSION,		// Explosion - NULL
 	ev_PLAYER_BOOST_BOMB,	// Player - NULL
 	ev_PLAYER_HIT,		// Hitter (ex: bullet) - Hitted
@@ -97,19 +98,52 @@ enum		eventType	// Arguments of s_event (Trigger - Data)
 
 	// Change NickiMinajName
 	ev_NICKNAME_CHANGED,	// NULL - std::string * (to delete)
+
+	ev_COUNT			// Keep last - number of event types
 };
 
+class Wall;
+
+// Where an object hit a wall, payload of ev_WALL_COLLISION
+typedef	struct	s_impact
+{
+	std::shared_ptr<Wall>	wall;
+	std::pair<float, float>pos;
+}				t_impact;
+
 struct s_event
 {
 public:
 	s_event(const std::shared_ptr<AObject>& triggerIN  = NULL, void *dataIN = NULL) :
 		data(dataIN) {
 		trigger = triggerIN;
+#ifndef NDEBUG
+		raiseFunction = NULL;
+		raiseLine = 0;
+#endif
 	}
 
-	std::string raiseInfo;
+	// By value, kept with the event (nothing to delete)
+	s_event(const std::shared_ptr<AObject>& triggerIN, const t_impact &impactIN) :
+		data(NULL), impact(impactIN) {
+		trigger = triggerIN;
+#ifndef NDEBUG
+		raiseFunction = NULL;
+		raiseLine = 0;
+#endif
+	}
+
+#ifndef NDEBUG
+	const char *raiseFunction; // Where the event was raised, debug only
+	int raiseLine;
+#endif
 	std::shared_ptr<AObject> trigger;
 	void* data;
+	t_impact impact;	// ev_WALL_COLLISION only
 };
 
+// Events of a frame, capacity is kept between frames
+// Do not raise events while iterating, the list may move in memory
+typedef std::vector<std::pair<eventType, s_event> >	t_eventList;
+
 #endif		/* !__EVENTCOMPONENT_H__ */
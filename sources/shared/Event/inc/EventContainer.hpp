@@ -11,12 +11,11 @@
 #ifndef		__EVENTCONTAINER_H__
 # define	__EVENTCONTAINER_H__
 
-#include	<list>
-#include	<map>
 #include	"EventComponent.hpp"
 
 //////////////////////////////////////////////////////////////////////
 /////	Class designed for stock sorted events list
+/////	clearEvents keeps the memory, no allocation once warmed up
 //////////////////////////////////////////////////////////////////////
 
 class		EventContainer
@@ -30,10 +29,11 @@ public:
   void addEvent(eventType type, s_event event);
 
   // Getter
-  std::list<std::pair<eventType, s_event> >* getEvents(void);
+  t_eventList* getEvents(void);
+  bool empty(void) const;
 
 private:
-  std::list<std::pair<eventType, s_event> > _events;
+  t_eventList _events;
 };
 
 #endif		/* !__EVENTCONTAINER_H__ */
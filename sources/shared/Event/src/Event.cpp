@@ -16,13 +16,13 @@
 
 using namespace Event;
 
-EventUtils *EventUtils::_instance = NULL;
+VC_THREAD_LOCAL EventUtils *EventUtils::_instance = NULL;
 
 EventUtils::EventUtils(void)
 {
 	_main.clear();
 	_eventByObject.clear();
-	_eventByType.clear();
+	_frame = 1;
 }
 
 EventUtils::~EventUtils(void)
@@ -36,65 +36,71 @@ EventUtils* EventUtils::getInstance(void)
 	return _instance;
 }
 
+void	EventUtils::setInstance(EventUtils *instance)
+{
+	EventUtils::_instance = instance;
+}
+
 //////////////////////////////////////////////////////////////////////
 /////	Utility functions
 //////////////////////////////////////////////////////////////////////
 
 void	EventUtils::clearEvents(void)
 {
-	{
-		std::map<eventType, EventContainer>::iterator it;
-		for (it = _eventByType.begin(); it != _eventByType.end(); ++it)
-			it->second.clearEvents();
-	}
-
-	std::map<std::shared_ptr<AObject>, EventContainer>::iterator it;
-	for (it = _eventByObject.begin(); it != _eventByObject.end(); ++it)
-		it->second.clearEvents();
-
+	for (int type = 0; type < ev_COUNT; ++type)
+		_eventByType[type].clearEvents();
 	_main.clear();
 	_eventByObject.clear();
-	_eventByType.clear();
+
+	// Delete marks of this frame are now outdated
+	if (++_frame == 0)
+		_frame = 1;
 }
 
-void	EventUtils::addEvent(const std::string& funcName, int line, eventType type, s_event event)
+void	EventUtils::addEvent(const char *funcName, int line, eventType type, s_event event)
 {
-	event.raiseInfo = "Event raised in " + funcName + " at line " + std::to_string(line);
+#ifndef NDEBUG
+	event.raiseFunction = funcName;
+	event.raiseLine = line;
+#else
+	(void)funcName;
+	(void)line;
+#endif
 
 	// If event is not defined, ignore
-	if (type == ev_UNKNOWN)
+	if (type == ev_UNKNOWN || type >= ev_COUNT)
 		return;
 
-	if (!event.trigger && type == ev_DELETE)
-		VC_WARNING_CRITICAL("Event delete with nullptr detected");
-
-	if (type == ev_DELETE && eventAlreadyAddedForEntity(ev_DELETE, event.trigger) == true)
-		return;
+	if (type == ev_DELETE)
+	{
+		if (!event.trigger)
+		{
+			VC_WARNING_CRITICAL("Event delete with nullptr detected");
+			return;
+		}
+		if (event.trigger->getDeleteMark() == _frame)
+			return;
+		event.trigger->setDeleteMark(_frame);
+	}
 
 	// Add events in main container
 	_main.push_back(std::pair<eventType, s_event>(type, event));
 
 	// Add events in sorted containers
 	_eventByType[type].addEvent(type, event);
-	if (event.trigger != NULL)
-		_eventByObject[event.trigger].addEvent(type, event);
 }
 
 bool  EventUtils::eventAlreadyAddedForId(eventType type, sf::Uint32 id)
 {
 	if (Event::getEventByType(type))
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(type)->begin();
-		std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(type)->end();
+		t_eventList::const_iterator it = Event::getEventByType(type)->begin();
+		t_eventList::const_iterator end = Event::getEventByType(type)->end();
 
 		while (it != end)
 		{
-			// Il sert à rien ce test ???
-			if (it->first == type)
-			{
-				if ((((it->second.trigger))->getId()) == id)
-					return true;
-			}
+			if (it->second.trigger && it->second.trigger->getId() == id)
+				return true;
 			++it;
 		}
 	}
@@ -103,10 +109,13 @@ bool  EventUtils::eventAlreadyAddedForId(eventType type, sf::Uint32 id)
 
 bool  EventUtils::eventAlreadyAddedForEntity(eventType type, const std::shared_ptr<AObject> &entity)
 {
+	if (type == ev_DELETE)
+		return entity && entity->getDeleteMark() == _frame;
+
 	if (Event::getEventByType(type))
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(type)->begin();
-		std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(type)->end();
+		t_eventList::const_iterator it = Event::getEventByType(type)->begin();
+		t_eventList::const_iterator end = Event::getEventByType(type)->end();
 
 		while (it != end)
 		{
@@ -122,31 +131,32 @@ bool  EventUtils::eventAlreadyAddedForEntity(eventType type, const std::shared_p
 /////	Getters methods, !! return NULL if entry doesn't matches !!
 //////////////////////////////////////////////////////////////////////
 
-std::list<std::pair<eventType, s_event> >* EventUtils::getMainEventList(void)
+t_eventList* EventUtils::getMainEventList(void)
 {
 	return &_main;
 }
 
 //------------------------------------------------------------------//
 
-std::list<std::pair<eventType, s_event> >* EventUtils::getEventByType(eventType type)
+t_eventList* EventUtils::getEventByType(eventType type)
 {
-	std::map<eventType, EventContainer>::const_iterator found = _eventByType.find(type);
-
-	if (found != _eventByType.end())
-		return _eventByType[type].getEvents();
-	return NULL;
+	if (type >= ev_COUNT || _eventByType[type].empty())
+		return NULL;
+	return _eventByType[type].getEvents();
 }
 
 //------------------------------------------------------------------//
 
-std::list<std::pair<eventType, s_event> >* EventUtils::getEventByObject(const std::shared_ptr<AObject> &trigger)
+t_eventList* EventUtils::getEventByObject(const std::shared_ptr<AObject> &trigger)
 {
-	std::map<std::shared_ptr<AObject>, EventContainer>::const_iterator found = _eventByObject.find(trigger);
+	_eventByObject.clear();
+	for (t_eventList::const_iterator it = _main.begin(); it != _main.end(); ++it)
+		if (it->second.trigger == trigger)
+			_eventByObject.push_back(*it);
 
-	if (found != _eventByObject.end())
-		return _eventByObject[trigger].getEvents();
-	return NULL;
+	if (_eventByObject.empty())
+		return NULL;
+	return &_eventByObject;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -162,26 +172,26 @@ void Event::clearEvents(void)
 
 //------------------------------------------------------------------//
 
-void Event::addEvent(const std::string &funcName, int line, eventType type, s_event event)
+void Event::addEvent(const char *funcName, int line, eventType type, s_event event)
 {
 	return EventUtils::getInstance()->addEvent(funcName, line, type, event);
 }
 
 //------------------------------------------------------------------//
 
-std::list<std::pair<eventType, s_event> >* Event::getEventByType(eventType type)
+t_eventList* Event::getEventByType(eventType type)
 {
 	return EventUtils::getInstance()->getEventByType(type);
 }
 
 //------------------------------------------------------------------//
-std::list<std::pair<eventType, s_event> >* Event::getEventByObject(const std::shared_ptr<AObject> &trigger)
+t_eventList* Event::getEventByObject(const std::shared_ptr<AObject> &trigger)
 {
 	return EventUtils::getInstance()->getEventByObject(trigger);
 }
 
 //------------------------------------------------------------------//
-std::list<std::pair<eventType, s_event> >* Event::getMainEventList(void)
+t_eventList* Event::getMainEventList(void)
 {
 	return EventUtils::getInstance()->getMainEventList();
 }
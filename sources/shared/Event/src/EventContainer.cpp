@@ -37,11 +37,16 @@ void	EventContainer::addEvent(eventType type, s_event event)
   _events.push_back(std::pair<eventType, s_event>(type, event));
 }
 
+bool	EventContainer::empty(void) const
+{
+  return _events.empty();
+}
+
 //////////////////////////////////////////////////////////////////////
 /////	Getter
 //////////////////////////////////////////////////////////////////////
 
-std::list<std::pair<eventType, s_event> >* EventContainer::getEvents(void)
+t_eventList* EventContainer::getEvents(void)
 {
   return &_events;
 }
@@ -9,13 +9,54 @@
 #define VOIDCLASH_LOG
 
 #include <SFML/System/Clock.hpp>
+#include <SFML/System/Thread.hpp>
+#include <SFML/Config.hpp>
 #include <fstream>
 #include <string>
+#include <atomic>
 #include "SingletonBase.hpp"
+#include "MpscRing.hpp"
 #include "Defines.h"
 
+#define LOG_QUEUE_SIZE		1024			// Records waiting for the writer, dropped above - MUST BE A POWER OF 2
+#define LOG_RECORD_TEXT		400				// Longer messages are cut
+#define LOG_WRITER_WAIT		10				// in ms - the writer sleeps when the queue is empty
+#define LOG_SITES			512				// Rate limits of the call sites, the sites above are not limited
+#define LOG_SITE_RATE		32				// Messages / sec from a call site, the next ones are counted and skipped
+#define LOG_MAX_SIZE		(8 * 1024 * 1024)	// in bytes - the file is moved to <name>.1 and started again
+
+class CLog;
+
+/////////////////////////////////////////////////////////////////////
+/////	Call site of the VC_* macros, for the rate limits
+/////////////////////////////////////////////////////////////////////
+
+class CLogSite
+{
+public:
+	CLogSite(CLog *log, const char *file, int line);
+
+	void info(const std::string &message);
+	void infoCritical(const std::string &message);
+	void warning(const std::string &message);
+	void warningCritical(const std::string &message);
+	void error(const std::string &message, bool needThrow = false);
+	void errorCritical(const std::string &message, bool needThrow = true);
+
+private:
+	CLog *_log;
+	const char *_file;
+	int _line;
+};
+
 /////////////////////////////////////////////////////////////////////
 /////	Void clash client/server log system
+/////	Messages are copied in records, any thread can log without
+/////	waiting: a writer thread formats and writes them (and moves
+/////	the file when it is too big)
+/////	Every level is rate limited by call site (VC_* macros). Direct
+/////	calls (no file / line: fatal errors, shutdown) and the errors
+/////	which throw are always written
 /////////////////////////////////////////////////////////////////////
 
 class CLog
@@ -24,27 +65,66 @@ public:
 	CLog(void);
 	~CLog(void);
 
-	// Open the log file
+	// Open the log file, start the writer
 	void start(unsigned int debugLevel, bool printMessagesInConsole = false);
-	// Close and delete the log file if no errors occurs
+	// Write what is left, close and delete the log file if no errors occurs
 	void stop(bool deleteLog = true);
 
 	// Write an info depending if the debug level is >= 3
-	void info(const std::string &message);
+	void info(const std::string &message, const char *file = NULL, int line = 0);
 	// Write an info without checking the debug level
-	void infoCritical(const std::string &message);
+	void infoCritical(const std::string &message, const char *file = NULL, int line = 0);
 
 	// Write a warning if the debug level is >= 2
-	void warning(const std::string &message);
+	void warning(const std::string &message, const char *file = NULL, int line = 0);
 	// Write a warning without checking the debug level
-	void warningCritical(const std::string &message);
+	void warningCritical(const std::string &message, const char *file = NULL, int line = 0);
 
 	// Write an error if the debug level is >= 1, throw is needThrow == true
-	void error(const std::string &message, bool needThrow = false);
+	void error(const std::string &message, bool needThrow = false, const char *file = NULL, int line = 0);
 	// Write an error without checking the debug level, throw is needThrow == true
-	void errorCritical(const std::string &message, bool needThrow = true);
+	void errorCritical(const std::string &message, bool needThrow = true, const char *file = NULL, int line = 0);
+
+	CLogSite at(const char *file, int line);
 
 private:
+	enum eLogType
+	{
+		LOG_INFO = 0,
+		LOG_WARNING,
+		LOG_ERROR
+	};
+
+	// Binary, formatted by the writer
+	struct s_record
+	{
+		sf::Uint8 type;
+		bool console;
+		sf::Int64 time;			// in micro sec since start
+		sf::Uint16 size;
+		char text[LOG_RECORD_TEXT];
+	};
+
+	// Messages of a call site in the current second
+	// Slot taken once for good: file first, then line (never 0)
+	struct s_site
+	{
+		std::atomic<const char *> file;
+		std::atomic<int> line;
+		std::atomic<sf::Uint32> second;
+		std::atomic<sf::Uint32> count;
+		std::atomic<sf::Uint32> skipped;
+	};
+
+	void write(eLogType type, bool console, const std::string &message, const char *file, int line);
+	bool push(eLogType type, bool console, const std::string &message, sf::Int64 time);
+	bool allow(const char *file, int line, sf::Int64 time);
+	s_site *findSite(const char *file, int line);
+
+	void writerLoop(void);
+	void writeRecord(const s_record &record);
+	void rotate(void);
+
 	unsigned int getCurrentTime(void);
 
 private:
@@ -53,18 +133,25 @@ private:
 	std::fstream _logFile;
 	sf::Clock _currentTime;
 	std::string _filename;
+
+	std::atomic<bool> _started;
+	std::atomic<bool> _running;		// Writer
+	sf::Thread _writer;
+	MpscRing<s_record, LOG_QUEUE_SIZE> _queue;
+	std::atomic<sf::Uint32> _dropped;	// Queue was full
+	s_site _sites[LOG_SITES];
 };
 
 // Define singleton
 typedef SingletonBase<CLog> LogSingleton;
 #define S_Log LogSingleton::self()
 
-// Shortcut
-#define VC_INFO S_Log->info
-#define VC_INFO_CRITICAL S_Log->infoCritical
-#define VC_WARNING S_Log->warning
-#define VC_WARNING_CRITICAL S_Log->warningCritical
-#define VC_ERROR S_Log->error
-#define VC_ERROR_CRITICAL S_Log->errorCritical
+// Shortcut, rate limited by call site
+#define VC_INFO S_Log->at(__FILE__, __LINE__).info
+#define VC_INFO_CRITICAL S_Log->at(__FILE__, __LINE__).infoCritical
+#define VC_WARNING S_Log->at(__FILE__, __LINE__).warning
+#define VC_WARNING_CRITICAL S_Log->at(__FILE__, __LINE__).warningCritical
+#define VC_ERROR S_Log->at(__FILE__, __LINE__).error
+#define VC_ERROR_CRITICAL S_Log->at(__FILE__, __LINE__).errorCritical
 
 #endif /* VOIDCLASH_LOG */
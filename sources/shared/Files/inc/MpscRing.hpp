@@ -0,0 +1,87 @@
+//
+// MpscRing.hpp for Void Clash
+//
+
+#ifndef		MPSCRING_HPP_
+# define	MPSCRING_HPP_
+
+#include	<atomic>
+
+///////////////////////////////////////////////
+/////   Lock free multiple producers / single consumer queue
+/////	Each slot has a sequence telling whose turn it is: a producer
+/////	claims a position, fills its slot then commits it. A full
+/////	queue is never waited for, reserve() returns NULL
+/////	Capacity MUST BE A POWER OF 2
+
+template <typename T, unsigned int Capacity>
+class	MpscRing
+{
+public:
+	MpscRing() : _head(0), _tail(0)
+	{
+		for (unsigned int i = 0; i < Capacity; ++i)
+			_slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	// Producer side, any thread
+	// Free slot and its position for commit(), NULL if the queue is full
+	T	*reserve(unsigned int &position)
+	{
+		position = _head.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			s_slot	&slot = _slots[position & (Capacity - 1)];
+			int		diff = static_cast<int>(slot.sequence.load(std::memory_order_acquire) - position);
+
+			if (diff == 0)
+			{
+				if (_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					return &slot.value;
+			}
+			else if (diff < 0)
+				return NULL;
+			else
+				position = _head.load(std::memory_order_relaxed);
+		}
+	}
+
+	void	commit(unsigned int position)
+	{
+		_slots[position & (Capacity - 1)].sequence.store(position + 1, std::memory_order_release);
+	}
+
+	// Consumer side, one thread
+	// Oldest committed slot, NULL if there is none. Released by pop()
+	T	*front()
+	{
+		s_slot	&slot = _slots[_tail & (Capacity - 1)];
+
+		if (slot.sequence.load(std::memory_order_acquire) != _tail + 1)
+			return NULL;
+		return &slot.value;
+	}
+
+	void	pop()
+	{
+		_slots[_tail & (Capacity - 1)].sequence.store(_tail + Capacity, std::memory_order_release);
+		++_tail;
+	}
+
+private:
+	MpscRing(const MpscRing &);
+	MpscRing	&operator=(const MpscRing &);
+
+	struct	s_slot
+	{
+		std::atomic<unsigned int>	sequence;
+		T							value;
+	};
+
+	s_slot	_slots[Capacity];
+
+	std::atomic<unsigned int>	_head;	// Producers
+	unsigned int				_tail;	// Consumer only
+};
+
+#endif
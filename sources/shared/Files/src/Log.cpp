@@ -10,6 +10,11 @@
 #include <sstream>
 #include <iomanip>
 #include <ctime>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <thread>
+#include <SFML/System/Sleep.hpp>
 #include "Log.hpp"
 
 extern bool G_isServer;
@@ -18,15 +23,28 @@ extern bool G_isServer;
 /////	Constructor / Destructor
 /////////////////////////////////////////////////////////////////////
 
-CLog::CLog(void)
+CLog::CLog(void) :
+_started(false), _running(false), _writer(&CLog::writerLoop, this), _dropped(0)
 {
 	_debugLevel = DEBUG_LEVEL;
 	_printMessagesInConsole = false;
 	_filename = "";
+	for (unsigned int i = 0; i < LOG_SITES; ++i)
+	{
+		_sites[i].file = NULL;
+		_sites[i].line = 0;
+		_sites[i].second = 0;
+		_sites[i].count = 0;
+		_sites[i].skipped = 0;
+	}
 }
 
 CLog::~CLog(void)
 {
+	// Not stopped (crash...), keep what was logged
+	_started = false;
+	_running = false;
+	_writer.wait();
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -52,6 +70,9 @@ void CLog::start(unsigned int debugLevel, bool printMessagesInConsole)
 
 		_logFile.open(_filename, std::fstream::out);
 		_currentTime.restart();
+		_running = true;
+		_writer.launch();
+		_started = true;
 	}
 }
 
@@ -61,13 +82,21 @@ void CLog::start(unsigned int debugLevel, bool printMessagesInConsole)
 
 void CLog::stop(bool deleteLog)
 {
+	// New messages are ignored, the queued ones are written
+	_started = false;
+	_running = false;
+	_writer.wait();
+
 	if (_logFile.is_open() == true)
 	{
 		_logFile.close();
 
 		// If the game close normally, delete it
 		if (deleteLog)
+		{
 			std::remove(_filename.c_str());
+			std::remove((_filename + ".1").c_str());
+		}
 		// Else rename it with the current date/time
 		else
 		{
@@ -88,27 +117,15 @@ void CLog::stop(bool deleteLog)
 /////	_debugLevel >= 3
 /////////////////////////////////////////////////////////////////////
 
-void CLog::info(const std::string &message)
+void CLog::info(const std::string &message, const char *file, int line)
 {
 	if (_debugLevel >= 3)
-	{
-		if (_logFile.is_open() == false)
-			return;
-
-		_logFile << "[" << getCurrentTime() << "] INFO: " << message << std::endl;
-
-		if (_printMessagesInConsole == true)
-			std::cout << "[" << getCurrentTime() << "] INFO: " << message << std::endl;
-	}
+		write(LOG_INFO, _printMessagesInConsole, message, file, line);
 }
 
-void CLog::infoCritical(const std::string &message)
+void CLog::infoCritical(const std::string &message, const char *file, int line)
 {
-	if (_logFile.is_open() == false)
-		return;
-
-	std::cout << "[" << getCurrentTime() << "] INFO: " << message << std::endl;
-	_logFile << "[" << getCurrentTime() << "] INFO: " << message << std::endl;
+	write(LOG_INFO, true, message, file, line);
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -116,26 +133,15 @@ void CLog::infoCritical(const std::string &message)
 ////	_debugLevel >= 2
 /////////////////////////////////////////////////////////////////////
 
-void CLog::warning(const std::string &message)
+void CLog::warning(const std::string &message, const char *file, int line)
 {
 	if (_debugLevel >= 2)
-	{
-		if (_logFile.is_open() == false)
-			return;
-
-		_logFile << "[" << getCurrentTime() << "] WARNING: " << message << std::endl;
-		if (_printMessagesInConsole == true)
-			std::cout << "[" << getCurrentTime() << "] WARNING: " << message << std::endl;
-	}
+		write(LOG_WARNING, _printMessagesInConsole, message, file, line);
 }
 
-void CLog::warningCritical(const std::string &message)
+void CLog::warningCritical(const std::string &message, const char *file, int line)
 {
-	if (_logFile.is_open() == false)
-		return;
-
-	std::cout << "[" << getCurrentTime() << "] WARNING: " << message << std::endl;
-	_logFile << "[" << getCurrentTime() << "] WARNING: " << message << std::endl;
+	write(LOG_WARNING, true, message, file, line);
 }
 
 /////////////////////////////////////////////////////////////////////
@@ -143,16 +149,15 @@ void CLog::warningCritical(const std::string &message)
 ////	_debugLevel >= 1
 /////////////////////////////////////////////////////////////////////
 
-void CLog::error(const std::string &message, bool needThrow)
+void CLog::error(const std::string &message, bool needThrow, const char *file, int line)
 {
 	if (_debugLevel >= 1)
 	{
-		if (_logFile.is_open() == false)
+		if (_started == false)
 			return;
 
-		_logFile << "[" << getCurrentTime() << "] ERROR: " << message << std::endl;
-		if (_printMessagesInConsole == true)
-			std::cout << "[" << getCurrentTime() << "] ERROR: " << message << std::endl;
+		// The error before the throw is always written
+		write(LOG_ERROR, _printMessagesInConsole, message, needThrow ? NULL : file, line);
 
 		// Close the log file
 		if (needThrow == true)
@@ -164,13 +169,12 @@ void CLog::error(const std::string &message, bool needThrow)
 	}
 }
 
-void CLog::errorCritical(const std::string &message, bool needThrow)
+void CLog::errorCritical(const std::string &message, bool needThrow, const char *file, int line)
 {
-	if (_logFile.is_open() == false)
+	if (_started == false)
 		return;
 
-	_logFile << "[" << getCurrentTime() << "] ERROR: " << message << std::endl;
-	std::cout << "[" << getCurrentTime() << "] ERROR: " << message << std::endl;
+	write(LOG_ERROR, true, message, needThrow ? NULL : file, line);
 
 	// Close the log file
 	if (needThrow == true)
@@ -181,6 +185,173 @@ void CLog::errorCritical(const std::string &message, bool needThrow)
 	}
 }
 
+CLogSite CLog::at(const char *file, int line)
+{
+	return CLogSite(this, file, line);
+}
+
+/////////////////////////////////////////////////////////////////////
+/////	Queue a record, from any thread
+/////	Never waits: the message is dropped if the queue is full
+/////////////////////////////////////////////////////////////////////
+
+void CLog::write(eLogType type, bool console, const std::string &message, const char *file, int line)
+{
+	if (_started == false)
+		return;
+
+	sf::Int64 time = _currentTime.getElapsedTime().asMicroseconds();
+	if (file != NULL && !allow(file, line, time))
+		return;
+	push(type, console, message, time);
+}
+
+bool CLog::push(eLogType type, bool console, const std::string &message, sf::Int64 time)
+{
+	unsigned int position;
+	s_record *record = _queue.reserve(position);
+
+	if (record == NULL)
+	{
+		++_dropped;
+		return false;
+	}
+	record->type = type;
+	record->console = console;
+	record->time = time;
+	record->size = static_cast<sf::Uint16>(std::min<std::size_t>(message.size(), LOG_RECORD_TEXT));
+	std::memcpy(record->text, message.data(), record->size);
+	_queue.commit(position);
+	return true;
+}
+
+// LOG_SITE_RATE messages / sec, the count of the skipped ones comes with
+// the next message of the site after that second
+bool CLog::allow(const char *file, int line, sf::Int64 time)
+{
+	s_site *found = findSite(file, line);
+
+	// Table full, not limited rather than counted with another site
+	if (found == NULL)
+		return true;
+
+	s_site &site = *found;
+	sf::Uint32 second = static_cast<sf::Uint32>(time / 1000000);
+	sf::Uint32 last = site.second.load(std::memory_order_relaxed);
+
+	if (last != second && site.second.compare_exchange_strong(last, second, std::memory_order_relaxed))
+	{
+		sf::Uint32 skipped = site.skipped.exchange(0, std::memory_order_relaxed);
+
+		site.count.store(0, std::memory_order_relaxed);
+		if (skipped > 0)
+			push(LOG_WARNING, _printMessagesInConsole, std::to_string(skipped) + " messages skipped from "
+				+ file + ":" + std::to_string(line) + " (more than " + std::to_string(LOG_SITE_RATE) + " / sec)", time);
+	}
+	if (site.count.fetch_add(1, std::memory_order_relaxed) < LOG_SITE_RATE)
+		return true;
+	site.skipped.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+// Open addressing on (file, line), a free slot is taken for the site
+CLog::s_site *CLog::findSite(const char *file, int line)
+{
+	std::size_t hash = (reinterpret_cast<std::size_t>(file) >> 3) ^ (static_cast<std::size_t>(line) * 2654435761u);
+
+	for (unsigned int i = 0; i < LOG_SITES; ++i)
+	{
+		s_site &site = _sites[(hash + i) % LOG_SITES];
+		const char *taken = site.file.load(std::memory_order_acquire);
+
+		if (taken == NULL && site.file.compare_exchange_strong(taken, file, std::memory_order_acq_rel))
+		{
+			site.line.store(line, std::memory_order_release);
+			return &site;
+		}
+		if (taken != file)
+			continue;
+
+		// Same file, its line is being stored by another thread
+		int takenLine;
+		while ((takenLine = site.line.load(std::memory_order_acquire)) == 0)
+			std::this_thread::yield();
+		if (takenLine == line)
+			return &site;
+	}
+	return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////
+/////	Writer thread
+/////	Flushes once the queue is empty, not after each line
+/////////////////////////////////////////////////////////////////////
+
+void CLog::writerLoop(void)
+{
+	bool running = true;
+
+	while (running)
+	{
+		// Last pass once stopped, for what was queued before
+		running = _running;
+
+		s_record *record;
+		bool written = false;
+		while ((record = _queue.front()) != NULL)
+		{
+			writeRecord(*record);
+			_queue.pop();
+			written = true;
+		}
+
+		sf::Uint32 dropped = _dropped.exchange(0);
+		if (dropped > 0)
+		{
+			_logFile << "[" << getCurrentTime() << "] WARNING: " << dropped << " messages dropped, the log queue was full\n";
+			written = true;
+		}
+
+		if (written)
+		{
+			_logFile.flush();
+			std::cout.flush();
+			if (_logFile.tellp() > LOG_MAX_SIZE)
+				rotate();
+		}
+		else if (running)
+			sf::sleep(sf::milliseconds(LOG_WRITER_WAIT));
+	}
+}
+
+void CLog::writeRecord(const s_record &record)
+{
+	static const char *types[] = { "INFO", "WARNING", "ERROR" };
+	unsigned int seconds = static_cast<unsigned int>(record.time / 1000000);
+
+	_logFile << "[" << seconds << "] " << types[record.type] << ": ";
+	_logFile.write(record.text, record.size);
+	_logFile << '\n';
+
+	if (record.console == true)
+	{
+		std::cout << "[" << seconds << "] " << types[record.type] << ": ";
+		std::cout.write(record.text, record.size);
+		std::cout << '\n';
+	}
+}
+
+// Writer thread only, the game never waits for the disk
+void CLog::rotate(void)
+{
+	std::string previous = _filename + ".1";
+
+	_logFile.close();
+	std::remove(previous.c_str());
+	std::rename(_filename.c_str(), previous.c_str());
+	_logFile.open(_filename, std::fstream::out);
+}
+
 /////////////////////////////////////////////////////////////////////
 /////	Return current time in seconds
 /////////////////////////////////////////////////////////////////////
@@ -189,3 +360,42 @@ unsigned int CLog::getCurrentTime(void)
 {
 	return _currentTime.getElapsedTime().asSeconds();
 }
+
+/////////////////////////////////////////////////////////////////////
+/////	Call site
+/////////////////////////////////////////////////////////////////////
+
+CLogSite::CLogSite(CLog *log, const char *file, int line) :
+_log(log), _file(file), _line(line)
+{
+}
+
+void CLogSite::info(const std::string &message)
+{
+	_log->info(message, _file, _line);
+}
+
+void CLogSite::infoCritical(const std::string &message)
+{
+	_log->infoCritical(message, _file, _line);
+}
+
+void CLogSite::warning(const std::string &message)
+{
+	_log->warning(message, _file, _line);
+}
+
+void CLogSite::warningCritical(const std::string &message)
+{
+	_log->warningCritical(message, _file, _line);
+}
+
+void CLogSite::error(const std::string &message, bool needThrow)
+{
+	_log->error(message, needThrow, _file, _line);
+}
+
+void CLogSite::errorCritical(const std::string &message, bool needThrow)
+{
+	_log->errorCritical(message, needThrow, _file, _line);
+}
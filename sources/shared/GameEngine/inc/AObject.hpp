@@ -14,9 +14,11 @@
 #include	<SFML/Network.hpp>
 #include	<memory>
 #include	"ConfigParser.hpp"
+#include	"EntityStore.hpp"
 
 class Player;
 class GameEngine;
+class BitReader;
 
 enum	eObjectType
 {
@@ -47,7 +49,7 @@ class AObject : public std::enable_shared_from_this<AObject>
 public:
 	explicit AObject(void);
 	explicit AObject(eObjectType type, float X, float Y, float dirX, float dirY);
-	AObject(std::shared_ptr<AObject>) { };
+	AObject(std::shared_ptr<AObject>) : _deleteMark(0) { };
 	virtual ~AObject(void);
 	void	damage(float posX, float posY, float endX, float endY, float width, float height, float team);
 
@@ -104,6 +106,16 @@ public:
 	// MANDATORY to call this function to push AObject in MAP
 	void pushInMap(void);
 
+	// Map storage, set by MapUtils
+	const EntityHandle	&getStoreHandle() const { return _storeHandle; } // In elems or walls
+	const EntityHandle	&getViewHandle() const { return _viewHandle; } // In players, bots or turrets
+	void	setStoreHandle(const EntityHandle &handle) { _storeHandle = handle; }
+	void	setViewHandle(const EntityHandle &handle) { _viewHandle = handle; }
+
+	// Frame of the last ev_DELETE raised on this object, set by Event
+	sf::Uint32	getDeleteMark() const { return _deleteMark; }
+	void	setDeleteMark(sf::Uint32 frame) { _deleteMark = frame; }
+
 protected:
 	std::shared_ptr<Player>	_owner;
 	int _radius;
@@ -126,6 +138,10 @@ protected:
 
 	sf::Uint32 _id;
 
+	EntityHandle	_storeHandle;
+	EntityHandle	_viewHandle;
+	sf::Uint32		_deleteMark;
+
 	// Map editor
 	bool _selected;
 };
@@ -14,9 +14,8 @@
 struct		s_actions
 {
   s_actions(void) {}
-  s_actions(const s_actions &cpy) : moveX(cpy.moveX), moveY(cpy.moveY),
-				    aimX(cpy.aimX), aimY(cpy.aimY),
-					primary(cpy.primary), secondary(cpy.secondary) {}
+  s_actions(const s_actions &cpy) = default;
+  s_actions	&operator=(const s_actions &cpy) = default;
   sf::Int16	moveX;
   sf::Int16	moveY;
   float		aimX;
@@ -37,7 +37,7 @@ public:
   bool isLastStep(void); // Graphic utils
   float getRemainingTime(void);
 
-  friend sf::Packet& operator >>(sf::Packet& packet, Bomb &m);
+  friend BitReader& operator >>(BitReader& reader, Bomb &m);
 
 private:
   float		_time;
@@ -24,7 +24,7 @@ public:
 
 	sf::Int16	getLife(void) const;
 
-	friend sf::Packet& operator >>(sf::Packet& packet, Bot &m);
+	friend BitReader& operator >>(BitReader& reader, Bot &m);
 
 private:
 	sf::Clock			_clock;
@@ -29,11 +29,12 @@ public:
   bool	checkHitPlayers();
   bool	checkHitTurrets();
   bool	checkHitBots();
+  bool	hitPlayer(const std::shared_ptr<Player> &player);
 
   bool	isInsideHitbox(int X, int Y, float radius);
   eObjectType	getMakerType();
 
-  friend sf::Packet& operator >>(sf::Packet& packet, Bullet &m);
+  friend BitReader& operator >>(BitReader& reader, Bullet &m);
 
 private:
   float		_time;
@@ -26,7 +26,7 @@ public:
 	// Thresholds are: -CONTROL_MAX <= team 2 control <= -TIME_TO_CAPTURE <= neutral <= TIME_TO_CAPTURE <= team 1 control <= CONTROL_MAX
 	float			getControledStatus() const;
 
-	friend sf::Packet& operator >>(sf::Packet& packet, Capture &m);
+	friend BitReader& operator >>(BitReader& reader, Capture &m);
 
 
 private:
@@ -32,11 +32,12 @@ public:
   bool	checkWallMet(std::shared_ptr<AObject>obj) const;
   bool	wallMet(float X, float Y) const;
 
-  bool	checkSegmentSegment(std::shared_ptr<AObject>nmy);
+  bool	checkSegmentSegment(float x, float y);
+  void	hitPlayer(const std::shared_ptr<Player> &player, float x, float y, float proximity);
   bool	CollisionSegSeg(Point A, Point B, Point O, Point P);
   bool	CollisionDroiteSeg(Point A, Point B, Point O, Point P);
 
-  friend sf::Packet& operator >>(sf::Packet& packet, Explosion &m);
+  friend BitReader& operator >>(BitReader& reader, Explosion &m);
 
   eObjectType	getMakerType();
 
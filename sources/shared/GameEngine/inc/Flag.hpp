@@ -40,7 +40,7 @@ public:
 	const float&	getInitX() const;
 	const float&	getInitY() const;
 
-	friend sf::Packet& operator >>(sf::Packet& packet, Flag &m);
+	friend BitReader& operator >>(BitReader& reader, Flag &m);
 
 private:
 	bool _flagAtSpawn;
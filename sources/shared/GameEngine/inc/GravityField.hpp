@@ -44,7 +44,7 @@ public:
   void	checkFrameActivityEffects();
   void	applyFrameActivityEffects(float distance, AObject *obj);
 
-  friend sf::Packet& operator >>(sf::Packet& packet, GravityField &m);
+  friend BitReader& operator >>(BitReader& reader, GravityField &m);
 
 private:
 	float		_time;
@@ -21,6 +21,7 @@ class	GameEngine;
 class	Bomb;
 class	Flag;
 class	AI;
+struct	s_playerState;
 
 #define	GLOBAL_CAP_SPEED	15.0f
 
@@ -44,6 +45,7 @@ public:
   void	movePlayer(float projX, float projY);
   bool	maxSpeedReached(float maxSpeed, float projX, float projY);
   void	applyFriction(float, float);
+  void	predictMove(const s_actions &actions, const sf::Time &deltaTime);
 
   // Velocity weapon
   void	addPlayerVelocity(float *dirX, float *dirY);
@@ -117,6 +119,7 @@ public:
   void			setMapTime(sf::Time time);
 
   friend sf::Packet& operator >>(sf::Packet& packet, Player &m);
+  friend void	applyPlayerState(Player &m, const s_playerState &state);
 
 private:
 	bool init = false;
@@ -125,7 +128,7 @@ private:
   float		_killedTime;
   sf::Time	_respawnTime;
   std::string	_nick;
-  float		_latency;
+  float		_latency;	// in micro sec
   bool		_controled;
   bool		_insideGravityField;
   bool		_insideRespawn;
@@ -160,5 +163,7 @@ private:
 };
 
 sf::Packet& operator >>(sf::Packet& packet, Player &m);
+void	applyPlayerState(Player &m, const s_playerState &state);
+void	capturePlayerState(s_playerState &state, const Player &m);
 
 #endif
@@ -48,7 +48,7 @@ public:
   bool	CollisionPointCercle(sf::Vector2f A, Circle C);
   bool  CollisionDroite(sf::Vector2f A,sf::Vector2f B,Circle C);
 
-  friend sf::Packet& operator >>(sf::Packet& packet, Respawn &m);
+  friend BitReader& operator >>(BitReader& reader, Respawn &m);
 
 private:
 };
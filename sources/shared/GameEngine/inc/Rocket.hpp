@@ -18,7 +18,7 @@ public:
 
 	bool	checkImpact(float &exploX, float &exploY);
 
-	friend sf::Packet& operator >>(sf::Packet& packet, Rocket &m);
+	friend BitReader& operator >>(BitReader& reader, Rocket &m);
 
 	const std::pair<float, float>	&getImpact(void) const;
 
@@ -33,7 +33,7 @@ public:
 
   void	onStart();
 
-  friend sf::Packet& operator >>(sf::Packet& packet, SpeedField &m);
+  friend BitReader& operator >>(BitReader& reader, SpeedField &m);
 
 private:
 };
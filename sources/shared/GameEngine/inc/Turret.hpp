@@ -28,7 +28,7 @@ public:
 	// Setterz
 	void		resetEnnemyLocked();
 
-	friend sf::Packet& operator >>(sf::Packet& packet, Turret &m);
+	friend BitReader& operator >>(BitReader& reader, Turret &m);
 
 private:
 	// Subweapon fire
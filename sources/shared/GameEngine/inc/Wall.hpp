@@ -42,7 +42,7 @@ public:
   int				getLen() const;
   const float&		getAngle() const;
 
-  friend sf::Packet& operator >>(sf::Packet& packet, Wall &m);
+  friend BitReader& operator >>(BitReader& reader, Wall &m);
 
 private:
 	int					_len;
@@ -230,9 +230,12 @@ void	AI::setMoveInputs(float goalX, float goalY)
 	_player->_actions.moveX = resX;
 	_player->_actions.moveY = resY;
 	// Collision on previous frame
-	for (auto it = Event::getMainEventList()->begin(); it != Event::getMainEventList()->end(); ++it)
+	t_eventList	*collisions = Event::getEventByType(ev_WALL_COLLISION);
+	if (collisions == NULL)
+		return;
+	for (auto it = collisions->begin(); it != collisions->end(); ++it)
 	{
-		if (it->first == ev_WALL_COLLISION && it->second.trigger == _player)
+		if (it->second.trigger == _player)
 		{
 			sf::Int16 tmp = _player->_actions.moveX;
 			_player->_actions.moveX = _player->_actions.moveY;
@@ -10,6 +10,7 @@
 
 #include	<iostream>
 #include	<complex>
+#include	<atomic>
 #include	"AObject.hpp"
 #include	"Defines.h"
 #include	"ConfigParser.hpp"
@@ -19,7 +20,7 @@
 
 extern t_config *G_conf;
 extern bool	G_isServer;
-extern int	G_id;
+extern std::atomic<int>	G_id;
 
 AObject::AObject() :
 	_coefDeltaTime(0.0f),
@@ -27,6 +28,7 @@ AObject::AObject() :
 	_pos(std::pair<float, float>(0.f, 0.f))
 {
 	_selected = false;
+	_deleteMark = 0;
 }
 
 AObject::AObject(eObjectType type,
@@ -42,8 +44,7 @@ AObject::AObject(eObjectType type,
 {
 	if (G_isServer)
 	{
-		_id = G_id;
-		G_id++;
+		_id = G_id++;	// Objects are created by several matches at once
 	}
 	_radius = 40;
 	_owner = NULL;
@@ -51,6 +52,7 @@ AObject::AObject(eObjectType type,
 	_slowStartTime = 0.f;
 	_slowDuration = 0.f;
 	_selected = false;
+	_deleteMark = 0;
 }
 
 AObject::~AObject()
@@ -49,28 +49,23 @@ t_weapon	*AWeapon::getProperty()
 // Check if a wall collision event has been raised by the physX engine for this object
 bool	AWeapon::checkCollisionWithWalls(float &exploX, float &exploY)
 {
-	std::list<std::pair<eventType, s_event> >::const_iterator it;
-
-	for (it = Event::getMainEventList()->begin(); it != Event::getMainEventList()->end(); ++it)
-	{
-		if (it->first == ev_WALL_COLLISION && it->second.trigger.get() == this)
-		{
-			exploX = getX();
-			exploY = getY();
-			return true;
-		}
-	}
-	return false;
+	if (checkCollisionWithWalls() == false)
+		return false;
+	exploX = getX();
+	exploY = getY();
+	return true;
 }
 
 // Check if a wall collision event has been raised by the physX engine for this object
 bool	AWeapon::checkCollisionWithWalls()
 {
-	std::list<std::pair<eventType, s_event> >::const_iterator it;
+	t_eventList	*events = Event::getEventByType(ev_WALL_COLLISION);
 
-	for (it = Event::getMainEventList()->begin(); it != Event::getMainEventList()->end(); ++it)
+	if (events == NULL)
+		return false;
+	for (t_eventList::const_iterator it = events->begin(); it != events->end(); ++it)
 	{
-		if (it->first == ev_WALL_COLLISION && it->second.trigger.get() == this)
+		if (it->second.trigger.get() == this)
 			return true;
 	}
 	return false;
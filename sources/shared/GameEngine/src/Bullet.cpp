@@ -22,6 +22,26 @@ extern t_config *G_conf;
 extern bool	G_isServer;
 extern bool	G_isOffline;
 
+// Candidates from the object grid, reused by every bullet of the thread
+// (matches are ticked by several threads, allocated once per thread)
+static VC_THREAD_LOCAL std::vector<const std::shared_ptr<AObject> *>	*nearObjectsTls = NULL;
+// Players where the shooter saw them, reused too
+static VC_THREAD_LOCAL std::vector<t_hitbox>	*hitboxesTls = NULL;
+
+static std::vector<const std::shared_ptr<AObject> *>	&nearObjects()
+{
+	if (nearObjectsTls == NULL)
+		nearObjectsTls = new std::vector<const std::shared_ptr<AObject> *>;
+	return *nearObjectsTls;
+}
+
+static std::vector<t_hitbox>	&hitboxes()
+{
+	if (hitboxesTls == NULL)
+		hitboxesTls = new std::vector<t_hitbox>;
+	return *hitboxesTls;
+}
+
 Bullet::Bullet() :
 AWeapon(BULLET, 0, 0, 0, 0)
 {
@@ -67,63 +87,78 @@ bool	Bullet::update()
 
 bool	Bullet::checkHitPlayers()
 {
-	auto	it = S_Map->getPlayers()->begin();
-	auto	end = S_Map->getPlayers()->end();
-	float	coef;
-
-	while (it != end)
+	// Fired by a lagging player: the others where he saw them, himself
+	// where he is (see HitboxHistory)
+	sf::Time	time;
+	if (_makerType == NONE &&
+		S_Map->getHitboxHistory()->getRewindTime(_owner, S_Map->getClock().getElapsedTime(), time))
 	{
-		std::shared_ptr<Player>player = std::dynamic_pointer_cast<Player>(*it);
-		if (player->getTeam() != 0 && !player->isRespawning())
+		S_Map->getHitboxHistory()->query(time, getX(), getY(), _radius, hitboxes());
+		for (std::vector<t_hitbox>::const_iterator it = hitboxes().begin(); it != hitboxes().end(); ++it)
 		{
-			coef = 100;
-			if (player == _owner)
-				coef = G_conf->game->friendly_fire_own;
-			else if (S_Map->getMode()->getProperty()->team &&
-				player->getTeam() == (_owner)->getTeam())
-				coef = G_conf->game->friendly_fire_team;
-			if (isInsideHitbox(player->getX(), player->getY(),
-				player->getRadius() + _radius) == true)
-			{
-				if (coef > 0)
-				{
-					if (G_isServer || G_isOffline)
-					{
-						// drain energy
-						if (_property->drain_energy)
-							player->setEnergy(player->getEnergy() - _property->drain_energy);
-						// drain energy
-						if (_property->pushback_other)
-						{
-							float diffX = _property->pushback_other * ((*it)->getX() - getX()) / 100;
-							float diffY = _property->pushback_other * ((*it)->getY() - getY()) / 100;
-							player->setDirX(diffX);
-							player->setDirY(diffY);
-
-							player->setDirX(diffX);
-							player->setDirY(diffY);
-						}
-
-						player->isHitBy(std::dynamic_pointer_cast<AWeapon>(shared_from_this()), coef * _property->damage / 100);
-						return (true);
-					}
-				}
-			}
+			std::shared_ptr<Player>	player = std::dynamic_pointer_cast<Player>(S_Map->findObjectWithID(it->id));
+			if (player && player != _owner && hitPlayer(player))
+				return (true);
 		}
+		return (isInsideHitbox(_owner->getX(), _owner->getY(), _owner->getRadius() + _radius) &&
+			hitPlayer(_owner));
+	}
+
+	S_Map->getObjectGrid()->query(getX(), getY(), _radius, OBJ_MASK(PLAYER), nearObjects());
+	auto	it = nearObjects().begin();
+	auto	end = nearObjects().end();
+	while (it != end)
+	{
+		std::shared_ptr<Player>player = std::dynamic_pointer_cast<Player>(*(*it));
+		if (isInsideHitbox(player->getX(), player->getY(), player->getRadius() + _radius) == true &&
+			hitPlayer(player))
+			return (true);
 		++it;
 	}
 	return (false);
 }
 
-bool	Bullet::checkHitBots()
+// Player in the hitbox, false if the bullet goes through
+bool	Bullet::hitPlayer(const std::shared_ptr<Player> &player)
 {
-	auto	it = S_Map->getBots()->begin();
-	auto	end = S_Map->getBots()->end();
+	float	coef;
+
+	if (player->getTeam() == 0 || player->isRespawning())
+		return (false);
+	coef = 100;
+	if (player == _owner)
+		coef = G_conf->game->friendly_fire_own;
+	else if (S_Map->getMode()->getProperty()->team &&
+		player->getTeam() == (_owner)->getTeam())
+		coef = G_conf->game->friendly_fire_team;
+	if (coef <= 0 || !(G_isServer || G_isOffline))
+		return (false);
 
+	// drain energy
+	if (_property->drain_energy)
+		player->setEnergy(player->getEnergy() - _property->drain_energy);
+	// drain energy
+	if (_property->pushback_other)
+	{
+		float diffX = _property->pushback_other * (player->getX() - getX()) / 100;
+		float diffY = _property->pushback_other * (player->getY() - getY()) / 100;
+		player->setDirX(diffX);
+		player->setDirY(diffY);
+	}
+
+	player->isHitBy(std::dynamic_pointer_cast<AWeapon>(shared_from_this()), coef * _property->damage / 100);
+	return (true);
+}
+
+bool	Bullet::checkHitBots()
+{
+	S_Map->getObjectGrid()->query(getX(), getY(), _radius, OBJ_MASK(BOT), nearObjects());
+	auto	it = nearObjects().begin();
+	auto	end = nearObjects().end();
 	while (it != end)
 	{
-		Bot *bot = (*it).get();
-		if (isInsideHitbox((*it)->getX(), (*it)->getY(), _radius + bot->getRadius()))
+		Bot *bot = static_cast<Bot *>((*it)->get());
+		if (isInsideHitbox(bot->getX(), bot->getY(), _radius + bot->getRadius()))
 		{
 			ADD_EVENT(ev_DELETE, s_event(shared_from_this()));
 			bot->isHitBy(std::dynamic_pointer_cast<AWeapon>(shared_from_this()), _property->damage);
@@ -136,13 +171,13 @@ bool	Bullet::checkHitBots()
 
 bool	Bullet::checkHitTurrets()
 {
-	auto	it = S_Map->getTurrets()->begin();
-	auto	end = S_Map->getTurrets()->end();
-
+	S_Map->getObjectGrid()->query(getX(), getY(), _radius, OBJ_MASK(TURRET), nearObjects());
+	auto	it = nearObjects().begin();
+	auto	end = nearObjects().end();
 	while (it != end)
 	{
-		Turret *turret = (*it).get();
-		if (isInsideHitbox((*it)->getX(), (*it)->getY(), _radius + turret->getRadius() * 2))
+		Turret *turret = static_cast<Turret *>((*it)->get());
+		if (isInsideHitbox(turret->getX(), turret->getY(), _radius + turret->getRadius() * 2))
 		{
 			int coef = 100;
 			if (turret->getOwner() == _owner)
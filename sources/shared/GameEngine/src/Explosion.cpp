@@ -10,6 +10,7 @@
 
 #include	<iostream>
 #include	<cmath>
+#include	<algorithm>
 #include	"Explosion.hpp"
 #include	"Map.hpp"
 #include	"Defines.h"
@@ -20,6 +21,16 @@ extern t_config *G_conf;
 extern bool	G_isServer;
 extern bool	G_isOffline;
 
+// Walls candidates for checkSegmentSegment, one per thread
+static VC_THREAD_LOCAL std::vector<unsigned int>	*nearWallsTls = NULL;
+
+static std::vector<unsigned int>	&nearWalls()
+{
+	if (nearWallsTls == NULL)
+		nearWallsTls = new std::vector<unsigned int>;
+	return *nearWallsTls;
+}
+
 Explosion::Explosion()
 {
 	_owner = NULL;
@@ -53,74 +64,59 @@ bool	Explosion::update()
 
 void	Explosion::onStart()
 {
-	auto	it = S_Map->getElems()->begin();
-	auto	end = S_Map->getElems()->end();
+	// Not shared, a chain explosion queries again while we loop
+	std::vector<const std::shared_ptr<AObject> *>	nearObjects;
+	std::vector<t_hitbox>	hitboxes;
 	int	coef;
 
+	// Bomb of a lagging player: the others where he saw them (see HitboxHistory)
+	sf::Time	time;
+	bool	rewind = _makerType == BOMB &&
+		S_Map->getHitboxHistory()->getRewindTime(_owner, S_Map->getClock().getElapsedTime(), time);
+
 	double distance;
 	ADD_EVENT(ev_EXPLOSION, s_event(shared_from_this()));
+	S_Map->getObjectGrid()->query(getX(), getY(), _property->size_explosion, OBJ_MASK_ALL, nearObjects);
+	auto	it = nearObjects.begin();
+	auto	end = nearObjects.end();
 	while (it != end)
 	{
+		const std::shared_ptr<AObject>	&obj = *(*it);
+
+		// Done after, at their rewound position
+		if (rewind && obj->getType() == PLAYER && obj != _owner)
+		{
+			++it;
+			continue;
+		}
+
 		// Checking if AObject is in range of bomb
-		if ((distance = std::pow(getX() - (*it)->getX(), 2.0f) + std::pow(getY() - (*it)->getY(), 2.0f))
+		if ((distance = std::pow(getX() - obj->getX(), 2.0f) + std::pow(getY() - obj->getY(), 2.0f))
 			< std::pow(_property->size_explosion, 2.0f))
 		{
 			// Check if no wall between explo and AObject
-			if (checkSegmentSegment(*it) == false)
+			if (checkSegmentSegment(obj->getX(), obj->getY()) == false)
 			{
 				// Do damage
 				distance = sqrt(distance);
 				float	proximity = _property->size_explosion - distance;
-				if ((*it)->getType() == BULLET)
-					ADD_EVENT(ev_DELETE, s_event(*it));
+				if (obj->getType() == BULLET)
+					ADD_EVENT(ev_DELETE, s_event(obj));
 				// Bomb chain explo
-				if ((*it)->getType() == BOMB && (bool)_property->chain == true)
+				if (obj->getType() == BOMB && (bool)_property->chain == true)
 				{
-					std::shared_ptr<Bomb>bomb = std::dynamic_pointer_cast<Bomb>(*it);
+					std::shared_ptr<Bomb>bomb = std::dynamic_pointer_cast<Bomb>(obj);
 					if (bomb->isActive() && bomb->getOwner() && bomb->getOwner()->getBombOnHold() != bomb)
 					{
 						bomb->explode();
-						ADD_EVENT(ev_DELETE, *it);
+						ADD_EVENT(ev_DELETE, obj);
 					}
 				}
-				if ((*it)->getType() == PLAYER)
+				if (obj->getType() == PLAYER)
+					hitPlayer(std::dynamic_pointer_cast<Player>(obj), obj->getX(), obj->getY(), proximity);
+				if (obj->getType() == TURRET)
 				{
-					std::shared_ptr<Player>player = std::dynamic_pointer_cast<Player>(*it);
-					if (player->getTeam() != 0 && !player->isRespawning())
-					{
-						coef = 100;
-						if (player == _owner)
-							coef = G_conf->game->friendly_fire_own;
-						else if (S_Map->getMode()->getProperty()->team &&
-							player->getTeam() == (_owner)->getTeam())
-							coef = G_conf->game->friendly_fire_team;
-
-						// Apply effects
-						int damage = (proximity / _property->size_explosion) * _property->damage * coef / 100;
-						if (coef > 0)
-						{
-							float	factor = sqrt(std::pow((*it)->getX() - getX(), 2.0f) + std::pow((*it)->getY() - getY(), 2.0f)) + 1;
-							float	diffX = ((*it)->getX() - getX()) / factor;
-							float	diffY = ((*it)->getY() - getY()) / factor;
-
-							diffX = diffX * _property->pushback_other * proximity / _property->size_explosion;
-							diffY = diffY * _property->pushback_other * proximity / _property->size_explosion;
-
-							player->setDirX((*it)->getDirX() + diffX);
-							player->setDirY((*it)->getDirY() + diffY);
-
-							// EMP
-							if (_property->drain_energy)
-								player->setEnergy(player->getEnergy() - _property->drain_energy);
-
-							// DAMAGE
-							player->isHitBy(std::dynamic_pointer_cast<AWeapon>(shared_from_this()), damage);
-						}
-					}
-				}
-				if ((*it)->getType() == TURRET)
-				{
-					std::shared_ptr<Turret>turret = std::dynamic_pointer_cast<Turret>(*it);
+					std::shared_ptr<Turret>turret = std::dynamic_pointer_cast<Turret>(obj);
 					coef = 100;
 					if (turret->getOwner() == _owner)
 						coef = G_conf->game->friendly_fire_own;
@@ -136,9 +132,9 @@ void	Explosion::onStart()
 						turret->isHitBy(this, damage);
 					}
 				}
-				if ((*it)->getType() == BOT)
+				if (obj->getType() == BOT)
 				{
-					std::shared_ptr<Bot>bot = std::dynamic_pointer_cast<Bot>(*it);
+					std::shared_ptr<Bot>bot = std::dynamic_pointer_cast<Bot>(obj);
 
 					// Apply effects
 					int damage = (proximity / _property->size_explosion) * _property->damage;
@@ -156,10 +152,60 @@ void	Explosion::onStart()
 		}
 		++it;
 	}
+
+	if (!rewind)
+		return;
+	S_Map->getHitboxHistory()->query(time, getX(), getY(), _property->size_explosion, hitboxes);
+	for (std::vector<t_hitbox>::const_iterator hitbox = hitboxes.begin(); hitbox != hitboxes.end(); ++hitbox)
+	{
+		std::shared_ptr<Player>	player = std::dynamic_pointer_cast<Player>(S_Map->findObjectWithID(hitbox->id));
+
+		distance = sqrt(std::pow(getX() - hitbox->x, 2.0f) + std::pow(getY() - hitbox->y, 2.0f));
+		if (player && player != _owner && distance < _property->size_explosion &&
+			checkSegmentSegment(hitbox->x, hitbox->y) == false)
+			hitPlayer(player, hitbox->x, hitbox->y, _property->size_explosion - distance);
+	}
+}
+
+// Player at (x, y) in range
+void	Explosion::hitPlayer(const std::shared_ptr<Player> &player, float x, float y, float proximity)
+{
+	int	coef;
+
+	if (player->getTeam() == 0 || player->isRespawning())
+		return;
+	coef = 100;
+	if (player == _owner)
+		coef = G_conf->game->friendly_fire_own;
+	else if (S_Map->getMode()->getProperty()->team &&
+		player->getTeam() == (_owner)->getTeam())
+		coef = G_conf->game->friendly_fire_team;
+
+	// Apply effects
+	int damage = (proximity / _property->size_explosion) * _property->damage * coef / 100;
+	if (coef > 0)
+	{
+		float	factor = sqrt(std::pow(x - getX(), 2.0f) + std::pow(y - getY(), 2.0f)) + 1;
+		float	diffX = (x - getX()) / factor;
+		float	diffY = (y - getY()) / factor;
+
+		diffX = diffX * _property->pushback_other * proximity / _property->size_explosion;
+		diffY = diffY * _property->pushback_other * proximity / _property->size_explosion;
+
+		player->setDirX(player->getDirX() + diffX);
+		player->setDirY(player->getDirY() + diffY);
+
+		// EMP
+		if (_property->drain_energy)
+			player->setEnergy(player->getEnergy() - _property->drain_energy);
+
+		// DAMAGE
+		player->isHitBy(std::dynamic_pointer_cast<AWeapon>(shared_from_this()), damage);
+	}
 }
 
 // Check if collision with walls
-bool	Explosion::checkSegmentSegment(std::shared_ptr<AObject>nmy)
+bool	Explosion::checkSegmentSegment(float x, float y)
 {
 	Point A;
 	Point B;
@@ -168,17 +214,23 @@ bool	Explosion::checkSegmentSegment(std::shared_ptr<AObject>nmy)
 
 	O.x = _pos.first;
 	O.y = _pos.second;
-	P.x = nmy->getX();
-	P.y = nmy->getY();
+	P.x = x;
+	P.y = y;
+
+	// Only walls around the segment
+	WallGrid	*grid = S_Map->getWallGrid();
+	grid->query(std::min(O.x, P.x), std::min(O.y, P.y),
+		std::max(O.x, P.x), std::max(O.y, P.y), nearWalls());
 
-	auto	it = S_Map->getWalls()->begin();
-	auto	end = S_Map->getWalls()->end();
+	auto	it = nearWalls().begin();
+	auto	end = nearWalls().end();
 	while (it != end)
 	{
-		A.x = (*it)->getX();
-		B.x = (*it)->getEndX();
-		A.y = (*it)->getY();
-		B.y = (*it)->getEndY();
+		const std::shared_ptr<Wall>	&wall = grid->getWall(*it);
+		A.x = wall->getX();
+		B.x = wall->getEndX();
+		A.y = wall->getY();
+		B.y = wall->getEndY();
 
 		if (CollisionSegSeg(A, B, O, P))
 			return true;
@@ -105,9 +105,9 @@ bool	Flag::checkIfOwnerDisconnected()
 	{
 		if (Event::getEventByType(ev_DELETE))
 		{
-			std::list<std::pair<eventType, s_event> >*	events = Event::getEventByType(ev_DELETE);
-			std::list<std::pair<eventType, s_event> >::const_iterator it = events->begin();
-			std::list<std::pair<eventType, s_event> >::const_iterator end = events->end();
+			t_eventList*	events = Event::getEventByType(ev_DELETE);
+			t_eventList::const_iterator it = events->begin();
+			t_eventList::const_iterator end = events->end();
 			while (it != end)
 			{
 				if ((*it).second.trigger == _owner)
@@ -39,8 +39,11 @@ void	GameEngine::start(void)
 	if (!(G_isServer || G_isOffline)) // Do not load map when online client as it will be received from server
 		return;
 
-	//// Load config
-	S_Map->loadConfig(G_configPath + "config.json");
+	//// Load config, the matches of a server share the first one
+	if (!G_isServer || G_conf == NULL)
+		S_Map->loadConfig(G_configPath + "config.json");
+	else
+		S_Map->setZoom(G_conf->game->zoom);
 
 	VC_INFO_CRITICAL("Map: " + G_conf->game->map);
 	VC_INFO_CRITICAL("Mode : " + G_conf->game->mode);
@@ -22,6 +22,16 @@ extern t_config *G_conf;
 extern int sizeX;
 extern int sizeY;
 
+// Candidates from the object grid, reused by every field of the thread
+static VC_THREAD_LOCAL std::vector<const std::shared_ptr<AObject> *>	*nearObjectsTls = NULL;
+
+static std::vector<const std::shared_ptr<AObject> *>	&nearObjects()
+{
+	if (nearObjectsTls == NULL)
+		nearObjectsTls = new std::vector<const std::shared_ptr<AObject> *>;
+	return *nearObjectsTls;
+}
+
 GravityField::GravityField(float X, float Y,
 	float dirX, float dirY, const std::shared_ptr<Player> &owner) :
 	AWeapon(GRAVITY_FIELD, X, Y, dirX, dirY)
@@ -71,20 +81,20 @@ bool	GravityField::update()
 // Check each frame effect (pushback)
 void	GravityField::checkUpdateEffects()
 {
-	std::list<std::shared_ptr<AObject>>::iterator	it = S_Map->getElems()->begin();
-	std::list<std::shared_ptr<AObject>>::iterator	end = S_Map->getElems()->end();
+	S_Map->getObjectGrid()->query(getX(), getY(), _radius,
+		OBJ_MASK(PLAYER) | OBJ_MASK(BOT) | OBJ_MASK(BULLET) | OBJ_MASK(BOMB) | OBJ_MASK(ROCKET) | OBJ_MASK(TURRET),
+		nearObjects());
+	auto	it = nearObjects().begin();
+	auto	end = nearObjects().end();
 
 	float distance;
 	while (it != end)
 	{
-		const eObjectType &type = (*it)->getType();
+		AObject	*obj = (*it)->get();
 		// Checking if AObject is in range of gravity field
-		if (type == PLAYER || type == BOT || type == BULLET || type == BOMB || type == ROCKET || type == TURRET)
-		{
-			if ((distance = sqrt(std::pow(getX() - (*it)->getX(), 2.0f) + std::pow(getY() - (*it)->getY(), 2.0f)))
-				< _radius + (*it)->getRadius())
-				applyUpdateEffects(distance, (*it).get());
-		}
+		if ((distance = sqrt(std::pow(getX() - obj->getX(), 2.0f) + std::pow(getY() - obj->getY(), 2.0f)))
+			< _radius + obj->getRadius())
+			applyUpdateEffects(distance, obj);
 		++it;
 	}
 }
@@ -149,21 +159,19 @@ void	GravityField::applyUpdateEffects(float distance, AObject *obj)
 
 void	GravityField::checkFrameActivityEffects()
 {
-	auto	it = S_Map->getElems()->begin();
-	auto	end = S_Map->getElems()->end();
 	_lastActivityCheck = _clock.getElapsedTime();
+	S_Map->getObjectGrid()->query(getX(), getY(), _radius, OBJ_MASK(PLAYER) | OBJ_MASK(BOT), nearObjects());
+	auto	it = nearObjects().begin();
+	auto	end = nearObjects().end();
 
 	float distance;
 	while (it != end)
 	{
-		const eObjectType &type = (*it)->getType();
+		AObject	*obj = (*it)->get();
 		// Checking if AObject is in range of gravity field
-		if (type == PLAYER || type == BOT)
-		{
-			if ((distance = sqrt(std::pow(getX() - (*it)->getX(), 2.0f) + std::pow(getY() - (*it)->getY(), 2.0f)))
-				< _radius + (*it)->getRadius())
-				applyFrameActivityEffects(distance, (*it).get());
-		}
+		if ((distance = sqrt(std::pow(getX() - obj->getX(), 2.0f) + std::pow(getY() - obj->getY(), 2.0f)))
+			< _radius + obj->getRadius())
+			applyFrameActivityEffects(distance, obj);
 		++it;
 	}
 }
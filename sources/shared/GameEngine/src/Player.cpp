@@ -11,6 +11,7 @@
 #include	<sstream>
 #include	<cstring>
 #include	<cmath>
+#include	<algorithm>
 #include	"Player.hpp"
 #include	"Wall.hpp"
 #include	"Bullet.hpp"
@@ -25,6 +26,7 @@
 #include	"Event.hpp"
 #include	"Log.hpp"
 #include	"AI.hpp"
+#include	"Snapshot.hpp"
 
 extern bool	G_isServer;
 extern bool	G_isOffline;
@@ -158,9 +160,9 @@ void	Player::gatherInput()
 {
 	if (Event::getEventByType(ev_PLAYER_ACTION))
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it =
+		t_eventList::const_iterator it =
 			Event::getEventByType(ev_PLAYER_ACTION)->begin();
-		std::list<std::pair<eventType, s_event> >::const_iterator end =
+		t_eventList::const_iterator end =
 			Event::getEventByType(ev_PLAYER_ACTION)->end();
 
 		while (it != end)
@@ -371,6 +373,20 @@ bool	Player::isInsideRespawn()
 	return _insideRespawn;
 }
 
+///////////////////////////////////////////////
+/////   Replay an input already applied once (client prediction)
+/////	Only the movement, the physic step is done by the caller
+
+void	Player::predictMove(const s_actions &actions, const sf::Time &deltaTime)
+{
+	float	coefDeltaTime = _coefDeltaTime;
+
+	_actions = actions;
+	_coefDeltaTime = deltaTime.asMicroseconds() / 20000.0f;
+	checkMove();
+	_coefDeltaTime = coefDeltaTime;
+}
+
 bool	Player::maxSpeedReached(float maxSpeed, float projX, float projY)
 {
 	if (std::pow(projX, 2.0f) + std::pow(projY, 2.0f) >= std::pow(maxSpeed, 2.0f))
@@ -779,4 +795,29 @@ void		Player::deleteBombOnHold(void)
 void		Player::setBombOnHold(const std::shared_ptr<Bomb>	&bomb)
 {
 	_weaponManager->setBombOnHold(bomb);
-}
\ No newline at end of file
+}
+
+///////////////////////////////////////////////
+/////   Quantized player state used in snapshots
+
+void	capturePlayerState(s_playerState &state, const Player &m)
+{
+	state.id = m.getId();
+	state.team = m.getTeam();
+	state.x = quantizePosition(m.getX());
+	state.y = quantizePosition(m.getY());
+	quantizeDirection(m.getDirX(), m.getDirY(), state.dirAngle, state.dirSpeed);
+	state.aimX = quantizeAim(m.getAim().first, state.x);
+	state.aimY = quantizeAim(m.getAim().second, state.y);
+	state.shieldIndex = -1;
+	if (m.getShield())
+		state.shieldIndex = m.getShield()->getWeaponIndex();
+	state.energy = quantizeEnergy(m.getEnergy());
+	state.life = m.getLife();
+	state.kills = m.getKills();
+	state.deaths = m.getDeaths();
+	state.score = m.getScore();
+	// Player latency is in micro sec, the snapshot carries ms
+	state.latency = static_cast<sf::Uint16>(std::min(std::max(m.getLatency() / 1000.f, 0.f), 65535.f));
+	state.invul = m.isInvulnerable();
+}
@@ -296,8 +296,8 @@ void	WeaponManager::fireTurret(t_weapon *weaponCfg, bool primary)
 	if (weaponCfg->capacity)
 	{
 		// Delete previous turret
-		std::list<std::shared_ptr<AObject>>::reverse_iterator	it = S_Map->getElems()->rbegin();
-		std::list<std::shared_ptr<AObject>>::reverse_iterator	end = S_Map->getElems()->rend();
+		EntityStore<AObject>::reverse_iterator	it = S_Map->getElems()->rbegin();
+		EntityStore<AObject>::reverse_iterator	end = S_Map->getElems()->rend();
 		int	nbOfTurret = 0;
 		while (it != end)
 		{
@@ -380,8 +380,8 @@ void	WeaponManager::fireGravity(t_weapon *weaponCfg, bool primary)
 	if (weaponCfg->capacity)
 	{
 		// Delete previous Gravity
-		std::list<std::shared_ptr<AObject>>::reverse_iterator	it = S_Map->getElems()->rbegin();
-		std::list<std::shared_ptr<AObject>>::reverse_iterator	end = S_Map->getElems()->rend();
+		EntityStore<AObject>::reverse_iterator	it = S_Map->getElems()->rbegin();
+		EntityStore<AObject>::reverse_iterator	end = S_Map->getElems()->rend();
 		int	nbOfGrav = 0;
 		while (it != end)
 		{
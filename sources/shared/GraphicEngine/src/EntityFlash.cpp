@@ -96,13 +96,14 @@ namespace VoidClashGraphics
 			_lifetime = 0.5f;
 			_initialSize = 1000.0f;
 
-			t_impact *impact = (t_impact*)_event->second.data;
-			if (impact == NULL)
+			// Raised by AObject without an impact
+			const t_impact &impact = _event->second.impact;
+			if (impact.wall == NULL)
 			{
 				_good = false;
 				return;
 			}
-			_position = glm::vec3(impact->pos.first, -impact->pos.second, Z_FLASH);
+			_position = glm::vec3(impact.pos.first, -impact.pos.second, Z_FLASH);
 		}
 
 		// Everything is fine
@@ -5,13 +5,23 @@
 #include "json.hpp"
 #include "Parser.hpp"
 
+// Default t_server::central_server
+#define CENTRAL_SERVER_URL "http://voidclashserver.azurewebsites.net"
+
 typedef struct	s_server
 {
 	std::string name;
 	std::string password;
 	int			tickrate;
-	int			max_player;
+	int			snapshot_rate;		// Snapshots / sec sent to each client (at most tickrate)
+	int			client_bandwidth;	// Bytes / sec sent to each client, 0 = unlimited
+	int			mtu;				// Max bytes of a datagram, bigger packets are fragmented
+	int			interpolation_delay;	// ms remote players are shown in the past, 0 = 3 snapshots
+	int			max_player;			// Per match
 	int			min_player;
+	int			matches;			// Games hosted by the server process, on the same port
+	int			metrics_port;		// Local TCP port of the metrics (+ instance, as the game port), 0 = none
+	std::string	central_server;		// URL of the server list, "" = not listed
 }		t_server;
 
 typedef struct	s_game
@@ -53,8 +53,21 @@ void *ConfigParser::parse()
 	conf->server->name = server.get("name", "").asString();
 	conf->server->password = server.get("password", "").asString();
 	conf->server->tickrate = server.get("tickrate", 128).asInt();
+	conf->server->snapshot_rate = server.get("snapshot_rate", 0).asInt();
+	if (conf->server->snapshot_rate <= 0 || conf->server->snapshot_rate > conf->server->tickrate)
+		conf->server->snapshot_rate = conf->server->tickrate;
+	conf->server->client_bandwidth = server.get("client_bandwidth", 0).asInt();
+	conf->server->mtu = server.get("mtu", 1200).asInt();
+	conf->server->interpolation_delay = server.get("interpolation_delay", 0).asInt();
+	if (conf->server->interpolation_delay <= 0 && conf->server->snapshot_rate > 0)
+		conf->server->interpolation_delay = 3000 / conf->server->snapshot_rate;
 	conf->server->max_player = server.get("max_player", 0).asInt();
 	conf->server->min_player = server.get("min_player", 0).asInt();
+	conf->server->matches = server.get("matches", 1).asInt();
+	if (conf->server->matches < 1)
+		conf->server->matches = 1;
+	conf->server->metrics_port = server.get("metrics_port", 0).asInt();
+	conf->server->central_server = server.get("central_server", CENTRAL_SERVER_URL).asString();
 
 	// Horde
 	conf->horde->respawnTime = horde.get("respawn_time", 0).asFloat();
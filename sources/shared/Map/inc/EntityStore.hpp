@@ -0,0 +1,164 @@
+//
+// EntityStore.hpp for Void Clash
+//
+
+#ifndef		ENTITYSTORE_HPP_
+# define	ENTITYSTORE_HPP_
+
+#include	<vector>
+#include	<memory>
+#include	<SFML/Config.hpp>
+
+#define	ENTITY_INVALID_INDEX	0xFFFFFFFF
+
+///////////////////////////////////////////////
+/////   Handle on an entity of a store
+/////	Generation changes each time the slot is freed, so an old
+/////	handle never points on the entity stored after it
+
+struct	EntityHandle
+{
+	EntityHandle() : index(ENTITY_INVALID_INDEX), generation(0) {}
+
+	bool	isValid() const { return index != ENTITY_INVALID_INDEX; }
+
+	sf::Uint32	index;
+	sf::Uint32	generation;
+};
+
+///////////////////////////////////////////////
+/////   Slot map
+/////	Entities are kept in a dense array, in insertion order
+/////	remove() leaves a NULL hole, compact() closes the holes keeping order
+/////	so iterators stay valid until compact() or insert()
+
+template <typename T>
+class	EntityStore
+{
+public:
+	typedef typename std::vector<std::shared_ptr<T>>::iterator					iterator;
+	typedef typename std::vector<std::shared_ptr<T>>::const_iterator			const_iterator;
+	typedef typename std::vector<std::shared_ptr<T>>::reverse_iterator			reverse_iterator;
+	typedef typename std::vector<std::shared_ptr<T>>::const_reverse_iterator	const_reverse_iterator;
+
+	EntityStore() : _holes(0) {}
+
+	EntityHandle	insert(const std::shared_ptr<T> &entity)
+	{
+		EntityHandle	handle;
+
+		if (_freeSlots.empty())
+		{
+			handle.index = _slots.size();
+			_slots.push_back(s_slot());
+		}
+		else
+		{
+			handle.index = _freeSlots.back();
+			_freeSlots.pop_back();
+		}
+		s_slot	&slot = _slots[handle.index];
+		slot.dense = _dense.size();
+		handle.generation = slot.generation;
+		_dense.push_back(entity);
+		_denseSlot.push_back(handle.index);
+		return handle;
+	}
+
+	bool	remove(const EntityHandle &handle)
+	{
+		if (!contains(handle))
+			return false;
+
+		s_slot	&slot = _slots[handle.index];
+		_dense[slot.dense].reset();
+		slot.dense = ENTITY_INVALID_INDEX;
+		++slot.generation;
+		_freeSlots.push_back(handle.index);
+		++_holes;
+		return true;
+	}
+
+	void	compact()
+	{
+		if (_holes == 0)
+			return;
+
+		unsigned int	last = 0;
+		for (unsigned int i = 0; i < _dense.size(); ++i)
+			if (_dense[i])
+			{
+				if (i != last)
+				{
+					_dense[last].swap(_dense[i]);
+					_denseSlot[last] = _denseSlot[i];
+				}
+				_slots[_denseSlot[last]].dense = last;
+				++last;
+			}
+		_dense.resize(last);
+		_denseSlot.resize(last);
+		_holes = 0;
+	}
+
+	void	clear()
+	{
+		for (unsigned int i = 0; i < _slots.size(); ++i)
+			if (_slots[i].dense != ENTITY_INVALID_INDEX)
+			{
+				_slots[i].dense = ENTITY_INVALID_INDEX;
+				++_slots[i].generation;
+				_freeSlots.push_back(i);
+			}
+		_dense.clear();
+		_denseSlot.clear();
+		_holes = 0;
+	}
+
+	bool	contains(const EntityHandle &handle) const
+	{
+		return handle.index < _slots.size() &&
+			_slots[handle.index].generation == handle.generation &&
+			_slots[handle.index].dense != ENTITY_INVALID_INDEX;
+	}
+
+	// NULL if the handle is not (or no more) in the store
+	const std::shared_ptr<T>	&get(const EntityHandle &handle) const
+	{
+		static const std::shared_ptr<T>	none;
+
+		if (!contains(handle))
+			return none;
+		return _dense[_slots[handle.index].dense];
+	}
+
+	// Iteration, removed entities are NULL until compact()
+	iterator				begin() { return _dense.begin(); }
+	iterator				end() { return _dense.end(); }
+	const_iterator			begin() const { return _dense.begin(); }
+	const_iterator			end() const { return _dense.end(); }
+	reverse_iterator		rbegin() { return _dense.rbegin(); }
+	reverse_iterator		rend() { return _dense.rend(); }
+	const_reverse_iterator	rbegin() const { return _dense.rbegin(); }
+	const_reverse_iterator	rend() const { return _dense.rend(); }
+
+	unsigned int	size() const { return _dense.size() - _holes; }
+	bool			empty() const { return size() == 0; }
+
+private:
+	struct	s_slot
+	{
+		s_slot() : dense(ENTITY_INVALID_INDEX), generation(0) {}
+
+		sf::Uint32	dense;		// Position in _dense
+		sf::Uint32	generation;
+	};
+
+	std::vector<std::shared_ptr<T>>	_dense;
+	std::vector<sf::Uint32>			_denseSlot;	// Slot of each dense entity
+	std::vector<s_slot>				_slots;
+	std::vector<sf::Uint32>			_freeSlots;
+	unsigned int					_holes;
+};
+
+#endif
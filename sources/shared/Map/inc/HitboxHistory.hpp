@@ -0,0 +1,69 @@
+//
+// HitboxHistory.hpp for Void Clash
+//
+
+#ifndef		HITBOXHISTORY_HPP_
+# define	HITBOXHISTORY_HPP_
+
+#include	<vector>
+#include	<memory>
+#include	<SFML/System.hpp>
+#include	"EntityStore.hpp"
+
+class	Player;
+
+#define	HITBOX_HISTORY_TICKS		32		// ticks kept, more than the max rewind at 64 ticks / sec
+#define	HITBOX_HISTORY_MAX_REWIND	0.25f	// in sec, shooters lagging more are only compensated this much
+
+// A player at a past time
+typedef struct	s_hitbox
+{
+	sf::Uint32	id;
+	float		x;
+	float		y;
+	float		radius;
+}				t_hitbox;
+
+///////////////////////////////////////////////
+/////   Lag compensation (server only)
+/////	The players are recorded each tick as they are sent in the
+/////	snapshot. A shooter aimed at the other players where his client
+/////	showed them: one round trip plus the interpolation delay ago.
+/////	Hits of his weapons are checked against them at this time.
+/////	Stored by array (ids / x / y / radius) and not by player,
+/////	a query only goes through the floats of two ticks
+
+class	HitboxHistory
+{
+public:
+	HitboxHistory();
+	~HitboxHistory();
+
+	// Once per tick, before the snapshot is sent
+	void	record(const EntityStore<Player> &players, sf::Time now);
+	void	clear();
+
+	// Time the shooter saw the other players at, false if not lagging (bot, local game)
+	bool	getRewindTime(const std::shared_ptr<Player> &shooter, sf::Time now, sf::Time &time) const;
+
+	// Fill result with the players within radius + their radius of (x, y)
+	// at this time (between the two ticks around it). result is cleared first
+	void	query(sf::Time time, float x, float y, float radius, std::vector<t_hitbox> &result) const;
+
+private:
+	void	resize(unsigned int stride);
+	int		findPlayer(unsigned int tick, sf::Uint32 id, unsigned int hint) const;
+
+	// Players of tick t are at [t * _stride, t * _stride + _sizes[t])
+	sf::Time		_times[HITBOX_HISTORY_TICKS];
+	unsigned int	_sizes[HITBOX_HISTORY_TICKS];
+	unsigned int	_last;		// Newest tick
+	unsigned int	_count;		// Ticks recorded
+	unsigned int	_stride;	// Max players per tick
+	std::vector<sf::Uint32>	_ids;
+	std::vector<float>		_x;
+	std::vector<float>		_y;
+	std::vector<float>		_radius;
+};
+
+#endif
@@ -12,11 +12,16 @@
 # define	__MAP_H__
 
 #include	<map>
+#include	<unordered_map>
 #include	<list>
 #include	<memory>
 #include	"AObject.hpp"
 #include	"Event.hpp"
 #include	"Wall.hpp"
+#include	"EntityStore.hpp"
+#include	"WallGrid.hpp"
+#include	"ObjectGrid.hpp"
+#include	"HitboxHistory.hpp"
 #include	"Turret.hpp"
 #include	"Player.hpp"
 #include	"Bot.hpp"
@@ -39,7 +44,9 @@ namespace	Map
 		MapUtils(void);
 		~MapUtils(void);
 
+		// One per thread, the server binds the one of the match it ticks
 		static MapUtils* getInstance(void);
+		static void setInstance(MapUtils *instance);
 
 		void	init();
 
@@ -69,11 +76,14 @@ namespace	Map
 		void	prevMap();
 		void	changeMap(const std::string &filename);
 
-		std::list<std::shared_ptr<AObject>>		*getElems();
-		std::list<std::shared_ptr<Player>>			*getPlayers();
-		std::list<std::shared_ptr<Wall>>			*getWalls();
-		std::list<std::shared_ptr<Bot>>			*getBots(void);
-		std::list<std::shared_ptr<Turret>>			*getTurrets();
+		EntityStore<AObject>		*getElems();
+		EntityStore<Player>			*getPlayers();
+		EntityStore<Wall>			*getWalls();
+		EntityStore<Bot>			*getBots(void);
+		EntityStore<Turret>			*getTurrets();
+		WallGrid							*getWallGrid(); // Rebuilt if walls changed
+		ObjectGrid							*getObjectGrid(); // Rebuilt after each physic update
+		HitboxHistory						*getHitboxHistory(); // Players of the last ticks (server)
 		Flag* getFlag(int team);
 		std::shared_ptr<AObject>			findObjectWithID(sf::Uint32 id);
 		std::shared_ptr<AObject>			findPlayerWithID(sf::Uint32 id);
@@ -87,7 +97,7 @@ namespace	Map
 
 		// Clock
 		const sf::Time& getDeltaTime(void) const;
-		const sf::Clock& getGlobalClock(void);
+		static const sf::Clock& getGlobalClock(void); // Same for all the maps, safe from any thread
 		const sf::Clock& getClock(void);
 
 		sf::Time getTime(); // return synced played time on the map
@@ -107,6 +117,7 @@ namespace	Map
 
 		// Remove dependency with GraphicEngine
 		void setFpsLimit(int limit);
+		void setFixedTimestep(sf::Time tick);
 
 		// Zoom
 		void setZoom(float zoom);
@@ -122,19 +133,29 @@ namespace	Map
 		void	followingAnotherPlayer(bool mustSwitch);
 		bool	wantSwitchPlayerFollowed();
 
-		static MapUtils		*_instance;
-		std::list<std::shared_ptr<AObject>>	*_elems;
-		std::list<std::shared_ptr<Player>>		*_players;
-		std::list<std::shared_ptr<Wall>>		*_walls;
-		std::list<std::shared_ptr<Bot>>		*_bots;
-		std::list<std::shared_ptr<Turret>>		*_turrets;
+		// Id lookup tables, follow addNewObjects / deleteObjects
+		void	indexObject(const std::shared_ptr<AObject> &obj);
+		void	unindexObject(const std::shared_ptr<AObject> &obj);
+
+		static VC_THREAD_LOCAL MapUtils	*_instance;
+		EntityStore<AObject>	*_elems;
+		EntityStore<Player>		*_players;
+		EntityStore<Wall>		*_walls;
+		EntityStore<Bot>		*_bots;
+		EntityStore<Turret>		*_turrets;
+		WallGrid			*_wallGrid;
+		ObjectGrid			*_objectGrid;
+		HitboxHistory		*_hitboxHistory;
+		std::unordered_map<sf::Uint32, std::shared_ptr<AObject>>	_objectsById; // Elems and walls
+		std::unordered_map<sf::Uint32, std::shared_ptr<Player>>	_playersById;
+		std::vector<Player *>	_deletedPlayers; // Used by deleteObjects
 		std::shared_ptr<Player>	_currentPlayer;
 		sf::Uint32			_currentPlayerId;
 		MapMode				*_mapMode;
 		std::string			_mapPath;
 
 		// Game clock
-		sf::Clock	_globalClock; // Relative to server creation time
+		static sf::Clock	_globalClock; // Relative to server creation time
 		sf::Clock	_clock; // Relative to map
 		sf::Time	_deltaTime;
 		sf::Time	_timePreviousFrame;
@@ -152,6 +173,7 @@ namespace	Map
 
 		// Fps Limit
 		int _fpsLimit;
+		sf::Time _fixedTimestep;
 		// Current Zoom
 		float _currentZoom;
 
@@ -162,9 +184,6 @@ namespace	Map
 	};
 }
 
-bool    sameAObject(std::pair<eventType, s_event> one, std::pair<eventType, s_event> two);
-bool    superiorAddr(std::pair<eventType, s_event> one, std::pair<eventType, s_event> two);
-
 #define S_Map Map::MapUtils::getInstance()
 
 #endif		/* !__EVENTTYPE_H__ */
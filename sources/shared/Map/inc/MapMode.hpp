@@ -56,6 +56,7 @@ public:
 	void	activeHorde();
 	void	desactiveHorde();
 	bool	isHordeActivated();
+	void	spawnBot();	// Horde spawns one every respawnTime, also used by bench_server
 
 	void		changeMapMode(eMapMode mode);
 	eMapMode	getModeEnum();
@@ -90,7 +91,6 @@ private:
 	bool	checkRoundVictory();
 
 	void	handleHorde();
-	void	spawnBot();
 	bool	entityInSpawnRange(Bot *bot);
 
 	void		clearRound();
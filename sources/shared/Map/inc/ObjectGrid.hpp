@@ -0,0 +1,65 @@
+//
+// ObjectGrid.hpp for Void Clash
+//
+
+#ifndef		OBJECTGRID_HPP_
+# define	OBJECTGRID_HPP_
+
+#include	<vector>
+#include	<memory>
+#include	"EntityStore.hpp"
+#include	"AObject.hpp"
+
+#define	OBJECT_GRID_CELL_SIZE	256		// in map unit
+#define	OBJECT_GRID_BUCKETS		4096	// MUST BE A POWER OF 2
+#define	OBJECT_GRID_NB_TYPES	(CAPTURE + 1)
+
+// Type filter for queries
+#define	OBJ_MASK(type)		(1 << (type))
+#define	OBJ_MASK_ALL		((1 << OBJECT_GRID_NB_TYPES) - 1)
+
+///////////////////////////////////////////////
+/////   Dynamic broadphase for objects (elems)
+/////	Spatial hash rebuilt each tick after the physic update
+/////	Valid until objects are added / deleted from the map
+
+class	ObjectGrid
+{
+public:
+	ObjectGrid();
+	~ObjectGrid();
+
+	void	build(const EntityStore<AObject> &elems);
+	void	clear();
+
+	// Fill result with objects of the masked types which may be within
+	// radius + 2 * their own radius of (x, y), in map order.
+	// result is cleared first. Callers still do the exact test.
+	void	query(float x, float y, float radius, int typeMask,
+		std::vector<const std::shared_ptr<AObject> *> &result) const;
+
+private:
+	struct	s_entry
+	{
+		const std::shared_ptr<AObject>	*object;
+		unsigned int	index;	// Position in elems
+		int				cellX;
+		int				cellY;
+		int				typeMask;
+	};
+
+	int				cell(float pos) const;
+	unsigned int	bucket(int cellX, int cellY) const;
+
+	// Bucket content is _entries[_bucketStart[bucket]] to _entries[_bucketStart[bucket + 1]]
+	std::vector<s_entry>		_entries;
+	std::vector<unsigned int>	_bucketStart;
+	int		_maxRadius[OBJECT_GRID_NB_TYPES];
+
+	// Kept between calls to avoid allocations
+	std::vector<s_entry>		_sorted;
+	std::vector<unsigned int>	_fill;
+	mutable std::vector<std::pair<unsigned int, const std::shared_ptr<AObject> *> >	_found;
+};
+
+#endif
@@ -0,0 +1,62 @@
+//
+// WallGrid.hpp for Void Clash
+//
+
+#ifndef		WALLGRID_HPP_
+# define	WALLGRID_HPP_
+
+#include	<vector>
+#include	<memory>
+#include	"EntityStore.hpp"
+#include	"Wall.hpp"
+
+#define	WALL_GRID_CELL_SIZE		256	// in map unit
+#define	WALL_GRID_MAX_CELLS		256	// per axis, cell size grows on huge maps
+
+///////////////////////////////////////////////
+/////   Static broadphase for walls
+/////	Uniform grid, each cell keeps the index of the walls
+/////	whose bounding box (+ wall radius) overlap it
+
+class	WallGrid
+{
+public:
+	WallGrid();
+	~WallGrid();
+
+	void	build(const EntityStore<Wall> &walls);
+	void	invalidate(); // Walls changed, rebuild at next use
+	bool	isDirty() const;
+
+	// Fill result with walls which may touch the box (result is cleared first)
+	void	query(float minX, float minY, float maxX, float maxY, std::vector<unsigned int> &result);
+
+	const std::shared_ptr<Wall>	&getWall(unsigned int index) const;
+	unsigned int	getNbWalls() const;
+	int				getMaxWallRadius() const;
+
+private:
+	int		cellX(float x) const;
+	int		cellY(float y) const;
+
+	bool	_dirty;
+
+	std::vector<std::shared_ptr<Wall>>	_walls;
+
+	// Cell content is _cellWalls[_cellStart[cell]] to _cellWalls[_cellStart[cell + 1]]
+	std::vector<unsigned int>	_cellStart;
+	std::vector<unsigned int>	_cellWalls;
+
+	// Walls spanning several cells are returned once
+	std::vector<unsigned int>	_queryMark;
+	unsigned int				_queryId;
+
+	float	_originX;
+	float	_originY;
+	float	_cellSize;
+	int		_width;
+	int		_height;
+	int		_maxWallRadius;
+};
+
+#endif
@@ -0,0 +1,149 @@
+//
+// HitboxHistory.cpp for Void Clash
+//
+
+#include	<algorithm>
+#include	"HitboxHistory.hpp"
+#include	"Player.hpp"
+#include	"ConfigParser.hpp"
+
+extern t_config *G_conf;
+extern bool	G_isServer;
+
+HitboxHistory::HitboxHistory()
+{
+	_stride = 0;
+	resize(32);
+}
+
+HitboxHistory::~HitboxHistory()
+{
+}
+
+void	HitboxHistory::clear()
+{
+	_last = 0;
+	_count = 0;
+}
+
+// History is lost, only when more players than ever join
+void	HitboxHistory::resize(unsigned int stride)
+{
+	_stride = stride;
+	_ids.resize(HITBOX_HISTORY_TICKS * _stride);
+	_x.resize(HITBOX_HISTORY_TICKS * _stride);
+	_y.resize(HITBOX_HISTORY_TICKS * _stride);
+	_radius.resize(HITBOX_HISTORY_TICKS * _stride);
+	clear();
+}
+
+///////////////////////////////////////////////
+/////   Record
+
+void	HitboxHistory::record(const EntityStore<Player> &players, sf::Time now)
+{
+	if (players.size() > _stride)
+		resize(std::max(players.size(), _stride * 2));
+
+	// Map clock restarted
+	if (_count > 0 && now < _times[_last])
+		clear();
+
+	unsigned int	tick = _count == 0 ? 0 : (_last + 1) % HITBOX_HISTORY_TICKS;
+	unsigned int	start = tick * _stride;
+	unsigned int	size = 0;
+
+	for (EntityStore<Player>::const_iterator it = players.begin(); it != players.end(); ++it)
+	{
+		// Removed this tick
+		if (!*it)
+			continue;
+
+		unsigned int	i = start + size++;
+
+		_ids[i] = (*it)->getId();
+		_x[i] = (*it)->getX();
+		_y[i] = (*it)->getY();
+		_radius[i] = (*it)->getRadius();
+	}
+	_times[tick] = now;
+	_sizes[tick] = size;
+	_last = tick;
+	if (_count < HITBOX_HISTORY_TICKS)
+		++_count;
+}
+
+///////////////////////////////////////////////
+/////   Rewind
+
+bool	HitboxHistory::getRewindTime(const std::shared_ptr<Player> &shooter, sf::Time now, sf::Time &time) const
+{
+	if (!G_isServer || !shooter || shooter->getLatency() <= 0 || _count == 0)
+		return false;
+
+	// Latency is the ping round trip in microseconds
+	float	rewind = shooter->getLatency() / 1000000.f + G_conf->server->interpolation_delay / 1000.f;
+
+	time = now - sf::seconds(std::min(rewind, HITBOX_HISTORY_MAX_REWIND));
+	return true;
+}
+
+// Players are in the same order from a tick to the next one, unless
+// one joined or left
+int		HitboxHistory::findPlayer(unsigned int tick, sf::Uint32 id, unsigned int hint) const
+{
+	unsigned int	start = tick * _stride;
+
+	if (hint < _sizes[tick] && _ids[start + hint] == id)
+		return hint;
+	for (unsigned int i = 0; i < _sizes[tick]; ++i)
+	{
+		if (_ids[start + i] == id)
+			return i;
+	}
+	return -1;
+}
+
+void	HitboxHistory::query(sf::Time time, float x, float y, float radius, std::vector<t_hitbox> &result) const
+{
+	result.clear();
+	if (_count == 0)
+		return;
+
+	// Last tick at or before this time (the oldest one if none), and the next one
+	unsigned int	before = _last;
+	for (unsigned int back = 1; back < _count && _times[before] > time; ++back)
+		before = (before + HITBOX_HISTORY_TICKS - 1) % HITBOX_HISTORY_TICKS;
+	bool			between = before != _last && _times[before] <= time;
+	unsigned int	after = (before + 1) % HITBOX_HISTORY_TICKS;
+	float			ratio = 0;
+	if (between)
+		ratio = (time - _times[before]).asSeconds() / (_times[after] - _times[before]).asSeconds();
+
+	unsigned int	start = before * _stride;
+	for (unsigned int i = 0; i < _sizes[before]; ++i)
+	{
+		t_hitbox	hitbox;
+
+		hitbox.id = _ids[start + i];
+		hitbox.x = _x[start + i];
+		hitbox.y = _y[start + i];
+		hitbox.radius = _radius[start + i];
+		if (between)
+		{
+			int	next = findPlayer(after, hitbox.id, i);
+
+			if (next != -1)
+			{
+				hitbox.x += (_x[after * _stride + next] - hitbox.x) * ratio;
+				hitbox.y += (_y[after * _stride + next] - hitbox.y) * ratio;
+			}
+		}
+
+		float	dx = hitbox.x - x;
+		float	dy = hitbox.y - y;
+		float	range = radius + hitbox.radius;
+		if (dx * dx + dy * dy < range * range)
+			result.push_back(hitbox);
+	}
+}
@@ -10,7 +10,9 @@
 
 
 #include	<cmath>
+#include	<algorithm>
 #include	<iostream>
+#include	<atomic>
 #include	"MapParser.hpp"
 #include	"Player.hpp"
 #include	"Wall.hpp"
@@ -30,7 +32,8 @@
 extern bool G_isOffline;
 extern bool G_isServer;
 extern t_config *G_conf;
-extern int G_id;
+extern sf::Uint32 G_confHash;
+extern std::atomic<int> G_id;
 extern std::string G_configPath;
 
 //////////////////////////////////////////////////////////////////////
@@ -39,30 +42,29 @@ extern std::string G_configPath;
 
 using namespace Map;
 
-MapUtils *MapUtils::_instance = NULL;
+VC_THREAD_LOCAL MapUtils *MapUtils::_instance = NULL;
+sf::Clock	MapUtils::_globalClock;
 
 MapUtils::MapUtils(void)
 {
-	_elems = new std::list < std::shared_ptr<AObject> > ;
-	_elems->clear();
-	_players = new std::list < std::shared_ptr<Player> > ;
-	_players->clear();
-	_walls = new std::list < std::shared_ptr<Wall> > ;
-	_walls->clear();
-	_turrets = new std::list < std::shared_ptr<Turret> > ;
-	_turrets->clear();
-	_bots = new std::list < std::shared_ptr<Bot> > ;
-	_bots->clear();
+	_elems = new EntityStore<AObject>;
+	_players = new EntityStore<Player>;
+	_walls = new EntityStore<Wall>;
+	_turrets = new EntityStore<Turret>;
+	_bots = new EntityStore<Bot>;
+	_wallGrid = new WallGrid;
+	_objectGrid = new ObjectGrid;
+	_hitboxHistory = new HitboxHistory;
 	_currentPlayer = NULL;
 	_currentPlayerId = 0;
 	_score = std::make_pair<int, int>(0, 0);
 	_clock.restart();
-	_globalClock.restart();
 	_playerFollowed = NULL;
 	_score.first = 0;
 	_score.second = 0;
 	_MapDatabase = new MapDatabase("maps");
 	_mapMode = new MapMode();
+	_fixedTimestep = sf::Time::Zero;
 
 	// Current zoom
 	_currentZoom = -1;
@@ -75,6 +77,9 @@ MapUtils::~MapUtils(void)
 	delete _walls;
 	delete _turrets;
 	delete _bots;
+	delete _wallGrid;
+	delete _objectGrid;
+	delete _hitboxHistory;
 	delete _MapDatabase;
 	delete _mapMode;
 }
@@ -86,6 +91,11 @@ MapUtils* MapUtils::getInstance(void)
 	return _instance;
 }
 
+void	MapUtils::setInstance(MapUtils *instance)
+{
+	MapUtils::_instance = instance;
+}
+
 void	MapUtils::init()
 {
 	// Timelimit
@@ -217,6 +227,7 @@ void	MapUtils::loadConfig(const std::string &filename)
 
 	if (parse->loadFile(filename.c_str()))
 		G_conf = (t_config *)parse->parse();
+	G_confHash = 0;
 	if (G_conf == NULL)
 		throw std::runtime_error("Unable to load conf file");
 	delete parse;
@@ -238,6 +249,9 @@ void	MapUtils::loadMap(const char *filename)
 	S_Map->initialState(buff);
 	delete parse;
 
+	// Walls of the new map are added with ev_START, grid is rebuilt on first query
+	_wallGrid->invalidate();
+
 	ADD_EVENT_SIMPLE(ev_MAP_LOADED);
 }
 
@@ -285,6 +299,7 @@ void	MapUtils::clearMap()
 	_warmup = true;
 	resetScore();
 	_clock.restart();
+	_hitboxHistory->clear();
 	_timePreviousFrame = _clock.getElapsedTime();
 	if (S_Map->getCurrentPlayer())
 		S_Map->getCurrentPlayer()->setMapTime(sf::Time::Zero);
@@ -338,109 +353,83 @@ void    MapUtils::deleteObjects(void)
 	if (Event::getEventByType(ev_DELETE) == NULL)
 		return;
 
-	// Sort and unique to remove possible duplicate of delete
-	if (Event::getEventByType(ev_DELETE) != NULL)
-	{
-		Event::getEventByType(ev_DELETE)->sort(superiorAddr);
-		Event::getEventByType(ev_DELETE)->unique(sameAObject);
-	}
-
 	bool	recurs = false;
-	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	t_eventList::const_iterator it =
 		Event::getEventByType(ev_DELETE)->begin();
-	std::list<std::pair<eventType, s_event> >::const_iterator end =
+	t_eventList::const_iterator end =
 		Event::getEventByType(ev_DELETE)->end();
 
+	_deletedPlayers.clear();
 	while (it != end)
 	{
-		if (it->second.trigger)
+		const std::shared_ptr<AObject>	&obj = it->second.trigger;
+
+		// Same object can be deleted several times in a frame
+		if (obj && obj->getType() != WALL && _elems->get(obj->getStoreHandle()) == obj)
 		{
-			// Elems found                                                                                    
-			auto found =
-				std::find(_elems->begin(), _elems->end(), it->second.trigger);
-			// Walls found 
-			auto foundWall =
-				std::find(_walls->begin(), _walls->end(), it->second.trigger);
-
-			if (found != _elems->end())
+			if (obj->getType() == BOMB)
 			{
-				if (it->second.trigger->getType() == BOMB)
-				{
-					Bomb *b = dynamic_cast<Bomb *>(it->second.trigger.get());
-					if (b->getOwner() && b->getOwner()->getBombOnHold().get() == b)
-						b->getOwner()->deleteBombOnHold();
-					b->setOwner(NULL);
-				}
-
-				// Need delete players from players list
-				if (it->second.trigger->getType() == PLAYER)
-				{
-					std::shared_ptr<Player>player = std::dynamic_pointer_cast<Player>(it->second.trigger);
-					if (player == S_Map->getPlayerFollowed())
-						S_Map->setPlayerFollowed(NULL);
-					if (player->getBombOnHold())
-						player->getBombOnHold()->setOwner(NULL);
-					player->deleteBombOnHold();
-					auto	itWeapon = _elems->begin();
-					auto	endWeapon = _elems->end();
-
-					// Clean all weapons associated with the player
-					while (itWeapon != endWeapon)
-					{
-						AWeapon *weapon = dynamic_cast<AWeapon *>((*itWeapon).get());
-						if (weapon)
-						{
-							if (weapon->getOwner() == player)
-							{
-								weapon->setOwner(NULL);
-								ADD_EVENT(ev_DELETE, s_event((*itWeapon)));
-								recurs = true;
-							}
-						}
-						++itWeapon;
-					}
-
-					auto foundP =
-						std::find(_players->begin(), _players->end(), it->second.trigger);
-					if (foundP != _players->end())
-						_players->erase(foundP);
-				}
-				// Need delete turrets for turrets list
-				if (it->second.trigger->getType() == TURRET)
-				{
-					auto foundP =
-						std::find(_turrets->begin(), _turrets->end(), it->second.trigger);
-					if (foundP != _turrets->end())
-						_turrets->erase(foundP);
-				}
-				// Need delete turrets for turrets list
-				if (it->second.trigger->getType() == BOT)
-				{
-					auto foundP =
-						std::find(_bots->begin(), _bots->end(), it->second.trigger);
-					if (foundP != _bots->end())
-						_bots->erase(foundP);
-				}
-				// delete from elems
-				std::shared_ptr<AObject>toto = it->second.trigger;
-				_elems->erase(found);
+				Bomb *b = dynamic_cast<Bomb *>(obj.get());
+				if (b->getOwner() && b->getOwner()->getBombOnHold().get() == b)
+					b->getOwner()->deleteBombOnHold();
+				b->setOwner(NULL);
 			}
 
-
-			else if (foundWall != _walls->end())
+			// Need delete players from players list
+			if (obj->getType() == PLAYER)
 			{
-				auto	wall = it->second.trigger;
-				auto itWall =
-					std::find(_walls->begin(), _walls->end(), wall);
-				if (itWall != _walls->end())
-				{
-					//delete (it->second.trigger);
-					_walls->erase(itWall);
-				}
+				std::shared_ptr<Player>player = std::dynamic_pointer_cast<Player>(obj);
+				if (player == S_Map->getPlayerFollowed())
+					S_Map->setPlayerFollowed(NULL);
+				if (player->getBombOnHold())
+					player->getBombOnHold()->setOwner(NULL);
+				player->deleteBombOnHold();
+				_deletedPlayers.push_back(player.get());
+				_players->remove(obj->getViewHandle());
 			}
+			unindexObject(obj);
+			// Need delete turrets / bots from their lists
+			if (obj->getType() == TURRET)
+				_turrets->remove(obj->getViewHandle());
+			if (obj->getType() == BOT)
+				_bots->remove(obj->getViewHandle());
+
+			// delete from elems
+			_elems->remove(obj->getStoreHandle());
+			obj->setStoreHandle(EntityHandle());
+			obj->setViewHandle(EntityHandle());
+			// Grid keeps pointers on elems, wait for next physic update
+			_objectGrid->clear();
+		}
+		else if (obj && obj->getType() == WALL && _walls->get(obj->getStoreHandle()) == obj)
+		{
+			_walls->remove(obj->getStoreHandle());
+			obj->setStoreHandle(EntityHandle());
+			_wallGrid->invalidate();
+			unindexObject(obj);
 		}
 		++it;
 	}
+
+	// Clean all weapons associated with deleted players, in one pass
+	if (!_deletedPlayers.empty())
+		for (auto itWeapon = _elems->begin(); itWeapon != _elems->end(); ++itWeapon)
+		{
+			AWeapon *weapon = dynamic_cast<AWeapon *>((*itWeapon).get());
+			if (weapon && weapon->getOwner() &&
+				std::find(_deletedPlayers.begin(), _deletedPlayers.end(), weapon->getOwner().get()) != _deletedPlayers.end())
+			{
+				weapon->setOwner(NULL);
+				ADD_EVENT(ev_DELETE, s_event((*itWeapon)));
+				recurs = true;
+			}
+		}
+
+	_elems->compact();
+	_players->compact();
+	_bots->compact();
+	_turrets->compact();
+	_walls->compact();
 	if (recurs)
 		deleteObjects();
 }
@@ -450,24 +439,33 @@ void	MapUtils::addNewObjects(void)
 	if (Event::getEventByType(ev_START) == NULL)
 		return;
 
-	std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(ev_START)->begin();
-	std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(ev_START)->end();
+	t_eventList::const_iterator it = Event::getEventByType(ev_START)->begin();
+	t_eventList::const_iterator end = Event::getEventByType(ev_START)->end();
 
 	while (it != end)
 	{
-		if (!checkIfDeleteEventForObj(it->second.trigger))
+		const std::shared_ptr<AObject>	&obj = it->second.trigger;
+
+		if (!checkIfDeleteEventForObj(obj))
 		{
-			if (it->second.trigger->getType() == WALL)
-				_walls->push_back(std::dynamic_pointer_cast<Wall>(it->second.trigger));
+			if (obj->getType() == WALL)
+			{
+				obj->setStoreHandle(_walls->insert(std::dynamic_pointer_cast<Wall>(obj)));
+				_wallGrid->invalidate();
+				indexObject(obj);
+			}
 			else
 			{
-				_elems->push_back(it->second.trigger);
-				if (it->second.trigger->getType() == TURRET)
-					_turrets->push_back(std::dynamic_pointer_cast<Turret>(it->second.trigger));
-				if (it->second.trigger->getType() == BOT)
-					_bots->push_back(std::dynamic_pointer_cast<Bot>(it->second.trigger));
-				if (it->second.trigger->getType() == PLAYER)
-					_players->push_back(std::dynamic_pointer_cast<Player>(it->second.trigger));
+				obj->setStoreHandle(_elems->insert(obj));
+				if (obj->getType() == TURRET)
+					obj->setViewHandle(_turrets->insert(std::dynamic_pointer_cast<Turret>(obj)));
+				if (obj->getType() == BOT)
+					obj->setViewHandle(_bots->insert(std::dynamic_pointer_cast<Bot>(obj)));
+				if (obj->getType() == PLAYER)
+					obj->setViewHandle(_players->insert(std::dynamic_pointer_cast<Player>(obj)));
+				indexObject(obj);
+				// Elems may have moved in memory
+				_objectGrid->clear();
 			}
 		}
 		++it;
@@ -480,8 +478,8 @@ bool	MapUtils::checkIfDeleteEventForObj(const std::shared_ptr<AObject> &obj)
 		return false;
 
 	// Check if delete event for this obj
-	std::list<std::pair<eventType, s_event> >::const_iterator it = Event::getEventByType(ev_DELETE)->begin();
-	std::list<std::pair<eventType, s_event> >::const_iterator end = Event::getEventByType(ev_DELETE)->end();
+	t_eventList::const_iterator it = Event::getEventByType(ev_DELETE)->begin();
+	t_eventList::const_iterator end = Event::getEventByType(ev_DELETE)->end();
 
 	while (it != end)
 	{
@@ -560,11 +558,20 @@ bool	MapUtils::update()
 	if (G_isOffline || G_isServer) // Not client as it's send by packet sync
 		_mapTime = _clock.getElapsedTime();
 
-	// Cap FPS
-	sf::Time maxSpeedFrame = sf::milliseconds(1000.0f / _fpsLimit);
-	sf::sleep(maxSpeedFrame - _deltaTime);
-	_deltaTime = _globalClock.getElapsedTime() - _timePreviousFrame;
-	_timePreviousFrame = _globalClock.getElapsedTime();
+	if (_fixedTimestep != sf::Time::Zero)
+	{
+		// Caller paces the loop, every frame simulates exactly one tick
+		_deltaTime = _fixedTimestep;
+		_timePreviousFrame = _globalClock.getElapsedTime();
+	}
+	else
+	{
+		// Cap FPS
+		sf::Time maxSpeedFrame = sf::milliseconds(1000.0f / _fpsLimit);
+		sf::sleep(maxSpeedFrame - _deltaTime);
+		_deltaTime = _globalClock.getElapsedTime() - _timePreviousFrame;
+		_timePreviousFrame = _globalClock.getElapsedTime();
+	}
 
 	// End of game - displaying result
 	if (_mapTime > _endOfMapTime + _warmupTime && !_displayScore)
@@ -694,9 +701,9 @@ bool	MapUtils::setPlayerFollowed()
 	//// Must switch player
 	//if (Event::getEventByType(ev_KILL) && S_Map->getMode()->getProperty()->respawnTime == -1)
 	//{
-	//	std::list<std::pair<eventType, s_event> >::const_iterator it =
+	//	t_eventList::const_iterator it =
 	//		Event::getEventByType(ev_KILL)->begin();
-	//	std::list<std::pair<eventType, s_event> >::const_iterator end =
+	//	t_eventList::const_iterator end =
 	//		Event::getEventByType(ev_KILL)->end();
 	//	while (it != end)
 	//	{
@@ -771,7 +778,7 @@ bool	MapUtils::wantSwitchPlayerFollowed()
 	// Switch player followed
 	if (Event::getEventByType(ev_PLAYER_ACTION) != NULL)
 	{
-		std::list<std::pair<eventType, s_event> >::const_iterator it =
+		t_eventList::const_iterator it =
 			Event::getEventByType(ev_PLAYER_ACTION)->begin();
 		s_actions *actions;
 		actions = (s_actions*)(it->second.data);
@@ -794,6 +801,12 @@ void MapUtils::setFpsLimit(int limit)
 	_fpsLimit = limit;
 }
 
+// Fixed delta time, update() does not sleep anymore (Zero to go back to FPS limit)
+void MapUtils::setFixedTimestep(sf::Time tick)
+{
+	_fixedTimestep = tick;
+}
+
 ///////////////////////////////////////////////
 /////   Utils
 
@@ -802,16 +815,10 @@ std::shared_ptr<AObject>		MapUtils::findPlayerWithID(sf::Uint32 id)
 	if (id == 0)
 		return NULL;
 
-	auto it = _players->begin();
-	auto end = _players->end();
-
-	while (it != end)
-	{
-		if ((*it)->getId() == id)
-			return (*it);
-		++it;
-	}
-	return NULL;
+	auto found = _playersById.find(id);
+	if (found == _playersById.end())
+		return NULL;
+	return found->second;
 }
 
 std::shared_ptr<AObject>		MapUtils::findObjectWithID(sf::Uint32 id)
@@ -819,28 +826,33 @@ std::shared_ptr<AObject>		MapUtils::findObjectWithID(sf::Uint32 id)
 	if (id == 0)
 		return NULL;
 
-	{
-		auto it = _elems->begin();
-		auto end = _elems->end();
+	auto found = _objectsById.find(id);
+	if (found == _objectsById.end())
+		return NULL;
+	return found->second;
+}
 
-		while (it != end)
-		{
-			if ((*it)->getId() == id)
-				return (*it);
-			++it;
-		}
-	}
+void	MapUtils::indexObject(const std::shared_ptr<AObject> &obj)
+{
+	// Objects created by the client have no id until the server gives one
+	if (obj->getId() == 0)
+		return;
 
-	auto it = _walls->begin();
-	auto end = _walls->end();
+	// Keep the first one on duplicate id, as the old linear search did
+	_objectsById.insert(std::make_pair(obj->getId(), obj));
+	if (obj->getType() == PLAYER)
+		_playersById.insert(std::make_pair(obj->getId(), std::dynamic_pointer_cast<Player>(obj)));
+}
 
-	while (it != end)
-	{
-		if ((*it)->getId() == id)
-			return (*it);
-		++it;
-	}
-	return NULL;
+void	MapUtils::unindexObject(const std::shared_ptr<AObject> &obj)
+{
+	auto found = _objectsById.find(obj->getId());
+	if (found != _objectsById.end() && found->second == obj)
+		_objectsById.erase(found);
+
+	auto foundPlayer = _playersById.find(obj->getId());
+	if (foundPlayer != _playersById.end() && foundPlayer->second == obj)
+		_playersById.erase(foundPlayer);
 }
 
 std::shared_ptr<AObject>		MapUtils::findObjectAtPosition(float x, float y)
@@ -930,32 +942,49 @@ std::shared_ptr<AObject>		MapUtils::findObjectAtPosition(float x, float y)
 	return NULL;
 }
 
-std::list<std::shared_ptr<AObject>>	*MapUtils::getElems(void)
+EntityStore<AObject>	*MapUtils::getElems(void)
 {
 	return _elems;
 }
 
-std::list<std::shared_ptr<Player>>	*MapUtils::getPlayers(void)
+EntityStore<Player>	*MapUtils::getPlayers(void)
 {
 	return _players;
 }
 
 
-std::list<std::shared_ptr<Bot>>		*MapUtils::getBots(void)
+EntityStore<Bot>		*MapUtils::getBots(void)
 {
 	return _bots;
 }
 
-std::list<std::shared_ptr<Turret>>	*MapUtils::getTurrets(void)
+EntityStore<Turret>	*MapUtils::getTurrets(void)
 {
 	return _turrets;
 }
 
-std::list<std::shared_ptr<Wall>>	*MapUtils::getWalls(void)
+EntityStore<Wall>	*MapUtils::getWalls(void)
 {
 	return _walls;
 }
 
+WallGrid	*MapUtils::getWallGrid(void)
+{
+	if (_wallGrid->isDirty())
+		_wallGrid->build(*_walls);
+	return _wallGrid;
+}
+
+ObjectGrid	*MapUtils::getObjectGrid(void)
+{
+	return _objectGrid;
+}
+
+HitboxHistory	*MapUtils::getHitboxHistory(void)
+{
+	return _hitboxHistory;
+}
+
 Flag* MapUtils::getFlag(int team)
 {
 	auto it = _elems->begin();
@@ -1105,19 +1134,6 @@ sf::Time MapUtils::getTimeRemaningOnMap()
 /////	Other funcs
 //////////////////////////////////////////////////////////////////////
 
-bool    sameAObject(std::pair<eventType, s_event> one, std::pair<eventType, s_event> two)
-{
-	if (one.second.trigger == two.second.trigger)
-		return true;
-	return false;
-}
-
-bool    superiorAddr(std::pair<eventType, s_event> one, std::pair<eventType, s_event> two)
-{
-	if (one.second.trigger > two.second.trigger)
-		return true;
-	return false;
-}
 
 //////////////////////////////////////////////////////////////////////
 /////	Get the number of player alive
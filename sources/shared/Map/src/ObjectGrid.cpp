@@ -0,0 +1,116 @@
+//
+// ObjectGrid.cpp for Void Clash
+//
+
+#include	<cmath>
+#include	<algorithm>
+#include	"ObjectGrid.hpp"
+
+ObjectGrid::ObjectGrid()
+{
+	_bucketStart.assign(OBJECT_GRID_BUCKETS + 1, 0);
+	std::fill(_maxRadius, _maxRadius + OBJECT_GRID_NB_TYPES, 0);
+}
+
+ObjectGrid::~ObjectGrid()
+{
+}
+
+///////////////////////////////////////////////
+/////   Build
+
+int		ObjectGrid::cell(float pos) const
+{
+	return static_cast<int>(std::floor(pos / OBJECT_GRID_CELL_SIZE));
+}
+
+unsigned int	ObjectGrid::bucket(int cellX, int cellY) const
+{
+	return (static_cast<unsigned int>(cellX) * 73856093u ^ static_cast<unsigned int>(cellY) * 19349663u)
+		& (OBJECT_GRID_BUCKETS - 1);
+}
+
+void	ObjectGrid::build(const EntityStore<AObject> &elems)
+{
+	std::fill(_bucketStart.begin(), _bucketStart.end(), 0);
+	std::fill(_maxRadius, _maxRadius + OBJECT_GRID_NB_TYPES, 0);
+	_entries.resize(elems.size());
+
+	// Count objects per bucket
+	unsigned int	index = 0;
+	std::vector<s_entry>::iterator	entry = _entries.begin();
+	for (EntityStore<AObject>::const_iterator it = elems.begin(); it != elems.end(); ++it)
+	{
+		const AObject	&obj = *(*it);
+		entry->object = &(*it);
+		entry->index = index++;
+		entry->cellX = cell(obj.getX());
+		entry->cellY = cell(obj.getY());
+		entry->typeMask = OBJ_MASK(obj.getType());
+		if (obj.getType() < OBJECT_GRID_NB_TYPES)
+			_maxRadius[obj.getType()] = std::max(_maxRadius[obj.getType()], obj.getRadius());
+		++_bucketStart[bucket(entry->cellX, entry->cellY) + 1];
+		++entry;
+	}
+	for (unsigned int i = 1; i <= OBJECT_GRID_BUCKETS; ++i)
+		_bucketStart[i] += _bucketStart[i - 1];
+
+	// Counting sort by bucket, stable so each bucket keeps map order
+	_sorted.resize(_entries.size());
+	_fill.assign(_bucketStart.begin(), _bucketStart.end() - 1);
+	for (entry = _entries.begin(); entry != _entries.end(); ++entry)
+		_sorted[_fill[bucket(entry->cellX, entry->cellY)]++] = *entry;
+	_entries.swap(_sorted);
+}
+
+void	ObjectGrid::clear()
+{
+	_entries.clear();
+	std::fill(_bucketStart.begin(), _bucketStart.end(), 0);
+}
+
+///////////////////////////////////////////////
+/////   Query
+
+static bool	mapOrder(const std::pair<unsigned int, const std::shared_ptr<AObject> *> &a,
+	const std::pair<unsigned int, const std::shared_ptr<AObject> *> &b)
+{
+	return a.first < b.first;
+}
+
+void	ObjectGrid::query(float x, float y, float radius, int typeMask,
+	std::vector<const std::shared_ptr<AObject> *> &result) const
+{
+	result.clear();
+	if (_entries.empty())
+		return;
+
+	int		maxRadius = 0;
+	for (int type = 0; type < OBJECT_GRID_NB_TYPES; ++type)
+		if (typeMask & OBJ_MASK(type))
+			maxRadius = std::max(maxRadius, _maxRadius[type]);
+	float	range = radius + 2 * maxRadius;
+
+	int		x0 = cell(x - range);
+	int		x1 = cell(x + range);
+	int		y0 = cell(y - range);
+	int		y1 = cell(y + range);
+
+	_found.clear();
+	for (int cy = y0; cy <= y1; ++cy)
+		for (int cx = x0; cx <= x1; ++cx)
+		{
+			unsigned int	b = bucket(cx, cy);
+			for (unsigned int i = _bucketStart[b]; i < _bucketStart[b + 1]; ++i)
+			{
+				const s_entry	&entry = _entries[i];
+				// Several cells may share a bucket
+				if (entry.cellX == cx && entry.cellY == cy && (entry.typeMask & typeMask))
+					_found.push_back(std::make_pair(entry.index, entry.object));
+			}
+		}
+	// Keep map order, first object hit must not depend on the grid
+	std::sort(_found.begin(), _found.end(), mapOrder);
+	for (unsigned int i = 0; i < _found.size(); ++i)
+		result.push_back(_found[i].second);
+}
@@ -0,0 +1,178 @@
+//
+// WallGrid.cpp for Void Clash
+//
+
+#include	<cmath>
+#include	<algorithm>
+#include	"WallGrid.hpp"
+
+WallGrid::WallGrid()
+{
+	_dirty = true;
+	_queryId = 0;
+	_originX = 0;
+	_originY = 0;
+	_cellSize = WALL_GRID_CELL_SIZE;
+	_width = 0;
+	_height = 0;
+	_maxWallRadius = 0;
+}
+
+WallGrid::~WallGrid()
+{
+}
+
+///////////////////////////////////////////////
+/////   Build
+
+void	WallGrid::build(const EntityStore<Wall> &walls)
+{
+	_dirty = false;
+	_walls.assign(walls.begin(), walls.end());
+	_cellStart.clear();
+	_cellWalls.clear();
+	_queryMark.assign(_walls.size(), 0);
+	_queryId = 0;
+	_width = 0;
+	_height = 0;
+	_maxWallRadius = 0;
+	if (_walls.empty())
+		return;
+
+	// Bounds of the map walls
+	float	minX = std::min(_walls[0]->getX(), _walls[0]->getEndX());
+	float	maxX = std::max(_walls[0]->getX(), _walls[0]->getEndX());
+	float	minY = std::min(_walls[0]->getY(), _walls[0]->getEndY());
+	float	maxY = std::max(_walls[0]->getY(), _walls[0]->getEndY());
+	for (unsigned int i = 0; i < _walls.size(); ++i)
+	{
+		const Wall	&wall = *_walls[i];
+		int			radius = wall.getRadius();
+
+		minX = std::min(minX, std::min(wall.getX(), wall.getEndX()) - radius);
+		maxX = std::max(maxX, std::max(wall.getX(), wall.getEndX()) + radius);
+		minY = std::min(minY, std::min(wall.getY(), wall.getEndY()) - radius);
+		maxY = std::max(maxY, std::max(wall.getY(), wall.getEndY()) + radius);
+		_maxWallRadius = std::max(_maxWallRadius, radius);
+	}
+
+	_originX = minX;
+	_originY = minY;
+	_cellSize = WALL_GRID_CELL_SIZE;
+	while ((maxX - minX) / _cellSize >= WALL_GRID_MAX_CELLS ||
+		(maxY - minY) / _cellSize >= WALL_GRID_MAX_CELLS)
+		_cellSize *= 2;
+	_width = static_cast<int>((maxX - minX) / _cellSize) + 1;
+	_height = static_cast<int>((maxY - minY) / _cellSize) + 1;
+
+	// First pass count walls per cell, second pass fill
+	_cellStart.assign(_width * _height + 1, 0);
+	for (int pass = 0; pass < 2; ++pass)
+	{
+		std::vector<unsigned int>	fill;
+		if (pass == 1)
+		{
+			for (unsigned int cell = 1; cell < _cellStart.size(); ++cell)
+				_cellStart[cell] += _cellStart[cell - 1];
+			_cellWalls.resize(_cellStart.back());
+			fill.assign(_cellStart.begin(), _cellStart.end() - 1);
+		}
+		for (unsigned int i = 0; i < _walls.size(); ++i)
+		{
+			const Wall	&wall = *_walls[i];
+			int			radius = wall.getRadius();
+			int			x0 = cellX(std::min(wall.getX(), wall.getEndX()) - radius);
+			int			x1 = cellX(std::max(wall.getX(), wall.getEndX()) + radius);
+			int			y0 = cellY(std::min(wall.getY(), wall.getEndY()) - radius);
+			int			y1 = cellY(std::max(wall.getY(), wall.getEndY()) + radius);
+
+			for (int y = y0; y <= y1; ++y)
+				for (int x = x0; x <= x1; ++x)
+				{
+					if (pass == 0)
+						++_cellStart[y * _width + x + 1];
+					else
+						_cellWalls[fill[y * _width + x]++] = i;
+				}
+		}
+	}
+}
+
+void	WallGrid::invalidate()
+{
+	_dirty = true;
+}
+
+bool	WallGrid::isDirty() const
+{
+	return _dirty;
+}
+
+///////////////////////////////////////////////
+/////   Query
+
+int		WallGrid::cellX(float x) const
+{
+	int	cell = static_cast<int>(std::floor((x - _originX) / _cellSize));
+	return std::max(0, std::min(_width - 1, cell));
+}
+
+int		WallGrid::cellY(float y) const
+{
+	int	cell = static_cast<int>(std::floor((y - _originY) / _cellSize));
+	return std::max(0, std::min(_height - 1, cell));
+}
+
+void	WallGrid::query(float minX, float minY, float maxX, float maxY, std::vector<unsigned int> &result)
+{
+	result.clear();
+	if (_width == 0 ||
+		maxX < _originX || maxY < _originY ||
+		minX > _originX + _width * _cellSize || minY > _originY + _height * _cellSize)
+		return;
+
+	if (++_queryId == 0)
+	{
+		std::fill(_queryMark.begin(), _queryMark.end(), 0);
+		_queryId = 1;
+	}
+
+	int	x0 = cellX(minX);
+	int	x1 = cellX(maxX);
+	int	y0 = cellY(minY);
+	int	y1 = cellY(maxY);
+	for (int y = y0; y <= y1; ++y)
+		for (int x = x0; x <= x1; ++x)
+		{
+			unsigned int	cell = y * _width + x;
+			for (unsigned int i = _cellStart[cell]; i < _cellStart[cell + 1]; ++i)
+			{
+				unsigned int	index = _cellWalls[i];
+				if (_queryMark[index] != _queryId)
+				{
+					_queryMark[index] = _queryId;
+					result.push_back(index);
+				}
+			}
+		}
+	// Keep map order, first wall hit must not depend on the grid
+	std::sort(result.begin(), result.end());
+}
+
+///////////////////////////////////////////////
+/////   Getterz
+
+const std::shared_ptr<Wall>	&WallGrid::getWall(unsigned int index) const
+{
+	return _walls[index];
+}
+
+unsigned int	WallGrid::getNbWalls() const
+{
+	return _walls.size();
+}
+
+int		WallGrid::getMaxWallRadius() const
+{
+	return _maxWallRadius;
+}
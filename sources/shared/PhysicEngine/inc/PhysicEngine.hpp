@@ -13,20 +13,16 @@
 
 #include	<SFML/System.hpp>
 #include	<list>
+#include	<vector>
 #include	"AEngine.hpp"
 #include	"AObject.hpp"
 #include	"Wall.hpp"
+#include	"WallGrid.hpp"
 #include	"Defines.h"
 
 class		Manager;
 
-// When a collision is detected, send a t_impact struct with event ev_WALL_COLLISION
-// Need to be deleted by graphic !
-typedef	struct	s_impact
-{
-	std::shared_ptr<Wall>	wall;
-	std::pair<float, float>pos;
-}				t_impact;
+// When a collision is detected, send its t_impact with event ev_WALL_COLLISION (EventComponent.hpp)
 
 #define OPTI_DISTANCE_MARGIN	1000;
 
@@ -44,6 +40,9 @@ public:
 	bool	initUpdatePhysObject(const std::shared_ptr<AObject> &obj);
 	bool	updatePhysObject(const std::shared_ptr<AObject> &obj, int level);
 
+	// One more step for this object only, no collision event
+	void	simulate(const std::shared_ptr<AObject> &obj, const sf::Time &deltaTime);
+
 	void	setDelta(const float &delta);
 	const float &getDelta();
 
@@ -75,11 +74,18 @@ private:
 private:
 
 
+	void	addWallCollision(const std::shared_ptr<AObject> &obj, const std::shared_ptr<Wall> &wall, float x, float y);
+
 	float _delta;
-	std::list<std::shared_ptr<Wall>>	_optiWalls;
+	bool	_simulating; // Steps replayed by the client prediction, already shown once
+	WallGrid					*_wallGrid;
+	std::vector<unsigned int>	_optiWalls; // Index in _wallGrid of walls close to the object
 };
 
+// Engine started on this thread (one per match on the server)
+extern VC_THREAD_LOCAL PhysicEngine	*GPhysicEngine;
+
 // This function is used for network simulation only
-void	simulateUpdatePhysObject(const std::shared_ptr<AObject> &obj);
+void	simulateUpdatePhysObject(const std::shared_ptr<AObject> &obj, const sf::Time &deltaTime);
 
 #endif		/* !__PHYSICENGINE_HPP__ */
@@ -16,22 +16,19 @@
 
 extern t_config *G_conf;
 
-PhysicEngine	*GPhysicEngine;
+VC_THREAD_LOCAL PhysicEngine	*GPhysicEngine = NULL;
 
-void	simulateUpdatePhysObject(const std::shared_ptr<AObject> &obj)
+void	simulateUpdatePhysObject(const std::shared_ptr<AObject> &obj, const sf::Time &deltaTime)
 {
-	GPhysicEngine->setDelta(S_Map->getCurrentPlayer()->getLatency() / 4.0f / 20000.0f / G_conf->game->speed);
-
-	if (GPhysicEngine->updatePhysObject(obj, 0))
-		obj->setPosition(obj->getX() + obj->getDirX() * GPhysicEngine->getDelta(),
-		obj->getY() + obj->getDirY() * GPhysicEngine->getDelta());
-
+	GPhysicEngine->simulate(obj, deltaTime);
 }
 
 //////////////////////////////////////////////////////////////////////
 
 PhysicEngine::PhysicEngine() :
-_delta(0.0)
+_delta(0.0),
+_simulating(false),
+_wallGrid(NULL)
 {
 }
 
@@ -59,7 +56,7 @@ eGameState	PhysicEngine::update(const sf::Time &deltaTime)
 	_delta = deltaTime.asMicroseconds() / 20000.0f / G_conf->game->speed;
 	if (_delta > 1.f)
 		_delta = 1.f;
-	for (std::list<std::shared_ptr<AObject>>::iterator it = S_Map->getElems()->begin(); it != S_Map->getElems()->end(); ++it)
+	for (EntityStore<AObject>::iterator it = S_Map->getElems()->begin(); it != S_Map->getElems()->end(); ++it)
 	{
 		regenerateOptiWalls(*it);
 
@@ -76,6 +73,9 @@ eGameState	PhysicEngine::update(const sf::Time &deltaTime)
 				ADD_EVENT(ev_DELETE, s_event(*it));
 		}
 	}
+
+	// Positions are final for this frame, index them for game engine queries
+	S_Map->getObjectGrid()->build(*S_Map->getElems());
 	return RUN;
 }
 
@@ -84,38 +84,45 @@ eGameState	PhysicEngine::update(const sf::Time &deltaTime)
 
 void	PhysicEngine::regenerateOptiWalls(const std::shared_ptr<AObject> & obj)
 {
-	_optiWalls.clear();
+	_wallGrid = S_Map->getWallGrid();
 
-	auto	it = S_Map->getWalls()->begin();
-	auto	end = S_Map->getWalls()->end();
 	float speed = sqrt(obj->getDirX() * obj->getDirX() + obj->getDirY() * obj->getDirY()) * _delta + 1.f;
+	int maxMargin = obj->getRadius() + _wallGrid->getMaxWallRadius() + speed;
+	_wallGrid->query(obj->getX() - maxMargin, obj->getY() - maxMargin,
+		obj->getX() + maxMargin, obj->getY() + maxMargin, _optiWalls);
+
+	// Exact test on each candidate, grid cells are larger than needed
+	auto	it = _optiWalls.begin();
+	auto	end = _optiWalls.end();
+	auto	kept = it;
 	while (it != end)
 	{
-		std::shared_ptr<Wall>wall = (*it);
-		int margin = obj->getRadius() + wall->getRadius() + speed;
+		const Wall	&wall = *_wallGrid->getWall(*it);
+		int margin = obj->getRadius() + wall.getRadius() + speed;
 		// Set X walls
-		int minX = wall->getX() - margin;
-		int maxX = wall->getEndX() + margin;
-		if (wall->getEndX() < wall->getX())
+		int minX = wall.getX() - margin;
+		int maxX = wall.getEndX() + margin;
+		if (wall.getEndX() < wall.getX())
 		{
-			minX = wall->getEndX() - margin;
-			maxX = wall->getX() + margin;
+			minX = wall.getEndX() - margin;
+			maxX = wall.getX() + margin;
 		}
 		// Set Y walls
-		int minY = wall->getY() - margin;
-		int maxY = wall->getEndY() + margin;
-		if (wall->getEndY() < wall->getY())
+		int minY = wall.getY() - margin;
+		int maxY = wall.getEndY() + margin;
+		if (wall.getEndY() < wall.getY())
 		{
-			minY = wall->getEndY() - margin;
-			maxY = wall->getY() + margin;
+			minY = wall.getEndY() - margin;
+			maxY = wall.getY() + margin;
 		}
 
-		// Fill optiWalls when obj is within rectangle
+		// Keep wall when obj is within rectangle
 		if (obj->getX() > minX && obj->getX() < maxX &&
 			obj->getY() > minY && obj->getY() < maxY)
-			_optiWalls.push_back(wall);
+			*kept++ = *it;
 		++it;
 	}
+	_optiWalls.erase(kept, end);
 }
 
 
@@ -248,14 +255,15 @@ bool	PhysicEngine::checkSegmentCircleCurrentPos(const std::shared_ptr<AObject> &
 	auto	end = _optiWalls.end();
 	while (it != end)
 	{
-		A.x = (*it)->getX();
-		A.y = (*it)->getY();
-		B.x = (*it)->getEndX();
-		B.y = (*it)->getEndY();
-		C.rayon = obj->getRadius() + (*it)->getRadius();
-		if (CollisionSegment(A, B, C, obj, *it))
+		const std::shared_ptr<Wall>	&wall = _wallGrid->getWall(*it);
+		A.x = wall->getX();
+		A.y = wall->getY();
+		B.x = wall->getEndX();
+		B.y = wall->getEndY();
+		C.rayon = obj->getRadius() + wall->getRadius();
+		if (CollisionSegment(A, B, C, obj, wall))
 		{
-			bounce(obj, *it);
+			bounce(obj, wall);
 			return true;
 		}
 		++it;
@@ -275,14 +283,15 @@ bool	PhysicEngine::checkSegmentCircle(const std::shared_ptr<AObject> &obj)
 	auto	end = _optiWalls.end();
 	while (it != end)
 	{
-		A.x = (*it)->getX();
-		A.y = (*it)->getY();
-		B.x = (*it)->getEndX();
-		B.y = (*it)->getEndY();
+		const std::shared_ptr<Wall>	&wall = _wallGrid->getWall(*it);
+		A.x = wall->getX();
+		A.y = wall->getY();
+		B.x = wall->getEndX();
+		B.y = wall->getEndY();
 		C.rayon = obj->getRadius();
-		if (CollisionSegment(A, B, C, obj, *it))
+		if (CollisionSegment(A, B, C, obj, wall))
 		{
-			bounce(obj, *it);
+			bounce(obj, wall);
 			return true;
 		}
 		++it;
@@ -310,10 +319,7 @@ bool PhysicEngine::CollisionSegment(Point A, Point B, Cercle C, const std::share
 		CenterCircle.x = obj->getX();
 		CenterCircle.y = obj->getY();
 		Point impact = ProjectionI(A, B, CenterCircle);
-		t_impact *toSend = new t_impact;
-		toSend->wall = wall;
-		toSend->pos = std::pair<float, float>(impact.x, impact.y);
-		ADD_EVENT(ev_WALL_COLLISION, s_event(obj, toSend));
+		addWallCollision(obj, wall, impact.x, impact.y);
 
 		float diff = std::sqrt(std::pow(obj->getX() - impact.x, 2) + std::pow(obj->getY() - impact.y, 2)) - C.rayon;
 		float speed = std::sqrt(std::pow(obj->getDirX(), 2) + std::pow(obj->getDirY(), 2));
@@ -326,18 +332,12 @@ bool PhysicEngine::CollisionSegment(Point A, Point B, Cercle C, const std::share
 	// dernière possibilité, A ou B dans le cercle
 	if (CollisionPointCercle(A, C))
 	{
-		t_impact *toSend = new t_impact;
-		toSend->wall = wall;
-		toSend->pos = std::pair<float, float>(A.x, A.y);
-		ADD_EVENT(ev_WALL_COLLISION, s_event(obj, toSend));
+		addWallCollision(obj, wall, A.x, A.y);
 		return true;
 	}
 	if (CollisionPointCercle(B, C))
 	{
-		t_impact *toSend = new t_impact;
-		toSend->wall = wall;
-		toSend->pos = std::pair<float, float>(B.x, B.y);
-		ADD_EVENT(ev_WALL_COLLISION, s_event(obj, toSend));
+		addWallCollision(obj, wall, B.x, B.y);
 		return true;
 	}
 	return false;
@@ -398,9 +398,10 @@ bool	PhysicEngine::checkSegmentSegment(const std::shared_ptr<AObject> &obj)
 	auto	end = _optiWalls.end();
 	while (it != end)
 	{
-		if (CollisionSegSeg(O, P, obj, *it))
+		const std::shared_ptr<Wall>	&wall = _wallGrid->getWall(*it);
+		if (CollisionSegSeg(O, P, obj, wall))
 		{
-			bounce(obj, *it);
+			bounce(obj, wall);
 			return true;
 		}
 		++it;
@@ -488,15 +489,45 @@ bool	PhysicEngine::CollisionSegSeg(Point O, Point P, const std::shared_ptr<AObje
 		obj->setPosition(obj->getX() + obj->getDirX() / speed * diff,
 			obj->getY() + obj->getDirY() / speed * diff);
 
-		t_impact *toSend = new t_impact;
-		toSend->wall = wall;
-		toSend->pos = std::pair<float, float>(i_x, i_y);
-		ADD_EVENT(ev_WALL_COLLISION, s_event(obj, toSend));
+		addWallCollision(obj, wall, i_x, i_y);
 		return true;
 	}
 	return false;
 }
 
+void	PhysicEngine::addWallCollision(const std::shared_ptr<AObject> &obj, const std::shared_ptr<Wall> &wall, float x, float y)
+{
+	if (_simulating)
+		return;
+
+	t_impact impact;
+	impact.wall = wall;
+	impact.pos = std::pair<float, float>(x, y);
+	ADD_EVENT(ev_WALL_COLLISION, s_event(obj, impact));
+}
+
+//////////////////////////////////////////////////////////////////////
+/////	Same as update, for one object and its own delta
+
+void	PhysicEngine::simulate(const std::shared_ptr<AObject> &obj, const sf::Time &deltaTime)
+{
+	float	delta = _delta;
+
+	_delta = deltaTime.asMicroseconds() / 20000.0f / G_conf->game->speed;
+	if (_delta > 1.f)
+		_delta = 1.f;
+	_simulating = true;
+	regenerateOptiWalls(obj);
+	if (updatePhysObject(obj, 0))
+	{
+		obj->setPrevFramePosition(obj->getX(), obj->getY());
+		obj->setPosition(obj->getX() + obj->getDirX() * _delta * (100 - obj->getSlow()) / 100,
+			obj->getY() + obj->getDirY() * _delta * (100 - obj->getSlow()) / 100);
+	}
+	_simulating = false;
+	_delta = delta;
+}
+
 //////////////////////////////////////////////////////////////////////
 
 void	PhysicEngine::setDelta(const float &delta)
@@ -93,7 +93,7 @@ void	SoundEngine_::start(void)
 
 eGameState	SoundEngine_::update(const sf::Time &time)
 {
-	std::list<std::pair<eventType, s_event> >::const_iterator it;
+	t_eventList::const_iterator it;
 	std::list<eventType> currentBuffer;
 
 	if (Event::getEventByType(ev_MUTE_SOUND))
@@ -126,7 +126,7 @@ void	SoundEngine_::stop(void)
 
 void	SoundEngine_::_updateDatabaseWithEvents()
 {
-	std::list<std::pair<eventType, s_event> >::const_iterator it;
+	t_eventList::const_iterator it;
 	std::list<eventType> currentBuffer;
 
 	for (it = Event::getMainEventList()->begin(); it != Event::getMainEventList()->end(); ++it)